@@ -1,2 +1,3 @@
 ./benchmarks/init.sh
 ./benchmarks/posting_list_view --time-limit 130 --overhead-limit 1.15 index
+./benchmarks/codecs --index-dir index --output codecs.csv
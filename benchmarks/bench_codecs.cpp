@@ -0,0 +1,438 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+//! Benchmarks all block codecs on real and synthetic posting lists.
+/*!
+ * For each list set and codec, the lists are written with
+ * `Standard_Block_List_Builder` and read with `Arena_Block_List`, and
+ * a row with the following fields is reported:
+ *  - bits per integer, including list headers,
+ *  - decoding throughput (millions of integers per second) of all blocks,
+ *  - `advance_to` throughput (millions of lookups per second) for sorted
+ *    random targets, as in conjunctive query processing (documents only),
+ *  - 50th, 90th, and 99th percentiles of the latency of decoding a single
+ *    block, which include the overhead of reading the clock.
+ *
+ * Real lists are sampled from an index by document frequency buckets.
+ * Synthetic document lists have either Zipfian gaps, or gaps that alternate
+ * between dense clusters and long jumps; their frequencies are Zipfian.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <CLI/CLI.hpp>
+#include <boost/filesystem.hpp>
+#include <nlohmann/json.hpp>
+
+#include <irkit/arena.hpp>
+#include <irkit/coding/adaptive.hpp>
+#include <irkit/coding/bitpacking.hpp>
+#include <irkit/coding/stream_vbyte.hpp>
+#include <irkit/coding/vbyte.hpp>
+#include <irkit/index.hpp>
+#include <irkit/index/source.hpp>
+#include <irkit/list/arena_block_list.hpp>
+#include <irkit/list/standard_block_list.hpp>
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+using value_type = std::int32_t;
+
+template<class T>
+using adaptive_codec = irk::adaptive_codec<T,
+                                           irk::stream_vbyte_codec<T>,
+                                           irk::bitpacking_codec<T>,
+                                           irk::vbyte_codec<T>>;
+
+template<class T>
+inline void do_not_optimize_away(T&& datum)
+{
+    asm volatile("" : "+r"(datum));  // NOLINT
+}
+
+template<class Fn>
+void for_each_codec(Fn&& fn)
+{
+    fn(irk::vbyte_codec<value_type>{}, "vbyte");
+    fn(irk::stream_vbyte_codec<value_type>{}, "stream_vbyte");
+    fn(irk::bitpacking_codec<value_type>{}, "bitpacking");
+    fn(adaptive_codec<value_type>{}, "adaptive");
+}
+
+struct List_Set {
+    std::string name;
+    std::vector<std::vector<value_type>> documents;
+    std::vector<std::vector<value_type>> frequencies;
+};
+
+struct Result {
+    std::string list_set;
+    std::string codec;
+    std::string list_type;
+    std::int64_t lists = 0;
+    std::int64_t postings = 0;
+    double bits_per_int = 0.0;
+    double decode_mints = 0.0;
+    std::optional<double> next_geq_mops{};
+    double block_p50_ns = 0.0;
+    double block_p90_ns = 0.0;
+    double block_p99_ns = 0.0;
+};
+
+//! Samples integers in [1, max_value] with probability proportional to 1 / x^exponent.
+class Zipf_Distribution {
+public:
+    Zipf_Distribution(value_type max_value, double exponent) : cdf_(max_value)
+    {
+        double sum = 0.0;
+        for (value_type value = 1; value <= max_value; ++value) {
+            sum += 1.0 / std::pow(value, exponent);
+            cdf_[value - 1] = sum;
+        }
+        for (auto& p : cdf_) {
+            p /= sum;
+        }
+    }
+
+    template<class Generator>
+    auto operator()(Generator& gen) const -> value_type
+    {
+        double p = std::uniform_real_distribution<double>(0.0, 1.0)(gen);
+        auto pos = std::lower_bound(cdf_.begin(), cdf_.end(), p);
+        return std::min<value_type>(std::distance(cdf_.begin(), pos) + 1, cdf_.size());
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+template<class GapFn>
+auto make_synthetic_lists(std::string name, int list_count, int length, std::mt19937& gen, GapFn gap)
+    -> List_Set
+{
+    Zipf_Distribution frequency(1000, 2.0);
+    List_Set lists{std::move(name), {}, {}};
+    for (int list = 0; list < list_count; ++list) {
+        std::vector<value_type> documents;
+        std::vector<value_type> frequencies;
+        value_type document = -1;
+        for (int idx = 0; idx < length; ++idx) {
+            document += gap(gen);
+            documents.push_back(document);
+            frequencies.push_back(frequency(gen));
+        }
+        lists.documents.push_back(std::move(documents));
+        lists.frequencies.push_back(std::move(frequencies));
+    }
+    return lists;
+}
+
+//! Samples up to `count` terms from each document frequency bucket of an index.
+auto sample_index(boost::filesystem::path const& dir, int count, std::mt19937& gen)
+    -> std::vector<List_Set>
+{
+    auto data = irk::Inverted_Index_Mapped_Source::from(dir);
+    irk::inverted_index_view index(data.value());
+    std::vector<value_type> bucket_bounds = {1, 100, 1'000, 10'000, 100'000};
+    std::vector<std::vector<irk::index::term_id_t>> buckets(bucket_bounds.size());
+    for (irk::index::term_id_t term_id = 0; term_id < index.term_count(); ++term_id) {
+        auto df = index.term_collection_frequency(term_id);
+        if (df == 0) {
+            continue;
+        }
+        auto bucket = std::upper_bound(bucket_bounds.begin(), bucket_bounds.end(), df)
+            - bucket_bounds.begin() - 1;
+        buckets[bucket].push_back(term_id);
+    }
+    std::vector<List_Set> list_sets;
+    for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        auto& term_ids = buckets[bucket];
+        if (term_ids.empty()) {
+            continue;
+        }
+        std::shuffle(term_ids.begin(), term_ids.end(), gen);
+        term_ids.resize(std::min<std::size_t>(term_ids.size(), count));
+        List_Set lists{"df>=" + std::to_string(bucket_bounds[bucket]), {}, {}};
+        for (auto term_id : term_ids) {
+            auto documents = index.documents(term_id);
+            auto frequencies = index.frequencies(term_id);
+            lists.documents.emplace_back(documents.begin(), documents.end());
+            lists.frequencies.emplace_back(frequencies.begin(), frequencies.end());
+        }
+        list_sets.push_back(std::move(lists));
+    }
+    return list_sets;
+}
+
+auto percentile(std::vector<double>& values, double p) -> double
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    auto nth = values.begin() + static_cast<std::ptrdiff_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+template<bool delta_encoded, class Codec>
+auto run(std::vector<std::vector<value_type>> const& lists,
+         Codec const& codec,
+         int block_size,
+         ir::Block_List_Options options,
+         int repeat,
+         double lookup_ratio,
+         std::mt19937& gen) -> Result
+{
+    using list_type = ir::Arena_Block_List<value_type, Codec, delta_encoded>;
+    Result result;
+    std::vector<std::string> encoded;
+    std::int64_t bytes = 0;
+    if constexpr (not delta_encoded) {
+        // Payload lists benchmarked here are not aligned with document lists.
+        options.variable_blocks = false;
+    }
+    for (auto const& values : lists) {
+        ir::Standard_Block_List_Builder<value_type, Codec, delta_encoded> builder(
+            block_size, codec, options);
+        for (auto value : values) {
+            builder.add(value);
+        }
+        std::ostringstream os;
+        bytes += builder.write(os);
+        encoded.push_back(os.str());
+        result.postings += values.size();
+    }
+    result.lists = lists.size();
+    result.bits_per_int = 8.0 * bytes / result.postings;
+
+    ir::Arena arena;
+    auto open = [&](std::size_t idx) {
+        return list_type(0,
+                         irk::make_memory_view(encoded[idx].data(), encoded[idx].size()),
+                         lists[idx].size(),
+                         arena);
+    };
+
+    auto best = nanoseconds::max();
+    for (int iteration = 0; iteration < repeat; ++iteration) {
+        auto start = steady_clock::now();
+        for (std::size_t idx = 0; idx < lists.size(); ++idx) {
+            auto list = open(idx);
+            for (std::int32_t block = 0; block < list.block_count(); ++block) {
+                value_type first = list.block(block)[0];
+                do_not_optimize_away(first);
+            }
+            arena.reset();
+        }
+        best = std::min(best, duration_cast<nanoseconds>(steady_clock::now() - start));
+    }
+    result.decode_mints = 1'000.0 * result.postings / best.count();
+
+    std::vector<double> latencies;
+    for (std::size_t idx = 0; idx < lists.size(); ++idx) {
+        auto list = open(idx);
+        for (std::int32_t block = 0; block < list.block_count(); ++block) {
+            auto start = steady_clock::now();
+            value_type first = list.block(block)[0];
+            do_not_optimize_away(first);
+            latencies.push_back(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+        }
+        arena.reset();
+    }
+    result.block_p50_ns = percentile(latencies, 0.5);
+    result.block_p90_ns = percentile(latencies, 0.9);
+    result.block_p99_ns = percentile(latencies, 0.99);
+
+    if constexpr (delta_encoded) {
+        std::vector<std::vector<value_type>> targets;
+        std::int64_t lookups = 0;
+        for (auto const& values : lists) {
+            std::uniform_int_distribution<value_type> target(values.front(), values.back());
+            auto count = std::max<std::size_t>(1, lookup_ratio * values.size());
+            std::vector<value_type> list_targets(count);
+            std::generate(list_targets.begin(), list_targets.end(), [&]() { return target(gen); });
+            std::sort(list_targets.begin(), list_targets.end());
+            lookups += list_targets.size();
+            targets.push_back(std::move(list_targets));
+        }
+        auto best = nanoseconds::max();
+        for (int iteration = 0; iteration < repeat; ++iteration) {
+            auto start = steady_clock::now();
+            for (std::size_t idx = 0; idx < lists.size(); ++idx) {
+                auto list = open(idx);
+                auto it = list.begin();
+                for (auto target : targets[idx]) {
+                    it.advance_to(target);
+                    auto found = *it;
+                    do_not_optimize_away(found);
+                }
+                arena.reset();
+            }
+            best = std::min(best, duration_cast<nanoseconds>(steady_clock::now() - start));
+        }
+        result.next_geq_mops = 1'000.0 * lookups / best.count();
+    }
+    return result;
+}
+
+void write_csv(std::ostream& out, std::vector<Result> const& results)
+{
+    out << "list_set,codec,list_type,lists,postings,bits_per_int,decode_mints,"
+           "next_geq_mops,block_p50_ns,block_p90_ns,block_p99_ns\n";
+    for (auto const& r : results) {
+        out << r.list_set << ',' << r.codec << ',' << r.list_type << ',' << r.lists << ','
+            << r.postings << ',' << r.bits_per_int << ',' << r.decode_mints << ',';
+        if (r.next_geq_mops) {
+            out << *r.next_geq_mops;
+        }
+        out << ',' << r.block_p50_ns << ',' << r.block_p90_ns << ',' << r.block_p99_ns << '\n';
+    }
+}
+
+void write_json(std::ostream& out, std::vector<Result> const& results)
+{
+    nlohmann::json rows = nlohmann::json::array();
+    for (auto const& r : results) {
+        rows.push_back({{"list_set", r.list_set},
+                        {"codec", r.codec},
+                        {"list_type", r.list_type},
+                        {"lists", r.lists},
+                        {"postings", r.postings},
+                        {"bits_per_int", r.bits_per_int},
+                        {"decode_mints", r.decode_mints},
+                        {"next_geq_mops", r.next_geq_mops ? nlohmann::json(*r.next_geq_mops)
+                                                          : nlohmann::json()},
+                        {"block_p50_ns", r.block_p50_ns},
+                        {"block_p90_ns", r.block_p90_ns},
+                        {"block_p99_ns", r.block_p99_ns}});
+    }
+    out << std::setw(4) << rows << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::string index_dir;
+    bool json = false;
+    std::string output;
+    int terms_per_bucket = 100;
+    int synthetic_lists = 200;
+    int synthetic_length = 10'000;
+    int block_size = 64;
+    int repeat = 3;
+    double lookup_ratio = 0.1;
+    int seed = 987654321;
+    ir::Block_List_Options options{};
+
+    CLI::App app{"Block codec benchmark"};
+    app.add_option("--index-dir", index_dir, "Index to sample real lists from", false)
+        ->check(CLI::ExistingDirectory);
+    app.add_option("--terms-per-bucket",
+                   terms_per_bucket,
+                   "Number of terms sampled per document frequency bucket",
+                   true);
+    app.add_option("--synthetic-lists", synthetic_lists, "Number of lists per synthetic set", true);
+    app.add_option("--synthetic-length", synthetic_length, "Length of synthetic lists", true);
+    app.add_option("--block-size", block_size, "List block size", true);
+    app.add_flag("--variable-blocks", options.variable_blocks, "Partition document lists");
+    app.add_flag("--fixed-width", options.fixed_width, "Write fixed-width list headers");
+    app.add_option("--repeat", repeat, "Repetitions of throughput measurements", true);
+    app.add_option("--lookup-ratio",
+                   lookup_ratio,
+                   "Number of advance_to targets relative to list length",
+                   true);
+    app.add_option("--seed", seed, "Random seed", true);
+    app.add_flag("--json", json, "Write JSON instead of CSV");
+    app.add_option("--output,-o", output, "Output file (standard output by default)", false);
+    CLI11_PARSE(app, argc, argv);
+
+    std::mt19937 gen(seed);
+    std::vector<List_Set> list_sets;
+    if (not index_dir.empty()) {
+        list_sets = sample_index(index_dir, terms_per_bucket, gen);
+    }
+    Zipf_Distribution zipf_gap(1 << 16, 1.1);
+    list_sets.push_back(make_synthetic_lists(
+        "zipfian", synthetic_lists, synthetic_length, gen, [&](auto& g) { return zipf_gap(g); }));
+    // Clusters of close documents separated by long jumps.
+    std::bernoulli_distribution jump(0.02);
+    std::uniform_int_distribution<value_type> cluster_gap(1, 4);
+    std::uniform_int_distribution<value_type> jump_gap(1'000, 100'000);
+    list_sets.push_back(make_synthetic_lists(
+        "clustered", synthetic_lists, synthetic_length, gen, [&](auto& g) {
+            return jump(g) ? jump_gap(g) : cluster_gap(g);
+        }));
+
+    std::vector<Result> results;
+    for (auto const& lists : list_sets) {
+        for_each_codec([&](auto const& codec, std::string const& name) {
+            for (auto [list_type, result] :
+                 {std::pair("documents",
+                            run<true>(lists.documents,
+                                      codec,
+                                      block_size,
+                                      options,
+                                      repeat,
+                                      lookup_ratio,
+                                      gen)),
+                  std::pair("frequencies",
+                            run<false>(lists.frequencies,
+                                       codec,
+                                       block_size,
+                                       options,
+                                       repeat,
+                                       lookup_ratio,
+                                       gen))}) {
+                result.list_set = lists.name;
+                result.codec = name;
+                result.list_type = list_type;
+                results.push_back(result);
+            }
+        });
+    }
+
+    std::ofstream file;
+    if (not output.empty()) {
+        file.open(output);
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+    if (json) {
+        write_json(out, results);
+    } else {
+        write_csv(out, results);
+    }
+    return 0;
+}
@@ -27,6 +27,7 @@
 #include <algorithm>
 #include <bitset>
 #include <chrono>
+#include <numeric>
 #include <random>
 #include <string>
 #include <vector>
@@ -101,5 +102,43 @@ int main(int argc, char** argv)
     std::cout << "Decoding: " << 1'000 / decode_ns_per_int << " mln int/s"
               << std::endl;
 
-    return 0;
+    // Compares per-value vbyte decoding (iterator input) to bulk decoding
+    // (contiguous pointer input), which is vectorized when SSE4.1 is enabled.
+    irk::vbyte_codec<std::uint32_t> vbyte;
+    std::vector<char> encoded(vbyte.max_encoded_size(count));
+    std::vector<char> delta_encoded(vbyte.max_encoded_size(count));
+    vbyte.encode(
+        std::begin(random_numbers), std::end(random_numbers), encoded.begin());
+    vbyte.delta_encode(
+        std::begin(random_numbers),
+        std::end(random_numbers),
+        delta_encoded.begin());
+    auto report = [&](const std::string& name, auto decode_fn) {
+        std::fill(decoded.begin(), decoded.end(), 0);
+        auto start = steady_clock::now();
+        decode_fn();
+        auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+        if (decoded != random_numbers) {
+            std::cout << name << ": decoding error" << std::endl;
+            return false;
+        }
+        auto ns_per_int = static_cast<double>(elapsed.count()) / count;
+        std::cout << name << ": " << ns_per_int << " ns/int, "
+                  << 1'000 / ns_per_int << " mln int/s" << std::endl;
+        return true;
+    };
+    bool ok = report("VByte decoding (scalar)", [&]() {
+        vbyte.decode(encoded.begin(), decoded.begin(), count);
+    });
+    ok &= report("VByte decoding (bulk)", [&]() {
+        vbyte.decode(encoded.data(), decoded.data(), count);
+    });
+    ok &= report("VByte delta decoding (scalar)", [&]() {
+        vbyte.delta_decode(delta_encoded.begin(), decoded.begin(), count);
+    });
+    ok &= report("VByte delta decoding (bulk)", [&]() {
+        vbyte.delta_decode(delta_encoded.data(), decoded.data(), count);
+    });
+
+    return ok ? 0 : 1;
 }
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 
@@ -33,6 +34,7 @@
 #include <gsl/span>
 
 #include <irkit/algorithm/transform.hpp>
+#include <irkit/index/raw_inverted_list.hpp>
 #include <irkit/io.hpp>
 #include <irkit/movingrange.hpp>
 #include <irkit/parsing/stemmer.hpp>
@@ -224,6 +226,52 @@ auto daat(gsl::span<const T> postings, gsl::span<const F> score_fns, int k)
         });
 }
 
+/// Merges posting lists into a single list, summing payloads per document.
+///
+/// This is meant for expanded query terms, such as all terms matching a
+/// wildcard, which can be too many to merge with a heap. Instead, payloads are
+/// summed in a dense accumulator, and the touched documents are either sorted
+/// or, if there are many of them, collected with a sequential scan.
+///
+/// \returns Postings with distinct documents, in increasing document order
+template<class T>
+// requires PostingList<T>
+auto union_postings(gsl::span<const T> postings, std::ptrdiff_t collection_size)
+{
+    using document_type = detail::document_type<decltype(*postings.begin())>;
+    using payload_type = std::decay_t<
+        decltype(std::declval<T>().begin()->payload())>;
+    std::vector<payload_type> acc(collection_size);
+    std::vector<bool> touched(collection_size, false);
+    std::vector<document_type> documents;
+    for (const auto& posting_list : postings) {
+        for (const auto posting : posting_list) {
+            auto doc = posting.document();
+            if (not touched[doc]) {
+                touched[doc] = true;
+                documents.push_back(doc);
+            }
+            acc[doc] += posting.payload();
+        }
+    }
+    if (static_cast<std::ptrdiff_t>(documents.size()) > collection_size / 16) {
+        documents.clear();
+        for (std::ptrdiff_t doc = 0; doc < collection_size; ++doc) {
+            if (touched[doc]) {
+                documents.push_back(static_cast<document_type>(doc));
+            }
+        }
+    } else {
+        std::sort(documents.begin(), documents.end());
+    }
+    std::vector<irk::raw_posting<document_type, payload_type>> merged;
+    merged.reserve(documents.size());
+    for (auto doc : documents) {
+        merged.emplace_back(doc, acc[doc]);
+    }
+    return merged;
+}
+
 void for_each_query(std::istream& input,
                     bool stem,
                     std::function<void(int, gsl::span<std::string const>)> f)
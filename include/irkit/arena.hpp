@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include <gsl/span>
+
+namespace ir {
+
+//! A bump allocator of 64-byte aligned scratch memory.
+/*!
+ * Memory is handed out from large chunks, and released all at once with
+ * `reset()`, which keeps the chunks for reuse. Thus, once an arena has grown
+ * to accommodate a workload (e.g., the lists of a query), processing the same
+ * workload again does not allocate on the heap.
+ *
+ * Only trivially destructible objects can be allocated, as no destructors
+ * are ever called.
+ */
+class Arena {
+public:
+    static constexpr std::size_t alignment = 64;
+    static constexpr std::size_t default_chunk_size = std::size_t{1} << 20u;
+
+    explicit Arena(std::size_t chunk_size = default_chunk_size) : chunk_size_(chunk_size) {}
+    Arena(Arena const&) = delete;
+    Arena(Arena&&) noexcept = default;
+    Arena& operator=(Arena const&) = delete;
+    Arena& operator=(Arena&&) noexcept = default;
+    ~Arena() = default;
+
+    //! Returns uninitialized, aligned memory for `count` objects.
+    template<class T>
+    [[nodiscard]] auto allocate(std::ptrdiff_t count) -> gsl::span<T>
+    {
+        static_assert(std::is_trivially_destructible_v<T>);
+        static_assert(alignof(T) <= alignment);
+        auto bytes = aligned_size(count * sizeof(T));
+        if (current_ == chunks_.size() || offset_ + bytes > chunks_[current_].size) {
+            next_chunk(bytes);
+        }
+        auto ptr = chunks_[current_].data.get() + offset_;
+        offset_ += bytes;
+        used_ += bytes;
+        return gsl::make_span(reinterpret_cast<T*>(ptr), count);
+    }
+
+    //! Allocates memory for `count` objects and fills it with `value`.
+    template<class T>
+    [[nodiscard]] auto allocate(std::ptrdiff_t count, T const& value) -> gsl::span<T>
+    {
+        auto memory = allocate<T>(count);
+        std::fill(memory.begin(), memory.end(), value);
+        return memory;
+    }
+
+    //! Releases all allocated memory, but keeps the chunks for reuse.
+    void reset() noexcept
+    {
+        current_ = 0;
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    //! Number of bytes allocated since the last reset, including padding.
+    [[nodiscard]] auto used() const noexcept -> std::size_t { return used_; }
+
+    //! Number of bytes in all chunks.
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t
+    {
+        std::size_t capacity = 0;
+        for (auto const& chunk : chunks_) {
+            capacity += chunk.size;
+        }
+        return capacity;
+    }
+
+private:
+    struct Aligned_Delete {
+        void operator()(std::byte* ptr) const noexcept
+        {
+            ::operator delete(ptr, std::align_val_t{alignment});
+        }
+    };
+
+    struct Chunk {
+        std::unique_ptr<std::byte, Aligned_Delete> data;
+        std::size_t size;
+    };
+
+    [[nodiscard]] static constexpr auto aligned_size(std::size_t size) -> std::size_t
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    //! Moves to the first of the following chunks that fits `bytes`, or allocates one.
+    void next_chunk(std::size_t bytes)
+    {
+        offset_ = 0;
+        current_ = chunks_.empty() ? 0 : current_ + 1;
+        for (; current_ < chunks_.size(); ++current_) {
+            if (chunks_[current_].size >= bytes) {
+                return;
+            }
+        }
+        auto size = std::max(aligned_size(chunk_size_), bytes);
+        auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t{alignment}));
+        chunks_.push_back(Chunk{std::unique_ptr<std::byte, Aligned_Delete>(data), size});
+        current_ = chunks_.size() - 1;
+    }
+
+    std::size_t chunk_size_;
+    std::vector<Chunk> chunks_{};
+    std::size_t current_ = 0;
+    std::size_t offset_ = 0;
+    std::size_t used_ = 0;
+};
+
+//! Returns the arena of the calling thread, meant to be reset after each query.
+inline auto thread_arena() -> Arena&
+{
+    thread_local Arena arena;
+    return arena;
+}
+
+}  // namespace ir
@@ -26,8 +26,12 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
+#include <irkit/assert.hpp>
+
 namespace irk {
 
 //! An input stream reading bits.
@@ -57,6 +61,67 @@ public:
     void clear_buffer() { buffered_pos_ = 8; }
 };
 
+//! An input stream reading bits directly from a memory buffer.
+/*!
+ * Reads the same bit order as `input_bit_stream` (least significant bit of
+ * each byte first), but without going through `std::istream`. Besides
+ * reading a bit at a time, it can peek at up to 56 bits at once, which
+ * allows table-driven decoders to consume several bits per step.
+ */
+class memory_bit_stream {
+public:
+    static constexpr int max_peek_bits = 56;
+
+    memory_bit_stream(const char* data, std::ptrdiff_t size)
+        : data_(reinterpret_cast<const unsigned char*>(data)),
+          size_(size),
+          bit_count_(size * 8)
+    {}
+
+    //! Returns bit: 0 or 1, or -1 if no bit could be read.
+    std::int8_t read()
+    {
+        if (position_ >= bit_count_) { return -1; }
+        auto bit = (data_[position_ >> 3u] >> (position_ & 7u)) & 1u;
+        ++position_;
+        return static_cast<std::int8_t>(bit);
+    }
+
+    //! Returns the next `n` bits without consuming them.
+    /*!
+     * The first bit of the stream is the least significant bit of the result.
+     * Bits past the end of the buffer are read as zeros.
+     */
+    std::uint64_t peek(int n) const
+    {
+        EXPECTS(n <= max_peek_bits);
+        auto byte = position_ >> 3u;
+        std::uint64_t word = 0;
+        if (byte + 8 <= size_) {
+            std::memcpy(&word, data_ + byte, sizeof(word));
+        } else if (byte < size_) {
+            std::memcpy(&word, data_ + byte, size_ - byte);
+        }
+        word >>= (position_ & 7u);
+        return word & ((std::uint64_t{1} << n) - 1u);
+    }
+
+    //! Consumes `n` bits.
+    void skip(std::ptrdiff_t n) { position_ += n; }
+
+    //! Returns the number of bits that have not been read yet.
+    std::ptrdiff_t remaining() const
+    {
+        return position_ < bit_count_ ? bit_count_ - position_ : 0;
+    }
+
+private:
+    const unsigned char* data_;
+    std::ptrdiff_t size_;
+    std::ptrdiff_t bit_count_;
+    std::ptrdiff_t position_ = 0;
+};
+
 //! An output stream writing bits.
 class output_bit_stream {
 protected:
@@ -0,0 +1,402 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <unistd.h>
+
+#include <irkit/assert.hpp>
+#include <irkit/io.hpp>
+#include <irkit/memoryview.hpp>
+
+namespace irk {
+
+//! Hit and miss counts of a `block_cache`.
+struct block_cache_statistics {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    //! Blocks inserted ahead of time by a prefetcher.
+    std::uint64_t prefetched = 0;
+
+    [[nodiscard]] auto hit_rate() const -> double
+    {
+        auto lookups = hits + misses;
+        return lookups > 0 ? static_cast<double>(hits) / lookups : 0.0;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, block_cache_statistics const& stats)
+{
+    return os << fmt::format(
+               "hits: {} misses: {} evictions: {} prefetched: {} hit rate: {:.4f}",
+               stats.hits,
+               stats.misses,
+               stats.evictions,
+               stats.prefetched,
+               stats.hit_rate());
+}
+
+//! A bounded cache of fixed-size file blocks read with `pread`.
+/*!
+ * Blocks are distributed over independently locked shards, each evicting
+ * with the CLOCK algorithm: a block is marked when hit, and the clock hand
+ * evicts the first unmarked block, clearing marks as it passes.
+ *
+ * Blocks are shared pointers, so an evicted block stays valid for as long as
+ * someone reads it; the cache only bounds the memory it holds itself.
+ */
+class block_cache {
+public:
+    using block_pointer = std::shared_ptr<const std::vector<char>>;
+    static constexpr std::size_t default_block_size = 64 * 1024;
+    static constexpr std::size_t default_shard_count = 16;
+
+    //! \param capacity     maximum total size of cached blocks in bytes
+    //! \param block_size   size of a single block in bytes
+    //! \param shard_count  number of independently locked shards
+    explicit block_cache(std::size_t capacity,
+                         std::size_t block_size = default_block_size,
+                         std::size_t shard_count = default_shard_count)
+        : block_size_(block_size), shards_(shard_count)
+    {
+        EXPECTS(block_size > 0);
+        EXPECTS(shard_count > 0);
+        auto blocks_per_shard = std::max<std::size_t>(1, capacity / block_size / shard_count);
+        for (auto& shard : shards_) {
+            shard.capacity = blocks_per_shard;
+        }
+    }
+
+    [[nodiscard]] auto block_size() const -> std::size_t { return block_size_; }
+
+    //! Maximum total size of cached blocks in bytes.
+    [[nodiscard]] auto capacity() const -> std::size_t
+    {
+        return shards_.size() * shards_.front().capacity * block_size_;
+    }
+
+    //! Returns block `block` of the file open as `fd`, of `file_size` bytes.
+    /*!
+     * The last block of a file is shorter than `block_size()`.
+     * `file_id` must uniquely identify the file within this cache.
+     *
+     * \throws std::runtime_error   if reading the file fails
+     */
+    [[nodiscard]] auto
+    block(std::uint64_t file_id, int fd, std::uint64_t file_size, std::uint64_t block)
+        -> block_pointer
+    {
+        key_type key{file_id, block};
+        auto& shard = shards_[key_hash{}(key) % shards_.size()];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (auto pos = shard.index.find(key); pos != shard.index.end()) {
+                auto& slot = shard.slots[pos->second];
+                slot.referenced = true;
+                ++shard.stats.hits;
+                return slot.data;
+            }
+            ++shard.stats.misses;
+        }
+        // Reading without the lock lets other lookups in the shard proceed;
+        // a block read concurrently by two threads is inserted only once.
+        auto data = read_block(fd, file_size, block);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (auto pos = shard.index.find(key); pos != shard.index.end()) {
+            return shard.slots[pos->second].data;
+        }
+        shard.insert(key, data);
+        return data;
+    }
+
+    //! Whether a block is cached; does not count as a lookup.
+    [[nodiscard]] auto contains(std::uint64_t file_id, std::uint64_t block) const -> bool
+    {
+        key_type key{file_id, block};
+        auto const& shard = shards_[key_hash{}(key) % shards_.size()];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.index.count(key) > 0;
+    }
+
+    //! Inserts a block read ahead of time, unless it is already cached.
+    void insert(std::uint64_t file_id, std::uint64_t block, block_pointer data)
+    {
+        key_type key{file_id, block};
+        auto& shard = shards_[key_hash{}(key) % shards_.size()];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.index.count(key) == 0) {
+            shard.insert(key, std::move(data));
+            ++shard.stats.prefetched;
+        }
+    }
+
+    //! Returns a new unique file ID.
+    [[nodiscard]] auto register_file() -> std::uint64_t
+    {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        return next_file_id_++;
+    }
+
+    //! Sums the statistics of all shards.
+    [[nodiscard]] auto statistics() const -> block_cache_statistics
+    {
+        block_cache_statistics stats;
+        for (auto const& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            stats.hits += shard.stats.hits;
+            stats.misses += shard.stats.misses;
+            stats.evictions += shard.stats.evictions;
+            stats.prefetched += shard.stats.prefetched;
+        }
+        return stats;
+    }
+
+private:
+    struct key_type {
+        std::uint64_t file;
+        std::uint64_t block;
+        bool operator==(key_type const& other) const
+        {
+            return file == other.file && block == other.block;
+        }
+    };
+
+    struct key_hash {
+        std::size_t operator()(key_type const& key) const
+        {
+            auto h = key.block * 0x9e3779b97f4a7c15ULL + key.file;
+            return static_cast<std::size_t>(h ^ (h >> 29u));
+        }
+    };
+
+    struct slot {
+        key_type key;
+        block_pointer data;
+        bool referenced;
+    };
+
+    struct shard_type {
+        mutable std::mutex mutex{};
+        std::size_t capacity = 1;
+        std::vector<slot> slots{};
+        std::unordered_map<key_type, std::size_t, key_hash> index{};
+        std::size_t hand = 0;
+        block_cache_statistics stats{};
+
+        void insert(key_type key, block_pointer data)
+        {
+            if (slots.size() < capacity) {
+                index.emplace(key, slots.size());
+                slots.push_back({key, std::move(data), false});
+                return;
+            }
+            while (slots[hand].referenced) {
+                slots[hand].referenced = false;
+                hand = (hand + 1) % slots.size();
+            }
+            index.erase(slots[hand].key);
+            index.emplace(key, hand);
+            slots[hand] = {key, std::move(data), false};
+            hand = (hand + 1) % slots.size();
+            ++stats.evictions;
+        }
+    };
+
+    [[nodiscard]] auto
+    read_block(int fd, std::uint64_t file_size, std::uint64_t block) const -> block_pointer
+    {
+        std::uint64_t offset = block * block_size_;
+        EXPECTS(offset < file_size);
+        auto size = std::min<std::uint64_t>(block_size_, file_size - offset);
+        auto data = std::make_shared<std::vector<char>>(size);
+        std::uint64_t done = 0;
+        while (done < size) {
+            auto count = ::pread(fd, data->data() + done, size - done, offset + done);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                throw std::runtime_error(fmt::format(
+                    "failed to read block {}: {}",
+                    block,
+                    count < 0 ? std::strerror(errno) : "unexpected end of file"));
+            }
+            done += count;
+        }
+        return data;
+    }
+
+    std::size_t block_size_;
+    std::vector<shard_type> shards_;
+    std::mutex file_mutex_{};
+    std::uint64_t next_file_id_ = 0;
+};
+
+//! A file opened for reading through a `block_cache`.
+class cached_file {
+public:
+    cached_file(boost::filesystem::path const& file_path, std::shared_ptr<block_cache> cache)
+        : path_(file_path), cache_(std::move(cache)), id_(cache_->register_file())
+    {
+        io::enforce_exist(file_path);
+        fd_ = ::open(file_path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error(fmt::format(
+                "failed to open {}: {}", file_path.string(), std::strerror(errno)));
+        }
+        size_ = boost::filesystem::file_size(file_path);
+    }
+    cached_file(cached_file const&) = delete;
+    cached_file(cached_file&&) = delete;
+    cached_file& operator=(cached_file const&) = delete;
+    cached_file& operator=(cached_file&&) = delete;
+    ~cached_file() { ::close(fd_); }
+
+    [[nodiscard]] auto size() const -> std::uint64_t { return size_; }
+    [[nodiscard]] auto path() const -> boost::filesystem::path const& { return path_; }
+    [[nodiscard]] auto cache() const -> block_cache& { return *cache_; }
+    [[nodiscard]] auto id() const -> std::uint64_t { return id_; }
+    [[nodiscard]] auto fd() const -> int { return fd_; }
+
+    //! Returns the offset and size of block `block` of this file.
+    [[nodiscard]] auto block_extent(std::uint64_t block) const
+        -> std::pair<std::uint64_t, std::uint64_t>
+    {
+        auto offset = block * cache_->block_size();
+        EXPECTS(offset < size_);
+        return {offset, std::min<std::uint64_t>(cache_->block_size(), size_ - offset)};
+    }
+
+    //! Returns the bytes [offset, offset + size) of the file.
+    /*!
+     * If the range lies within a single block, the returned pointer shares
+     * the cached block; otherwise, the blocks are copied to a new buffer.
+     * The second element points to the beginning of the range.
+     */
+    [[nodiscard]] auto read(std::uint64_t offset, std::uint64_t size) const
+        -> std::pair<block_cache::block_pointer, const char*>
+    {
+        EXPECTS(offset + size <= size_);
+        if (size == 0) {
+            return {nullptr, nullptr};
+        }
+        auto block_size = cache_->block_size();
+        auto first = offset / block_size;
+        auto last = (offset + size - 1) / block_size;
+        if (first == last) {
+            auto block = cache_->block(id_, fd_, size_, first);
+            return {block, block->data() + (offset - first * block_size)};
+        }
+        auto buffer = std::make_shared<std::vector<char>>(size);
+        auto out = buffer->data();
+        for (auto idx = first; idx <= last; ++idx) {
+            auto block = cache_->block(id_, fd_, size_, idx);
+            auto begin = std::max(offset, idx * block_size) - idx * block_size;
+            auto end = std::min(offset + size - idx * block_size, block->size());
+            out = std::copy(block->data() + begin, block->data() + end, out);
+        }
+        return {buffer, buffer->data()};
+    }
+
+private:
+    boost::filesystem::path path_;
+    std::shared_ptr<block_cache> cache_;
+    std::uint64_t id_;
+    int fd_ = -1;
+    std::uint64_t size_ = 0;
+};
+
+//! A memory source reading a file through a `block_cache`.
+/*!
+ * Ranges are read as soon as they are created, so that a posting list
+ * fetches its bytes once, and sub-ranges share them without going back
+ * to the cache. Accessing the data of an entire file reads all of it;
+ * this is only meant for tools that copy whole lists, not for query
+ * processing.
+ */
+class cached_file_memory_source {
+public:
+    using char_type = char;
+
+    cached_file_memory_source() = default;
+    explicit cached_file_memory_source(std::shared_ptr<const cached_file> file)
+        : file_(std::move(file)),
+          size_(file_->size()),
+          whole_file_(std::make_shared<whole_file_type>())
+    {}
+
+    [[nodiscard]] auto data() const -> const char*
+    {
+        std::call_once(whole_file_->loaded, [this]() {
+            whole_file_->data = file_->read(0, size_);
+        });
+        return whole_file_->data.second;
+    }
+
+    [[nodiscard]] auto size() const -> std::ptrdiff_t { return size_; }
+
+    [[nodiscard]] auto operator[](std::ptrdiff_t n) const -> const char& { return data()[n]; }
+
+    [[nodiscard]] auto range(std::ptrdiff_t first, std::ptrdiff_t size) const
+        -> shared_memory_source
+    {
+        EXPECTS(first >= 0 && first + size <= size_);
+        auto [holder, data] = file_->read(first, size);
+        if (holder == nullptr) {
+            return shared_memory_source{};
+        }
+        auto offset = data - holder->data();
+        return shared_memory_source(std::move(holder), offset, size);
+    }
+
+private:
+    struct whole_file_type {
+        std::once_flag loaded{};
+        std::pair<block_cache::block_pointer, const char*> data{};
+    };
+
+    std::shared_ptr<const cached_file> file_{};
+    std::ptrdiff_t size_ = 0;
+    std::shared_ptr<whole_file_type> whole_file_{};
+};
+
+}  // namespace irk
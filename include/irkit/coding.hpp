@@ -86,7 +86,7 @@ std::vector<typename Codec::value_type>
 decode(const Codec& codec, InputIterator in, int count)
 {
     std::vector<typename Codec::value_type> data(count);
-    codec.decode(in, std::begin(data), count);
+    codec.decode(in, data.data(), count);
     return data;
 }
 
@@ -97,7 +97,7 @@ std::vector<typename Codec::value_type> delta_decode(const Codec& codec,
     typename Codec::value_type initial = typename Codec::value_type())
 {
     std::vector<typename Codec::value_type> data(count);
-    codec.delta_decode(in, std::begin(data), count, initial);
+    codec.delta_decode(in, data.data(), count, initial);
     return data;
 }
 
@@ -0,0 +1,169 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <gsl/span>
+
+namespace irk {
+
+//! A set of codecs, one of which is selected for each encoded sequence.
+/*!
+ * The set itself implements the regular codec interface by delegating to
+ * the first (primary) codec. Additionally, it can dispatch to any of its
+ * codecs by a tag, which is the position of the codec in `Codecs`.
+ * The caller is responsible for storing the tag along with the encoded data;
+ * see `ir::Standard_Block_List_Builder`.
+ *
+ * Codecs should be listed from the fastest to decode to the slowest:
+ * \ref select() prefers earlier codecs whose encoded size is within
+ * the configured slack of the smallest one.
+ */
+template<class T, class... Codecs>
+struct adaptive_codec {
+    static_assert(sizeof...(Codecs) > 0, "at least one codec required");
+    using value_type = T;
+    using tag_type = std::int32_t;
+    using codecs_type = std::tuple<Codecs...>;
+    using primary_codec_type = std::tuple_element_t<0, codecs_type>;
+    static constexpr tag_type codec_count = sizeof...(Codecs);
+
+    adaptive_codec() = default;
+
+    //! \param slack    relative size overhead (e.g., 0.1 for 10%) accepted
+    //!                 in order to use a codec that is faster to decode
+    explicit adaptive_codec(double slack) : slack_(slack) {}
+
+    std::ptrdiff_t
+    max_encoded_size(int count, std::optional<T> max_value = std::nullopt) const
+    {
+        std::ptrdiff_t size = 0;
+        for_each_codec([&](tag_type, auto const& codec) {
+            size = std::max(size, codec.max_encoded_size(count, max_value));
+        });
+        return size;
+    }
+
+    template<class InputIterator, class OutputIterator>
+    std::ptrdiff_t
+    encode(InputIterator lo, InputIterator hi, OutputIterator out) const
+    {
+        return primary().encode(lo, hi, out);
+    }
+
+    template<class InputIterator, class OutputIterator>
+    std::ptrdiff_t delta_encode(InputIterator lo,
+        InputIterator hi,
+        OutputIterator out,
+        T initial = T()) const
+    {
+        return primary().delta_encode(lo, hi, out, initial);
+    }
+
+    template<class InputIterator, class OutputIterator>
+    InputIterator decode(InputIterator in, OutputIterator out, int n) const
+    {
+        return primary().decode(in, out, n);
+    }
+
+    template<class InputIterator, class OutputIterator>
+    InputIterator delta_decode(
+        InputIterator in, OutputIterator out, int n, T initial = T()) const
+    {
+        return primary().delta_decode(in, out, n, initial);
+    }
+
+    //! Calls `fn(codec)` for the codec identified by `tag`.
+    template<class Fn>
+    void visit(tag_type tag, Fn&& fn) const
+    {
+        visit_impl(tag, fn, std::make_index_sequence<codec_count>{});
+    }
+
+    //! Calls `fn(tag, codec)` for each codec in the set.
+    template<class Fn>
+    void for_each_codec(Fn&& fn) const
+    {
+        std::apply(
+            [&fn](auto const&... codecs) {
+                tag_type tag = 0;
+                (fn(tag++, codecs), ...);
+            },
+            codecs_);
+    }
+
+    //! Selects a codec given the sizes of data encoded with each of them.
+    /*!
+     * \param sizes     encoded sizes, in the order of tags
+     * \returns         the first tag whose size does not exceed the smallest
+     *                  size by more than the configured slack
+     */
+    tag_type select(gsl::span<std::ptrdiff_t const> sizes) const
+    {
+        auto smallest = *std::min_element(sizes.begin(), sizes.end());
+        auto limit = static_cast<double>(smallest) * (1.0 + slack_);
+        for (tag_type tag = 0; tag < sizes.size(); ++tag) {
+            if (static_cast<double>(sizes[tag]) <= limit) { return tag; }
+        }
+        return 0;
+    }
+
+    double slack() const { return slack_; }
+
+private:
+    primary_codec_type const& primary() const { return std::get<0>(codecs_); }
+
+    template<class Fn, std::size_t... Tags>
+    void visit_impl(tag_type tag, Fn& fn, std::index_sequence<Tags...>) const
+    {
+        static_cast<void>(
+            ((tag == static_cast<tag_type>(Tags)
+                  ? (fn(std::get<Tags>(codecs_)), true)
+                  : false)
+             || ...));
+    }
+
+    codecs_type codecs_{};
+    double slack_ = 0.0;
+};
+
+template<class Codec>
+struct is_adaptive_codec : std::false_type {};
+
+template<class T, class... Codecs>
+struct is_adaptive_codec<adaptive_codec<T, Codecs...>> : std::true_type {};
+
+template<class Codec>
+constexpr bool is_adaptive_codec_v = is_adaptive_codec<Codec>::value;
+
+}  // namespace irk
@@ -0,0 +1,179 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+
+namespace irk {
+
+//! Returns the number of bits needed to represent `value`.
+inline constexpr std::uint32_t bit_width(std::uint64_t value)
+{
+    std::uint32_t width = 0;
+    while (value > 0) {
+        value >>= 1u;
+        ++width;
+    }
+    return width;
+}
+
+//! Frame-of-reference style fixed-width bit packing.
+/*!
+ * A sequence is encoded as a single byte holding the bit width `w` of the
+ * largest value, followed by `ceil(n * w / 8)` bytes, in which the values
+ * are packed LSB-first. Delta encoding packs gaps between consecutive values.
+ *
+ * Very short or very regular sequences (such as dense ID gaps or small
+ * frequencies) tend to be much smaller this way than with a byte-aligned
+ * codec, which needs at least one byte per value.
+ */
+template<class T>
+struct bitpacking_codec {
+    static_assert(sizeof(T) <= sizeof(std::uint32_t),
+                  "bitpacking_codec supports values of up to 32 bits");
+    using value_type = T;
+    using unsigned_type = std::make_unsigned_t<T>;
+
+    std::ptrdiff_t max_encoded_size(
+        int count, std::optional<T> /* max_value */ = std::nullopt) const
+    {
+        return 1 + count * sizeof(T);
+    }
+
+    template<class InputIterator, class OutputIterator>
+    std::ptrdiff_t
+    encode(InputIterator lo, InputIterator hi, OutputIterator out) const
+    {
+        std::uint64_t max_value = 0;
+        for (auto it = lo; it != hi; ++it) {
+            max_value = std::max<std::uint64_t>(
+                max_value, static_cast<unsigned_type>(*it));
+        }
+        return pack(lo, hi, out, bit_width(max_value), [](auto v) { return v; });
+    }
+
+    template<class InputIterator, class OutputIterator>
+    std::ptrdiff_t delta_encode(InputIterator lo,
+        InputIterator hi,
+        OutputIterator out,
+        T initial = T()) const
+    {
+        std::uint64_t max_value = 0;
+        T previous = initial;
+        for (auto it = lo; it != hi; ++it) {
+            max_value = std::max<std::uint64_t>(
+                max_value, static_cast<unsigned_type>(*it - previous));
+            previous = *it;
+        }
+        return pack(lo, hi, out, bit_width(max_value),
+            [previous = initial](auto v) mutable {
+                auto gap = v - previous;
+                previous = v;
+                return gap;
+            });
+    }
+
+    template<class InputIterator, class OutputIterator>
+    InputIterator decode(InputIterator in, OutputIterator out, int n) const
+    {
+        return unpack(in, out, n, [](auto v) { return v; });
+    }
+
+    template<class InputIterator, class OutputIterator>
+    InputIterator delta_decode(
+        InputIterator in, OutputIterator out, int n, T initial = T()) const
+    {
+        return unpack(in, out, n, [previous = initial](auto gap) mutable {
+            previous += static_cast<T>(gap);
+            return previous;
+        });
+    }
+
+private:
+    template<class InputIterator, class OutputIterator, class Transform>
+    std::ptrdiff_t pack(InputIterator lo,
+        InputIterator hi,
+        OutputIterator out,
+        std::uint32_t width,
+        Transform transform) const
+    {
+        *out++ = static_cast<char>(width);
+        std::ptrdiff_t size = 1;
+        std::uint64_t buffer = 0;
+        std::uint32_t buffered = 0;
+        for (; lo != hi; ++lo) {
+            buffer |= static_cast<std::uint64_t>(
+                          static_cast<unsigned_type>(transform(*lo)))
+                << buffered;
+            buffered += width;
+            while (buffered >= 8) {
+                *out++ = static_cast<char>(buffer & 0xFFu);
+                buffer >>= 8u;
+                buffered -= 8;
+                ++size;
+            }
+        }
+        if (buffered > 0) {
+            *out++ = static_cast<char>(buffer & 0xFFu);
+            ++size;
+        }
+        return size;
+    }
+
+    template<class InputIterator, class OutputIterator, class Transform>
+    InputIterator unpack(
+        InputIterator in, OutputIterator out, int n, Transform transform) const
+    {
+        using output_type =
+            typename std::iterator_traits<OutputIterator>::value_type;
+        auto width = static_cast<std::uint32_t>(
+            static_cast<unsigned char>(*in));
+        ++in;
+        const std::uint64_t mask = (std::uint64_t{1} << width) - 1;
+        std::uint64_t buffer = 0;
+        std::uint32_t buffered = 0;
+        for (int idx = 0; idx < n; ++idx) {
+            while (buffered < width) {
+                buffer |= static_cast<std::uint64_t>(
+                              static_cast<unsigned char>(*in))
+                    << buffered;
+                ++in;
+                buffered += 8;
+            }
+            *out++ = static_cast<output_type>(transform(buffer & mask));
+            buffer >>= width;
+            buffered -= width;
+        }
+        return in;
+    }
+};
+
+}  // namespace irk
@@ -26,11 +26,15 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <debug_assert.hpp>
 #include <gsl/gsl_assert>
 
 #include <irkit/alphabetical_bst.hpp>
 #include <irkit/assert.hpp>
+#include <irkit/bitstream.hpp>
 #include <irkit/coding/huffman.hpp>
 #include <irkit/types.hpp>
 
@@ -238,6 +242,41 @@ namespace coding::hutucker {
         return alphabetical_bst(mem);
     }
 
+    //! Number of bits resolved by a single decoding table lookup.
+    constexpr int table_bits = 10;
+
+    //! Decoding table entry.
+    /*!
+     * `next` has the same meaning as a child pointer in the ABST: a value
+     * below the symbol bound is a decoded symbol, otherwise it points to the
+     * node at which decoding continues after consuming `length` bits.
+     */
+    struct table_entry {
+        std::uint16_t next;
+        std::uint8_t length;
+    };
+
+    //! Builds a table mapping the next `table_bits` bits of a stream to the
+    //! result of walking the tree from its root.
+    template<class Tree>
+    std::vector<table_entry> build_decoding_table(const Tree& tree)
+    {
+        using pointer_type = typename Tree::pointer_type;
+        std::vector<table_entry> table(std::size_t{1} << table_bits);
+        for (std::size_t bits = 0; bits < table.size(); ++bits) {
+            pointer_type next = Tree::symbol_bound;
+            std::uint8_t length = 0;
+            while (next >= Tree::symbol_bound && length < table_bits) {
+                auto node = tree.node_at(next - Tree::symbol_bound);
+                next = ((bits >> length) & 1u) != 0u ? node.right()
+                                                     : node.left();
+                ++length;
+            }
+            table[bits] = {static_cast<std::uint16_t>(next), length};
+        }
+        return table;
+    }
+
 }  // namespace coding::hutucker
 
 //! Hu-Tucker codec.
@@ -260,6 +299,7 @@ public:
 
 private:
     alphabetical_bst<symbol_type, uint16_t, buffer_type> abst_;
+    std::vector<coding::hutucker::table_entry> decoding_table_;
 
 public:
     hutucker_codec(const hutucker_codec&) = default;
@@ -271,7 +311,8 @@ public:
     //! Constructs a codec from an existing ABST.
     explicit hutucker_codec(
         alphabetical_bst<symbol_type, uint16_t, buffer_type> abst)
-        : abst_(std::move(abst))
+        : abst_(std::move(abst)),
+          decoding_table_(coding::hutucker::build_decoding_table(abst_))
     {}
 
     //! Constructs a codec from a vector of all symbols' frequencies.
@@ -288,6 +329,7 @@ public:
         auto tagged_leaves = coding::hutucker::tag_leaves(initial_tree);
         auto tree = coding::hutucker::reconstruct(tagged_leaves);
         abst_ = coding::hutucker::compact(tree);
+        decoding_table_ = coding::hutucker::build_decoding_table(abst_);
     }
 
     //! Returns a dynamic bitset representing the encoded word.
@@ -389,6 +431,45 @@ public:
         return n;
     }
 
+    //! Decodes a single symbol from memory.
+    /*!
+     * Unlike the overloads reading one bit at a time, this resolves
+     * `coding::hutucker::table_bits` bits per table lookup, and only falls
+     * back to walking the tree for the remainder of longer codes.
+     */
+    symbol_type decode(memory_bit_stream& source) const
+    {
+        const auto& entry =
+            decoding_table_[source.peek(coding::hutucker::table_bits)];
+        if (entry.length > source.remaining()) {
+            throw std::runtime_error(
+                "bit stream ended before finishing decoding a symbol");
+        }
+        source.skip(entry.length);
+        std::uint16_t next = entry.next;
+        while (next >= symbol_count) {
+            std::int8_t bit = source.read();
+            if (bit == -1) {
+                throw std::runtime_error(
+                    "bit stream ended before finishing decoding a symbol");
+            }
+            auto node = abst_.node_at(next - symbol_count);
+            next = bit ? node.right() : node.left();
+        }
+        return static_cast<symbol_type>(next);
+    }
+
+    //! Decodes `n` symbols from memory and appends them to `sink`.
+    template<class = enable_if_equal<symbol_type, char>>
+    std::size_t
+    decode(memory_bit_stream& source, std::string& sink, std::size_t n) const
+    {
+        for (std::size_t idx = 0; idx < n; ++idx) {
+            sink.push_back(decode(source));
+        }
+        return n;
+    }
+
     //! Returns the tree used to encode and decode symbols.
     const alphabetical_bst<symbol_type, uint16_t, buffer_type>& tree() const
     {
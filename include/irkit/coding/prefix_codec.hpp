@@ -26,6 +26,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <string>
+#include <string_view>
+
 #include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/stream.hpp>
@@ -46,7 +50,7 @@ public:
     ~prefix_codec() = default;
 
     output_bit_stream&
-    encode(const std::string& value, output_bit_stream& out) const
+    encode(std::string_view value, output_bit_stream& out) const
     {
         std::size_t pos = 0;
         for (; pos < prev_.size() && pos < value.size(); ++pos)
@@ -75,7 +79,34 @@ public:
         return size;
     }
 
-    void reset() const { prev_ = ""; }
+    //! Decodes a value directly from memory.
+    /*!
+     * Equivalent to the `input_bit_stream` overload, but unary lengths are
+     * counted a word at a time and the suffix is appended straight to
+     * `value` instead of going through an output stream.
+     */
+    std::streamsize
+    decode(memory_bit_stream& in, std::string& value) const
+    {
+        auto size = decode_in_place(in);
+        value.assign(prev_);
+        return size;
+    }
+
+    //! Decodes a value directly from memory, without allocating.
+    /*!
+     * The value is decoded in place of the previous one, and the returned
+     * view points to the codec's own buffer: it is only valid until the next
+     * call to `decode` or `reset`. Once the buffer has grown to fit the
+     * longest value, no memory is allocated.
+     */
+    std::string_view decode(memory_bit_stream& in) const
+    {
+        decode_in_place(in);
+        return prev_;
+    }
+
+    void reset() const { prev_.clear(); }
 
     const Codec& codec() const { return codec_; }
 
@@ -89,6 +120,15 @@ private:
         out.write(false);
     }
 
+    std::streamsize decode_in_place(memory_bit_stream& in) const
+    {
+        int prefix_length = decode_unary(in);
+        int suffix_length = decode_unary(in);
+        prev_.resize(std::min<std::size_t>(prefix_length, prev_.size()));
+        return codec_.decode(in, prev_, suffix_length) + prefix_length
+            + suffix_length + 2;
+    }
+
     int decode_unary(input_bit_stream& in) const
     {
         int value = 0;
@@ -96,6 +136,21 @@ private:
         while ((bit = in.read()) > 0) { ++value; }
         return value;
     }
+
+    int decode_unary(memory_bit_stream& in) const
+    {
+        constexpr int word_bits = memory_bit_stream::max_peek_bits;
+        int value = 0;
+        while (true) {
+            auto ones = __builtin_ctzll(~in.peek(word_bits));
+            if (ones < word_bits) {
+                in.skip(ones + 1);
+                return value + ones;
+            }
+            in.skip(word_bits);
+            value += word_bits;
+        }
+    }
 };
 
 }  // namespace irk
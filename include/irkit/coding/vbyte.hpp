@@ -26,10 +26,17 @@
 
 #pragma once
 
+#include <array>
 #include <bitset>
 #include <cstdarg>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <type_traits>
+
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
 
 #include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
@@ -43,6 +50,118 @@ namespace irk {
 
 namespace ts = type_safe;
 
+namespace detail::vbyte {
+
+    //! Decoding instructions for a 12-bit mask of terminating bytes.
+    /*!
+     * In Masked VByte, the most significant bits of 16 bytes are gathered
+     * into a mask, whose 12 lower bits select an entry describing how to
+     * shuffle the bytes of the leading integers into SIMD lanes.
+     * Note that in this implementation, the most significant bit is set for
+     * the last byte of an integer (rather than the continuation bytes).
+     */
+    struct masked_entry {
+        //! 0: decode one integer with the scalar decoder,
+        //! 1: up to 8 integers of at most 2 bytes into 16-bit lanes,
+        //! 2: up to 4 integers of at most 4 bytes into 32-bit lanes.
+        std::uint8_t kind = 0;
+        //! Number of decoded integers.
+        std::uint8_t count = 0;
+        //! Number of consumed bytes.
+        std::uint8_t consumed = 0;
+        std::array<std::int8_t, 16> shuffle{};
+    };
+
+    using masked_table = std::array<masked_entry, 4096>;
+
+    constexpr masked_entry make_masked_entry(unsigned int mask)
+    {
+        std::array<int, 12> starts{};
+        std::array<int, 12> lengths{};
+        int ints = 0;
+        int start = 0;
+        for (int byte = 0; byte < 12; ++byte) {
+            if ((mask >> static_cast<unsigned int>(byte)) & 1u) {
+                starts[ints] = start;
+                lengths[ints] = byte - start + 1;
+                ++ints;
+                start = byte + 1;
+            }
+        }
+        int short_count = 0;
+        while (short_count < ints && short_count < 8 && lengths[short_count] <= 2) {
+            ++short_count;
+        }
+        int medium_count = 0;
+        while (medium_count < ints && medium_count < 4 && lengths[medium_count] <= 4) {
+            ++medium_count;
+        }
+        masked_entry entry{};
+        for (auto& byte : entry.shuffle) { byte = -1; }
+        if (short_count == 0 && medium_count == 0) { return entry; }
+        int lane_bytes = short_count >= medium_count ? 2 : 4;
+        int count = short_count >= medium_count ? short_count : medium_count;
+        entry.kind = lane_bytes == 2 ? 1 : 2;
+        entry.count = static_cast<std::uint8_t>(count);
+        for (int idx = 0; idx < count; ++idx) {
+            for (int byte = 0; byte < lengths[idx]; ++byte) {
+                entry.shuffle[idx * lane_bytes + byte] =
+                    static_cast<std::int8_t>(starts[idx] + byte);
+            }
+        }
+        entry.consumed = static_cast<std::uint8_t>(
+            starts[count - 1] + lengths[count - 1]);
+        return entry;
+    }
+
+    constexpr masked_table make_masked_table()
+    {
+        masked_table table{};
+        for (unsigned int mask = 0; mask < table.size(); ++mask) {
+            table[mask] = make_masked_entry(mask);
+        }
+        return table;
+    }
+
+    inline constexpr masked_table masked_decoding_table = make_masked_table();
+
+#ifdef __SSE4_1__
+    //! Stores 4 32-bit lanes into either 32-bit or 64-bit integers.
+    /*!
+     * If `Delta` is set, the lanes are first replaced by their prefix sums
+     * (which fit in 32 bits, as each lane holds at most 28 bits)
+     * shifted by `initial`, and `initial` is updated to the last lane.
+     */
+    template<bool Delta, class Out>
+    inline void store_epi32(Out* out, __m128i values, Out& initial)
+    {
+        if constexpr (Delta) {
+            values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+            values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+        }
+        if constexpr (sizeof(Out) == 4) {
+            if constexpr (Delta) {
+                values = _mm_add_epi32(
+                    values, _mm_set1_epi32(static_cast<std::int32_t>(initial)));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), values);
+        } else {
+            auto low = _mm_cvtepu32_epi64(values);
+            auto high = _mm_cvtepu32_epi64(_mm_srli_si128(values, 8));
+            if constexpr (Delta) {
+                auto base = _mm_set1_epi64x(static_cast<std::int64_t>(initial));
+                low = _mm_add_epi64(low, base);
+                high = _mm_add_epi64(high, base);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2), high);
+        }
+        if constexpr (Delta) { initial = out[3]; }
+    }
+#endif
+
+}  // namespace detail::vbyte
+
 template<class T>
 struct vbyte_codec {
     using value_type = T;
@@ -130,20 +249,143 @@ struct vbyte_codec {
     InputIterator
     decode(InputIterator in, OutputIterator out, int n) const
     {
-        for (int idx = 0; idx < n; ++idx) { in = decode(in, out++); }
-        return in;
+        if constexpr (is_bulk_decodable<InputIterator, OutputIterator>()) {
+            using output_type = std::remove_pointer_t<OutputIterator>;
+            return bulk_decode<false>(in, out, n, output_type{});
+        } else {
+            for (int idx = 0; idx < n; ++idx) { in = decode(in, out++); }
+            return in;
+        }
     }
 
     template<class InputIterator, class OutputIterator>
     InputIterator delta_decode(
         InputIterator in, OutputIterator out, int n, T initial = T()) const
     {
-        for (int idx = 0; idx < n; ++idx)
-        {
-            in = decode(in, out);
-            *out += initial;
-            initial = *out;
-            ++out;
+        if constexpr (is_bulk_decodable<InputIterator, OutputIterator>()) {
+            using output_type = std::remove_pointer_t<OutputIterator>;
+            return bulk_decode<true>(
+                in, out, n, static_cast<output_type>(initial));
+        } else {
+            for (int idx = 0; idx < n; ++idx)
+            {
+                in = decode(in, out);
+                *out += initial;
+                initial = *out;
+                ++out;
+            }
+            return in;
+        }
+    }
+
+    //! Whether decoding many integers at once with these iterators is vectorized.
+    /*!
+     * Bulk decoding requires contiguous input bytes and 32/64-bit output,
+     * passed as pointers; e.g., pass `data()` of a vector, not `begin()`.
+     */
+    template<class InputIterator, class OutputIterator>
+    static constexpr bool is_bulk_decodable()
+    {
+        if constexpr (std::is_pointer_v<InputIterator>
+                      && std::is_pointer_v<OutputIterator>) {
+            using input_type = std::remove_pointer_t<InputIterator>;
+            using output_type = std::remove_pointer_t<OutputIterator>;
+            return sizeof(input_type) == 1 && std::is_integral_v<output_type>
+                && (sizeof(output_type) == 4 || sizeof(output_type) == 8);
+        } else {
+            return false;
+        }
+    }
+
+private:
+    //! Decodes `n` integers, many at a time (Masked VByte) if SSE4.1 is available.
+    /*!
+     * Vectorized steps are only taken while at least 16 integers remain,
+     * which guarantees that the 16-byte loads do not cross the end of
+     * the encoded data, and that the output has room for all written lanes.
+     * If `Delta` is set, the decoded gaps are accumulated on top of `initial`.
+     */
+    template<bool Delta, class InputIterator, class OutputIterator, class Out>
+    InputIterator
+    bulk_decode(InputIterator in, OutputIterator out, int n, Out initial) const
+    {
+        int idx = 0;
+#ifdef __SSE4_1__
+        const __m128i low7 = _mm_set1_epi16(0x7F);
+        const __m128i high7 = _mm_set1_epi16(0x3F80);
+        while (n - idx >= 16) {
+            auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            auto mask = static_cast<unsigned int>(_mm_movemask_epi8(bytes));
+            if (mask == 0xFFFFu) {
+                auto values = _mm_and_si128(bytes, _mm_set1_epi8(0x7F));
+                for (int lane = 0; lane < 4; ++lane) {
+                    detail::vbyte::store_epi32<Delta>(
+                        out + idx + lane * 4, _mm_cvtepu8_epi32(values), initial);
+                    values = _mm_srli_si128(values, 4);
+                }
+                in += 16;
+                idx += 16;
+                continue;
+            }
+            if (mask == 0xAAAAu) {
+                auto values = _mm_or_si128(
+                    _mm_and_si128(bytes, low7),
+                    _mm_and_si128(_mm_srli_epi16(bytes, 1), high7));
+                detail::vbyte::store_epi32<Delta>(
+                    out + idx, _mm_cvtepu16_epi32(values), initial);
+                detail::vbyte::store_epi32<Delta>(
+                    out + idx + 4,
+                    _mm_cvtepu16_epi32(_mm_srli_si128(values, 8)),
+                    initial);
+                in += 16;
+                idx += 8;
+                continue;
+            }
+            auto const& entry = detail::vbyte::masked_decoding_table[mask & 0xFFFu];
+            if (entry.kind == 0) {
+                in = decode(in, out + idx);
+                if constexpr (Delta) {
+                    out[idx] += initial;
+                    initial = out[idx];
+                }
+                ++idx;
+                continue;
+            }
+            auto shuffle = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(entry.shuffle.data()));
+            auto lanes = _mm_shuffle_epi8(bytes, shuffle);
+            if (entry.kind == 1) {
+                auto values = _mm_or_si128(
+                    _mm_and_si128(lanes, low7),
+                    _mm_and_si128(_mm_srli_epi16(lanes, 1), high7));
+                detail::vbyte::store_epi32<Delta>(
+                    out + idx, _mm_cvtepu16_epi32(values), initial);
+                detail::vbyte::store_epi32<Delta>(
+                    out + idx + 4,
+                    _mm_cvtepu16_epi32(_mm_srli_si128(values, 8)),
+                    initial);
+            } else {
+                auto values = _mm_or_si128(
+                    _mm_or_si128(
+                        _mm_and_si128(lanes, _mm_set1_epi32(0x7F)),
+                        _mm_and_si128(_mm_srli_epi32(lanes, 1), _mm_set1_epi32(0x3F80))),
+                    _mm_or_si128(
+                        _mm_and_si128(_mm_srli_epi32(lanes, 2), _mm_set1_epi32(0x1FC000)),
+                        _mm_and_si128(_mm_srli_epi32(lanes, 3), _mm_set1_epi32(0xFE00000))));
+                detail::vbyte::store_epi32<Delta>(out + idx, values, initial);
+            }
+            in += entry.consumed;
+            idx += entry.count;
+            // Lanes past `count` hold values that will be overwritten.
+            if constexpr (Delta) { initial = out[idx - 1]; }
+        }
+#endif
+        for (; idx < n; ++idx) {
+            in = decode(in, out + idx);
+            if constexpr (Delta) {
+                out[idx] += initial;
+                initial = out[idx];
+            }
         }
         return in;
     }
@@ -26,8 +26,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <type_traits>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -46,8 +53,12 @@ namespace irk {
 namespace fs = boost::filesystem;
 
 struct CompactTableHeaderFlags {
-    static const std::uint32_t Default = 0;
-    static const std::uint32_t DeltaEncoding = 1;
+    static constexpr std::uint32_t Default = 0;
+    static constexpr std::uint32_t DeltaEncoding = 1;
+    //! Values bit-packed with a fixed width; see `build_packed_table`.
+    static constexpr std::uint32_t BitPacked = 2;
+    //! Non-decreasing values in Elias-Fano representation; see `build_elias_fano_table`.
+    static constexpr std::uint32_t EliasFano = 4;
 };
 
 struct compact_table_header {
@@ -65,8 +76,131 @@ struct compact_table_leader {
     }
 };
 
+//! Follows `compact_table_header` in a bit-packed table.
+/*!
+ * The table is then followed by 64-bit words, in which the value at index
+ * `i` minus `base` occupies `width` bits starting at bit `i * width`.
+ */
+struct packed_table_header {
+    std::int64_t base = 0;
+    std::uint32_t width = 0;
+    std::uint32_t reserved = 0;
+};
+
+//! Follows `compact_table_header` in an Elias-Fano table.
+/*!
+ * The table is then followed by:
+ *  - `sample_count` 64-bit positions in the upper bits of every
+ *    `elias_fano_sample_rate`-th set bit,
+ *  - `low_words` 64-bit words of lower bits, packed as in a bit-packed table,
+ *  - the upper bits, in which value `i` is marked by bit
+ *    `(value >> low_bits) + i`.
+ */
+struct elias_fano_table_header {
+    std::uint32_t low_bits = 0;
+    std::uint32_t sample_count = 0;
+    std::uint64_t low_words = 0;
+    std::uint64_t high_words = 0;
+};
+
+inline constexpr std::uint64_t elias_fano_sample_rate = 64;
+
+namespace detail::compact {
+
+    inline std::uint64_t load_word(const char* words, std::uint64_t idx)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, words + idx * sizeof(word), sizeof(word));
+        return word;
+    }
+
+    inline std::uint64_t
+    read_bits(const char* words, std::uint64_t pos, std::uint32_t width)
+    {
+        if (width == 0) { return 0; }
+        auto word_idx = pos / 64;
+        auto shift = pos % 64;
+        std::uint64_t value = load_word(words, word_idx) >> shift;
+        if (shift + width > 64) {
+            value |= load_word(words, word_idx + 1) << (64 - shift);
+        }
+        return width == 64 ? value : value & ((std::uint64_t{1} << width) - 1);
+    }
+
+    inline void write_bits(std::vector<std::uint64_t>& words,
+        std::uint64_t pos,
+        std::uint32_t width,
+        std::uint64_t value)
+    {
+        if (width == 0) { return; }
+        if (width < 64) { value &= (std::uint64_t{1} << width) - 1; }
+        auto word_idx = pos / 64;
+        auto shift = pos % 64;
+        words[word_idx] |= value << shift;
+        if (shift + width > 64) { words[word_idx + 1] |= value >> (64 - shift); }
+    }
+
+    //! Returns the position of the set bit of the given rank in a word.
+    inline std::uint64_t select_in_word(std::uint64_t word, std::uint64_t rank)
+    {
+#ifdef __BMI2__
+        return __builtin_ctzll(_pdep_u64(std::uint64_t{1} << rank, word));
+#else
+        for (; rank > 0; --rank) { word &= word - 1; }
+        return __builtin_ctzll(word);
+#endif
+    }
+
+    inline std::uint32_t bit_width(std::uint64_t value)
+    {
+        return value == 0 ? 0 : 64 - __builtin_clzll(value);
+    }
+
+}  // namespace detail::compact
+
+//! Reads a value of a bit-packed table in constant time.
+template<class Mem>
+std::int64_t read_packed_value(const Mem& mem, std::uint32_t key)
+{
+    packed_table_header header;
+    auto pos = mem.data() + sizeof(compact_table_header);
+    std::memcpy(&header, pos, sizeof(header));
+    auto words = pos + sizeof(header);
+    return header.base
+        + static_cast<std::int64_t>(detail::compact::read_bits(
+              words, std::uint64_t{key} * header.width, header.width));
+}
+
+//! Reads a value of an Elias-Fano table in constant time.
+template<class Mem>
+std::uint64_t read_elias_fano_value(const Mem& mem, std::uint32_t key)
+{
+    using detail::compact::load_word;
+    elias_fano_table_header header;
+    auto pos = mem.data() + sizeof(compact_table_header);
+    std::memcpy(&header, pos, sizeof(header));
+    auto samples = pos + sizeof(header);
+    auto low = samples + header.sample_count * sizeof(std::uint64_t);
+    auto high = low + header.low_words * sizeof(std::uint64_t);
+
+    std::uint64_t bit = load_word(samples, key / elias_fano_sample_rate);
+    std::uint64_t rank = key % elias_fano_sample_rate;
+    std::uint64_t word_idx = bit / 64;
+    std::uint64_t word = load_word(high, word_idx) & (~std::uint64_t{0} << (bit % 64));
+    for (auto ones = std::uint64_t(__builtin_popcountll(word)); rank >= ones;
+         ones = __builtin_popcountll(word)) {
+        rank -= ones;
+        word = load_word(high, ++word_idx);
+    }
+    std::uint64_t high_bits =
+        word_idx * 64 + detail::compact::select_in_word(word, rank) - key;
+    return (high_bits << header.low_bits)
+        | detail::compact::read_bits(
+            low, std::uint64_t{key} * header.low_bits, header.low_bits);
+}
+
 template<class Mem, class Codec>
-auto read_compact_value(Mem mem, std::uint32_t key, Codec codec)
+auto read_compact_value(const Mem& mem, std::uint32_t key, Codec codec)
 {
     auto header = reinterpret_cast<const compact_table_header*>(mem.data());
     bool delta_encoded = header->flags & CompactTableHeaderFlags::DeltaEncoding;
@@ -110,6 +244,11 @@ std::ostream& operator<<(std::ostream& out,
     This is a compressed table indexed with consecutive integers between `0` and
     `size - 1`. TODO: describe implmentation.
 
+    The format is determined by the header flags, so that tables built with
+    `build_compact_table`, `build_packed_table`, and `build_elias_fano_table`
+    can all be read with the same type. The latter two provide constant-time
+    random access that does not allocate.
+
     \author Michal Siedlaczek
  */
 template<class T,
@@ -136,17 +275,26 @@ public:
     T operator[](std::size_t idx)
     {
         EXPECTS(idx < size());
-        return read_compact_value(data_, idx, codec_);
+        return read(idx);
     }
 
     T operator[](std::size_t idx) const
     {
         EXPECTS(idx < size());
-        return read_compact_value(data_, idx, codec_);
+        return read(idx);
+    }
+
+    //! Whether the values are accessed in constant time without decoding blocks.
+    bool is_random_access() const
+    {
+        return (header()->flags
+                   & (CompactTableHeaderFlags::BitPacked
+                       | CompactTableHeaderFlags::EliasFano))
+            != 0;
     }
 
     const char* data() { return data_.data(); }
-    const auto& buffer() { return data_; }
+    const auto& buffer() const { return data_; }
 
     const compact_table_header* header() const
     {
@@ -191,9 +339,16 @@ public:
               block_size_(ref.header()->block_size),
               count_(ref.header()->count),
               delta_encoded_(
-                  ref.header()->flags & CompactTableHeaderFlags::DeltaEncoding)
+                  ref.header()->flags & CompactTableHeaderFlags::DeltaEncoding),
+              random_access_(ref.is_random_access())
         {
-            if (pos_ < count_) { next_buffer(); }
+            if (pos_ < count_) {
+                if (random_access_) {
+                    value_ = ref_.read(pos_);
+                } else {
+                    next_buffer();
+                }
+            }
         }
 
     private:
@@ -219,6 +374,10 @@ public:
 
         void increment()
         {
+            if (random_access_) {
+                if (++pos_ < count_) { value_ = ref_.read(pos_); }
+                return;
+            }
             if (++pos_ % block_size_ == 0 && pos_ < count_) {
                 next_buffer();
             }
@@ -227,6 +386,7 @@ public:
         bool equal(const iterator& other) const { return pos_ == other.pos_; }
         const T& dereference() const
         {
+            if (random_access_) { return value_; }
             DEBUG_ASSERT(
                 pos_ % block_size_ < static_cast<int32_t>(buffer_.size()),
                 debug_handler{});
@@ -240,12 +400,15 @@ public:
         int block_size_;
         int count_;
         bool delta_encoded_;
+        bool random_access_;
+        T value_{};
         std::vector<T> buffer_;
     };
     using const_iterator = iterator;
 
     iterator begin() const
     {
+        if (is_random_access()) { return iterator(*this, 0, 0, {}); }
         auto header = reinterpret_cast<const compact_table_header*>(
             data_.data());
         auto count = header->count;
@@ -260,6 +423,19 @@ public:
     iterator end() const { return iterator(*this, header()->count, 0, {}); }
 
     friend iterator;
+
+private:
+    T read(std::size_t idx) const
+    {
+        auto flags = header()->flags;
+        if ((flags & CompactTableHeaderFlags::EliasFano) != 0) {
+            return static_cast<T>(read_elias_fano_value(data_, idx));
+        }
+        if ((flags & CompactTableHeaderFlags::BitPacked) != 0) {
+            return static_cast<T>(read_packed_value(data_, idx));
+        }
+        return read_compact_value(data_, idx, codec_);
+    }
 };
 
 //! Load a compact table to main memory.
@@ -320,6 +496,94 @@ build_compact_table(const std::vector<T>& values,
     return compact_table<T, Codec>(std::move(data));
 }
 
+//! Build a table of values bit-packed with a fixed width in main memory.
+/*!
+ * The width is the number of bits of the difference between the largest
+ * and the smallest value.
+ */
+template<class T, class Codec = vbyte_codec<T>>
+compact_table<T, Codec, std::vector<char>>
+build_packed_table(const std::vector<T>& values)
+{
+    std::vector<char> data;
+    compact_table_header header{static_cast<std::uint32_t>(values.size()),
+        0,
+        CompactTableHeaderFlags::BitPacked};
+    io::append_object(header, data);
+
+    packed_table_header packed_header{};
+    if (not values.empty()) {
+        auto [min, max] = std::minmax_element(values.begin(), values.end());
+        packed_header.base = static_cast<std::int64_t>(*min);
+        packed_header.width = detail::compact::bit_width(
+            static_cast<std::uint64_t>(*max) - static_cast<std::uint64_t>(*min));
+    }
+    std::vector<std::uint64_t> words(
+        (values.size() * packed_header.width + 63) / 64);
+    for (std::size_t idx = 0; idx < values.size(); ++idx) {
+        detail::compact::write_bits(words,
+            idx * packed_header.width,
+            packed_header.width,
+            static_cast<std::uint64_t>(values[idx])
+                - static_cast<std::uint64_t>(packed_header.base));
+    }
+    io::append_object(packed_header, data);
+    io::append_collection(words, data);
+    return compact_table<T, Codec>(std::move(data));
+}
+
+//! Build a table of non-decreasing values in Elias-Fano representation in main memory.
+/*!
+ * Each value takes about `2 + log(max / count)` bits, plus 64 bits per
+ * `elias_fano_sample_rate` values for the samples that make access
+ * constant-time. If the values are not sorted, a bit-packed table is built
+ * instead.
+ */
+template<class T = std::size_t, class Codec = vbyte_codec<T>>
+compact_table<T, Codec, std::vector<char>>
+build_elias_fano_table(const std::vector<T>& values)
+{
+    bool negative = false;
+    if constexpr (std::is_signed_v<T>) {
+        negative = not values.empty() && values.front() < T{0};
+    }
+    if (negative || not std::is_sorted(values.begin(), values.end())) {
+        return build_packed_table<T, Codec>(values);
+    }
+    std::vector<char> data;
+    std::uint64_t count = values.size();
+    compact_table_header header{static_cast<std::uint32_t>(count),
+        0,
+        CompactTableHeaderFlags::EliasFano};
+    io::append_object(header, data);
+
+    std::uint64_t max = values.empty() ? 0 : static_cast<std::uint64_t>(values.back());
+    elias_fano_table_header ef_header{};
+    if (count > 0 && max / count > 0) {
+        ef_header.low_bits = detail::compact::bit_width(max / count) - 1;
+    }
+    std::vector<std::uint64_t> samples;
+    std::vector<std::uint64_t> low((count * ef_header.low_bits + 63) / 64);
+    std::vector<std::uint64_t> high(
+        (count + (max >> ef_header.low_bits) + 1 + 63) / 64);
+    for (std::uint64_t idx = 0; idx < count; ++idx) {
+        auto value = static_cast<std::uint64_t>(values[idx]);
+        auto bit = (value >> ef_header.low_bits) + idx;
+        high[bit / 64] |= std::uint64_t{1} << (bit % 64);
+        if (idx % elias_fano_sample_rate == 0) { samples.push_back(bit); }
+        detail::compact::write_bits(
+            low, idx * ef_header.low_bits, ef_header.low_bits, value);
+    }
+    ef_header.sample_count = samples.size();
+    ef_header.low_words = low.size();
+    ef_header.high_words = high.size();
+    io::append_object(ef_header, data);
+    io::append_collection(samples, data);
+    io::append_collection(low, data);
+    io::append_collection(high, data);
+    return compact_table<T, Codec>(std::move(data));
+}
+
 //! Load an offset table to main memory.
 template<class Codec = vbyte_codec<std::size_t>>
 compact_table<std::size_t, Codec, std::vector<char>>
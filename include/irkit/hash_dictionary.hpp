@@ -0,0 +1,437 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <fmt/format.h>
+
+#include <irkit/assert.hpp>
+#include <irkit/io.hpp>
+#include <irkit/memoryview.hpp>
+
+namespace irk {
+
+namespace detail::hash_dictionary {
+
+    inline std::uint64_t mix(std::uint64_t lhs, std::uint64_t rhs)
+    {
+        __uint128_t product = static_cast<__uint128_t>(lhs) * rhs;
+        return static_cast<std::uint64_t>(product)
+            ^ static_cast<std::uint64_t>(product >> 64u);
+    }
+
+    //! Hashes a string eight bytes at a time.
+    inline std::uint64_t hash(std::string_view key, std::uint64_t seed)
+    {
+        std::uint64_t h = seed ^ 0xa0761d6478bd642fULL;
+        const char* data = key.data();
+        std::size_t remaining = key.size();
+        for (; remaining >= 8; remaining -= 8, data += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data, 8);
+            h = mix(h ^ word, 0xe7037ed1a0b428dbULL);
+        }
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, data, remaining);
+        h = mix(h ^ tail ^ key.size(), 0x8ebc6af09c88c6e3ULL);
+        return mix(h, 0x589965cc75374cc3ULL);
+    }
+
+    //! Two independent hashes of a key; all level positions and the
+    //! fingerprint are derived from them, so a key is hashed only once.
+    struct key_hash {
+        std::uint64_t first;
+        std::uint64_t second;
+
+        explicit key_hash(std::string_view key)
+            : first(hash(key, 0x1f83d9abfb41bd6bULL)),
+              second(hash(key, 0x5be0cd19137e2179ULL) | 1u)
+        {}
+
+        [[nodiscard]] auto level(std::uint64_t level) const -> std::uint64_t
+        {
+            return mix(first + level * second, 0x9e3779b97f4a7c15ULL);
+        }
+
+        [[nodiscard]] auto fingerprint() const -> std::uint32_t
+        {
+            return static_cast<std::uint32_t>(
+                mix(first ^ (second << 32u | second >> 32u), 0xd6e8feb86659fd93ULL)
+                >> 32u);
+        }
+    };
+
+    //! Maps a hash to [0, range) without division.
+    inline std::uint64_t reduce(std::uint64_t hash, std::uint64_t range)
+    {
+        return static_cast<std::uint64_t>(
+            (static_cast<__uint128_t>(hash) * range) >> 64u);
+    }
+
+    template<class T>
+    T load(const char* ptr)
+    {
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        return value;
+    }
+
+    struct header {
+        std::uint64_t key_count;
+        std::uint64_t word_count;
+        std::uint32_t level_count;
+        std::uint32_t fallback_count;
+    };
+    static_assert(sizeof(header) == 24);
+
+    //! Key that did not find a collision-free position in any level.
+    struct fallback_entry {
+        std::uint64_t first;
+        std::uint64_t second;
+        std::uint64_t slot;
+    };
+    static_assert(sizeof(fallback_entry) == 24);
+
+    struct slot_entry {
+        std::uint32_t index;
+        std::uint32_t fingerprint;
+    };
+    static_assert(sizeof(slot_entry) == 8);
+
+    //! Bits are stored in 64-byte blocks: a rank sample followed by
+    //! seven words, so that a probe and its rank share a cache line.
+    inline constexpr std::uint64_t block_words = 8;
+    inline constexpr std::uint64_t bit_words_per_block = block_words - 1;
+
+    //! Returns the position of a word of bits within the blocks.
+    inline std::uint64_t block_position(std::uint64_t word)
+    {
+        return word / bit_words_per_block * block_words + 1
+            + word % bit_words_per_block;
+    }
+
+    inline std::uint64_t block_count(std::uint64_t words)
+    {
+        return (words + bit_words_per_block - 1) / bit_words_per_block;
+    }
+
+    //! Counts set bits before `bit`; `load` reads a word of the blocks.
+    template<class Load>
+    std::uint64_t rank(std::uint64_t bit, Load load)
+    {
+        auto word = bit / 64;
+        auto block = word / bit_words_per_block;
+        auto in_block = word - block * bit_words_per_block;
+        auto first = block * block_words;
+        auto result = load(first);
+        for (std::uint64_t idx = 1; idx <= in_block; ++idx) {
+            result += __builtin_popcountll(load(first + idx));
+        }
+        auto mask = (std::uint64_t{1} << (bit % 64)) - 1;
+        return result + __builtin_popcountll(load(first + 1 + in_block) & mask);
+    }
+
+    //! Size of header and level table, padded to a block boundary.
+    inline std::uint64_t blocks_offset(std::uint32_t level_count)
+    {
+        auto size = sizeof(header) + level_count * sizeof(std::uint64_t);
+        auto block_size = block_words * sizeof(std::uint64_t);
+        return (size + block_size - 1) / block_size * block_size;
+    }
+    //! Levels after which remaining keys are stored explicitly.
+    inline constexpr std::uint32_t max_levels = 32;
+    //! Bits per key in each level.
+    inline constexpr double gamma = 2.0;
+
+}  // namespace detail::hash_dictionary
+
+//! Maps keys to their positions with a minimal perfect hash function.
+/*!
+ * The hash function follows the BBHash construction: every level is a bit
+ * vector in which keys are hashed; keys that do not collide with any other
+ * key at a level set their bit, and the rest move on to the next level.
+ * The slot of a key is the rank of its bit in the concatenated levels, so
+ * a lookup costs one hash computation, a few bit probes, and a rank sample.
+ *
+ * Each slot stores the position of its key (e.g., term ID) and a 32-bit
+ * fingerprint. A key that is not in the dictionary is rejected unless its
+ * fingerprint collides with the one in its slot, which happens with
+ * probability 2^-32. Contrary to `lexicon`, keys cannot be enumerated.
+ *
+ * Memory layout (all integers little-endian):
+ * ```
+ * [header][level words: u64 x levels][padding to 64 bytes]
+ * [blocks: (rank sample, 7 words of bits) x ceil(words / 7)]
+ * [fallback entries][slots]
+ * ```
+ */
+template<class MemoryContainer>
+class hash_dictionary {
+public:
+    using index_type = std::ptrdiff_t;
+    using memory_container = MemoryContainer;
+
+    explicit hash_dictionary(memory_container memory) : memory_(std::move(memory))
+    {
+        namespace hd = detail::hash_dictionary;
+        if (static_cast<std::uint64_t>(memory_.size()) < sizeof(hd::header)) {
+            throw std::runtime_error("hash dictionary is truncated");
+        }
+        const char* data = memory_.data();
+        auto header = hd::load<hd::header>(data);
+        key_count_ = header.key_count;
+        word_count_ = header.word_count;
+        fallback_count_ = header.fallback_count;
+        std::uint64_t offset = sizeof(hd::header);
+        if (offset + header.level_count * sizeof(std::uint64_t)
+            > static_cast<std::uint64_t>(memory_.size())) {
+            throw std::runtime_error("hash dictionary is truncated");
+        }
+        std::uint64_t word_offset = 0;
+        for (std::uint32_t level = 0; level < header.level_count; ++level) {
+            auto words = hd::load<std::uint64_t>(data + offset);
+            levels_.push_back({word_offset * 64, words * 64});
+            word_offset += words;
+            offset += sizeof(std::uint64_t);
+        }
+        blocks_offset_ = hd::blocks_offset(header.level_count);
+        offset = blocks_offset_
+            + hd::block_count(word_count_) * hd::block_words * sizeof(std::uint64_t);
+        fallback_offset_ = offset;
+        offset += fallback_count_ * sizeof(hd::fallback_entry);
+        slots_offset_ = offset;
+        offset += key_count_ * sizeof(hd::slot_entry);
+        if (offset != static_cast<std::uint64_t>(memory_.size())) {
+            throw std::runtime_error(fmt::format(
+                "hash dictionary size {} does not match its header (expected {})",
+                memory_.size(),
+                offset));
+        }
+    }
+
+    //! Returns the position of `key`, or `std::nullopt` if not found.
+    std::optional<index_type> index_at(std::string_view key) const
+    {
+        namespace hd = detail::hash_dictionary;
+        if (key_count_ == 0) { return std::nullopt; }
+        hd::key_hash hash(key);
+        const char* data = memory_.data();
+        auto slot = find_slot(data, hash);
+        if (not slot.has_value()) { return std::nullopt; }
+        auto entry = hd::load<hd::slot_entry>(
+            data + slots_offset_ + *slot * sizeof(hd::slot_entry));
+        if (entry.fingerprint != hash.fingerprint()) { return std::nullopt; }
+        return std::make_optional<index_type>(entry.index);
+    }
+
+    std::ptrdiff_t size() const { return key_count_; }
+    const memory_container& memory() const { return memory_; }
+
+    std::ostream& serialize(std::ostream& out) const
+    {
+        return out.write(memory_.data(), memory_.size());
+    }
+
+    void serialize(const boost::filesystem::path& file) const
+    {
+        std::ofstream out(file.c_str());
+        serialize(out);
+    }
+
+private:
+    struct level_range {
+        std::uint64_t first_bit;
+        std::uint64_t bit_count;
+    };
+
+    memory_container memory_;
+    std::uint64_t key_count_ = 0;
+    std::uint64_t word_count_ = 0;
+    std::uint64_t fallback_count_ = 0;
+    std::vector<level_range> levels_;
+    std::uint64_t blocks_offset_ = 0;
+    std::uint64_t fallback_offset_ = 0;
+    std::uint64_t slots_offset_ = 0;
+
+    std::uint64_t block_word(const char* data, std::uint64_t pos) const
+    {
+        return detail::hash_dictionary::load<std::uint64_t>(
+            data + blocks_offset_ + pos * sizeof(std::uint64_t));
+    }
+
+    std::uint64_t word(const char* data, std::uint64_t idx) const
+    {
+        return block_word(data, detail::hash_dictionary::block_position(idx));
+    }
+
+    std::uint64_t rank(const char* data, std::uint64_t bit) const
+    {
+        return detail::hash_dictionary::rank(
+            bit, [&](std::uint64_t pos) { return block_word(data, pos); });
+    }
+
+    std::optional<std::uint64_t>
+    find_slot(const char* data, const detail::hash_dictionary::key_hash& hash) const
+    {
+        namespace hd = detail::hash_dictionary;
+        for (std::uint64_t level = 0; level < levels_.size(); ++level) {
+            auto const& range = levels_[level];
+            auto bit = range.first_bit + hd::reduce(hash.level(level), range.bit_count);
+            if ((word(data, bit / 64) >> (bit % 64)) & 1u) { return rank(data, bit); }
+        }
+        for (std::uint64_t idx = 0; idx < fallback_count_; ++idx) {
+            auto entry = hd::load<hd::fallback_entry>(
+                data + fallback_offset_ + idx * sizeof(hd::fallback_entry));
+            if (entry.first == hash.first && entry.second == hash.second) {
+                return entry.slot;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+//! Builds a hash dictionary mapping each key to its position in `keys`.
+inline hash_dictionary<std::vector<char>>
+build_hash_dictionary(const std::vector<std::string>& keys)
+{
+    namespace hd = detail::hash_dictionary;
+    std::vector<hd::key_hash> hashes;
+    hashes.reserve(keys.size());
+    for (const auto& key : keys) { hashes.emplace_back(key); }
+
+    std::vector<std::uint64_t> level_words;
+    std::vector<std::uint64_t> bits;
+    std::vector<std::uint32_t> remaining(keys.size());
+    std::iota(remaining.begin(), remaining.end(), 0u);
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> positions;
+    positions.reserve(keys.size());
+    for (std::uint32_t level = 0; level < hd::max_levels && not remaining.empty();
+         ++level)
+    {
+        auto words = static_cast<std::uint64_t>(
+            (hd::gamma * remaining.size() + 63) / 64);
+        std::vector<std::uint64_t> hit(words, 0);
+        std::vector<std::uint64_t> collision(words, 0);
+        auto position = [&](std::uint32_t key) {
+            return hd::reduce(hashes[key].level(level), words * 64);
+        };
+        for (auto key : remaining) {
+            auto bit = position(key);
+            auto mask = std::uint64_t{1} << (bit % 64);
+            if (hit[bit / 64] & mask) { collision[bit / 64] |= mask; }
+            hit[bit / 64] |= mask;
+        }
+        std::vector<std::uint32_t> next;
+        auto first_bit = bits.size() * 64;
+        for (auto key : remaining) {
+            auto bit = position(key);
+            if (collision[bit / 64] & (std::uint64_t{1} << (bit % 64))) {
+                next.push_back(key);
+            } else {
+                positions.emplace_back(key, first_bit + bit);
+            }
+        }
+        for (std::uint64_t idx = 0; idx < words; ++idx) {
+            bits.push_back(hit[idx] & ~collision[idx]);
+        }
+        level_words.push_back(words);
+        remaining = std::move(next);
+    }
+
+    std::vector<std::uint64_t> blocks(hd::block_count(bits.size()) * hd::block_words, 0);
+    std::uint64_t rank = 0;
+    for (std::uint64_t idx = 0; idx < bits.size(); ++idx) {
+        if (idx % hd::bit_words_per_block == 0) {
+            blocks[idx / hd::bit_words_per_block * hd::block_words] = rank;
+        }
+        blocks[hd::block_position(idx)] = bits[idx];
+        rank += __builtin_popcountll(bits[idx]);
+    }
+    ENSURES(rank == positions.size());
+
+    std::vector<hd::slot_entry> slots(keys.size());
+    for (auto [key, bit] : positions) {
+        auto slot = hd::rank(bit, [&](std::uint64_t pos) { return blocks[pos]; });
+        slots[slot] = {key, hashes[key].fingerprint()};
+    }
+    std::vector<hd::fallback_entry> fallback;
+    for (auto key : remaining) {
+        for (const auto& entry : fallback) {
+            if (entry.first == hashes[key].first && entry.second == hashes[key].second) {
+                throw std::invalid_argument(
+                    fmt::format("duplicate key in hash dictionary: {}", keys[key]));
+            }
+        }
+        std::uint64_t slot = positions.size() + fallback.size();
+        fallback.push_back({hashes[key].first, hashes[key].second, slot});
+        slots[slot] = {key, hashes[key].fingerprint()};
+    }
+
+    std::vector<char> memory;
+    auto append = [&memory](const void* data, std::size_t size) {
+        auto const* bytes = reinterpret_cast<const char*>(data);
+        memory.insert(memory.end(), bytes, bytes + size);
+    };
+    hd::header header{keys.size(),
+                      bits.size(),
+                      static_cast<std::uint32_t>(level_words.size()),
+                      static_cast<std::uint32_t>(fallback.size())};
+    append(&header, sizeof(header));
+    append(level_words.data(), level_words.size() * sizeof(std::uint64_t));
+    memory.resize(hd::blocks_offset(header.level_count), 0);
+    append(blocks.data(), blocks.size() * sizeof(std::uint64_t));
+    append(fallback.data(), fallback.size() * sizeof(hd::fallback_entry));
+    append(slots.data(), slots.size() * sizeof(hd::slot_entry));
+    return hash_dictionary<std::vector<char>>(std::move(memory));
+}
+
+//! Builds a hash dictionary mapping each line of a file to its line number.
+inline hash_dictionary<std::vector<char>>
+build_hash_dictionary(const boost::filesystem::path& file)
+{
+    std::ifstream keys(file.c_str());
+    return build_hash_dictionary(std::vector<std::string>(
+        irk::io::line_iterator(keys), irk::io::line_iterator()));
+}
+
+inline hash_dictionary<irk::memory_view>
+load_hash_dictionary(const irk::memory_view& memory)
+{
+    return hash_dictionary<irk::memory_view>(memory);
+}
+
+}  // namespace irk
@@ -29,6 +29,7 @@
 #include <algorithm>
 #include <bitset>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <string>
 #include <string_view>
@@ -64,14 +65,18 @@
 #include <irkit/coding/stream_vbyte.hpp>
 #include <irkit/compacttable.hpp>
 #include <irkit/daat.hpp>
+#include <irkit/hash_dictionary.hpp>
 #include <irkit/index/posting_list.hpp>
+#include <irkit/index/term_info.hpp>
 #include <irkit/index/types.hpp>
 #include <irkit/io.hpp>
 #include <irkit/lexicon.hpp>
+#include <irkit/list/arena_block_list.hpp>
 #include <irkit/list/standard_block_list.hpp>
 #include <irkit/memoryview.hpp>
 #include <irkit/quantize.hpp>
 #include <irkit/score.hpp>
+#include <irkit/string_table.hpp>
 #include <irkit/types.hpp>
 #include <irkit/vector.hpp>
 
@@ -107,7 +112,9 @@ namespace index {
     template<class T>
     using ScoreStatsMap = std::unordered_map<std::string, ScoreStats<T>>;
 
-    inline ScoreStatsMap<path> find_score_stats_paths(const path& dir)
+    //! Finds the score statistics files in `dir` for which `exists` holds.
+    template<class ExistsFn>
+    ScoreStatsMap<path> find_score_stats_paths(const path& dir, ExistsFn exists)
     {
         ScoreStatsMap<path> map{};
         for (const auto& name : {"bm25", "ql"}) {
@@ -128,6 +135,12 @@ namespace index {
         return map;
     }
 
+    inline ScoreStatsMap<path> find_score_stats_paths(const path& dir)
+    {
+        return find_score_stats_paths(
+            dir, [](const path& file) { return boost::filesystem::exists(file); });
+    }
+
     template<class T, class UnaryFun>
     auto transform_score_stats_map(const ScoreStatsMap<T>& map, UnaryFun f)
     {
@@ -148,6 +161,13 @@ namespace index {
         return new_map;
     }
 
+    //! A range of bytes within an index file.
+    struct File_Range {
+        path file;
+        std::ptrdiff_t offset;
+        std::ptrdiff_t size;
+    };
+
     struct posting_paths {
         path postings;
         path offsets;
@@ -168,12 +188,16 @@ namespace index {
     { return dir / "terms.txt"; }
     inline path term_map_path(const path& dir)
     { return dir / "terms.map"; }
+    inline path term_hash_path(const path& dir)
+    { return dir / "terms.hash"; }
     inline path term_doc_freq_path(const path& dir)
     { return dir / "terms.docfreq"; }
     inline path titles_path(const path& dir)
     { return dir / "titles.txt"; }
     inline path title_map_path(const path& dir)
     { return dir / "titles.map"; }
+    inline path title_table_path(const path& dir)
+    { return dir / "titles.table"; }
     inline path doc_sizes_path(const path& dir)
     { return dir / "doc.sizes"; }
     inline path term_occurrences_path(const path& dir)
@@ -182,6 +206,12 @@ namespace index {
     { return dir / fmt::format("{}.offsets", name); }
     inline path max_scores_path(const path& dir, const std::string& name)
     { return dir / fmt::format("{}.maxscore", name); }
+    inline path term_info_path(const path& dir)
+    { return dir / "terms.info"; }
+    inline path score_term_info_path(const path& dir, const std::string& name)
+    { return dir / fmt::format("{}.terminfo", name); }
+    inline path packed_index_path(const path& dir)
+    { return dir / "index.pack"; }
 
     inline quantized_score_tuple<path>
     score_paths(const path& dir, const std::string& name)
@@ -247,6 +277,19 @@ namespace index {
     };
 
     struct Properties {
+        //! Version of the index format.
+        /*!
+         * Version 1 indices (with no version property) have only lists with
+         * regular headers. Since version 2, lists may have extended headers
+         * (see `ir::Block_List_Format`), e.g., fixed-width headers.
+         * Since version 3, offset and frequency tables may be bit-packed
+         * or Elias-Fano coded (see `irk::CompactTableHeaderFlags`), document
+         * sizes are stored in a bit-packed table, and the lexicon is stored
+         * in the directory-based format with persisted block leaders.
+         */
+        static constexpr int32_t current_version = 3;
+
+        int32_t version = current_version;
         int32_t skip_block_size{};
         int64_t occurrences_count{};
         int32_t document_count{};
@@ -257,6 +300,7 @@ namespace index {
         std::optional<int32_t> shard_count{};
 
         struct Fields {
+            static constexpr auto Version = "version";
             static constexpr auto Documents = "documents";
             static constexpr auto Occurrences = "occurrences";
             static constexpr auto SkipBlockSize = "skip_block_size";
@@ -301,6 +345,16 @@ namespace index {
         static Properties read(const nlohmann::json& jprop)
         {
             Properties properties;
+            properties.version = 1;
+            if (auto pos = jprop.find(Fields::Version); pos != jprop.end()) {
+                properties.version = pos.value();
+            }
+            if (properties.version > current_version) {
+                throw std::runtime_error(fmt::format(
+                    "index format version {} is not supported (latest: {})",
+                    properties.version,
+                    current_version));
+            }
             properties.document_count = read_property<int32_t>(
                 jprop, Fields::Documents);
             properties.occurrences_count = read_property<int64_t>(
@@ -341,6 +395,7 @@ namespace index {
         {
             std::ofstream ofs(properties_path(index_dir).c_str());
             nlohmann::json jprop;
+            jprop[Fields::Version] = properties.version;
             jprop[Fields::Documents] = properties.document_count;
             jprop[Fields::Occurrences] = properties.occurrences_count;
             jprop[Fields::SkipBlockSize] = properties.skip_block_size;
@@ -376,6 +431,45 @@ namespace index {
             reinterpret_cast<const T*>(vec.data()), size);
     }
 
+    //! Writes term records (see `Term_Info`) based on the tables in `dir`.
+    /*!
+     * Must be called after offsets, document frequencies, and occurrences
+     * have been written.
+     */
+    inline void write_term_info(const path& dir)
+    {
+        auto document_offsets =
+            load_compact_table<offset_t>(doc_ids_off_path(dir)).to_vector();
+        auto count_offsets =
+            load_compact_table<offset_t>(doc_counts_off_path(dir)).to_vector();
+        auto frequencies =
+            load_compact_table<frequency_t>(term_doc_freq_path(dir)).to_vector();
+        auto occurrences =
+            load_compact_table<frequency_t>(term_occurrences_path(dir))
+                .to_vector();
+        auto info = build_term_info(document_offsets,
+                                    file_size(doc_ids_path(dir)),
+                                    count_offsets,
+                                    file_size(doc_counts_path(dir)),
+                                    frequencies,
+                                    occurrences);
+        std::ofstream out(term_info_path(dir).c_str());
+        write_records<Term_Info>(out, info);
+    }
+
+    //! Writes score records (see `Score_Term_Info`) of score function `name`.
+    inline void write_score_term_info(const path& dir, const std::string& name)
+    {
+        auto paths = score_paths(dir, name);
+        auto offsets = load_compact_table<offset_t>(paths.offsets).to_vector();
+        auto max_scores =
+            load_compact_table<std::uint32_t>(paths.max_scores).to_vector();
+        auto info = build_score_term_info(
+            offsets, file_size(paths.postings), max_scores);
+        std::ofstream out(score_term_info_path(dir, name).c_str());
+        write_records<Score_Term_Info>(out, info);
+    }
+
 }  // namespace index
 
 template<class DocumentCodec = irk::stream_vbyte_codec<index::document_t>,
@@ -398,7 +492,7 @@ public:
                                                irk::vbyte_codec<frequency_type>,
                                                memory_view>;
     using score_table_type = compact_table<score_type, irk::vbyte_codec<score_type>, memory_view>;
-    using size_table_type      = std::vector<int32_t>;
+    using size_table_type      = compact_table<int32_t, irk::vbyte_codec<int32_t>, memory_view>;
     using array_stream         = boost::iostreams::stream_buffer<
         boost::iostreams::basic_array_source<char>>;
     using score_tuple_type    = quantized_score_tuple<memory_view,
@@ -408,6 +502,10 @@ public:
     using frequency_list_type = ir::Standard_Block_Payload_List<frequency_type,
                                                                 frequency_codec_type>;
     using score_list_type     = ir::Standard_Block_Payload_List<score_type, score_codec_type>;
+    using arena_document_list_type  = ir::Arena_Block_Document_List<document_codec_type>;
+    using arena_frequency_list_type = ir::Arena_Block_Payload_List<frequency_type,
+                                                                   frequency_codec_type>;
+    using arena_score_list_type = ir::Arena_Block_Payload_List<score_type, score_codec_type>;
 
     basic_inverted_index_view() = default;
     basic_inverted_index_view(const basic_inverted_index_view&) = default;
@@ -422,13 +520,14 @@ public:
     explicit basic_inverted_index_view(std::shared_ptr<DataSourceT const> data)
         : data_handle_(data),
           dir_(data->dir()),
+          file_range_([data](auto const& file, auto offset, auto size) {
+              return data->file_range(file, offset, size);
+          }),
           documents_view_(data->documents_view()),
           counts_view_(data->counts_view()),
           document_offsets_(data->document_offsets_view()),
           count_offsets_(data->count_offsets_view()),
-          document_sizes_(compact_table<int32_t, irk::vbyte_codec<int32_t>, memory_view>(
-                              data->document_sizes_view())
-                              .to_vector()),
+          document_sizes_(data->document_sizes_view()),
           term_collection_frequencies_(data->term_collection_frequencies_view()),
           term_collection_occurrences_(data->term_collection_occurrences_view()),
           term_map_(std::move(load_lexicon(data->term_map_view()))),
@@ -438,6 +537,10 @@ public:
         EXPECTS(
             static_cast<ptrdiff_t>(document_offsets_.size()) == term_count_);
         EXPECTS(static_cast<ptrdiff_t>(count_offsets_.size()) == term_count_);
+        if (not document_sizes_.is_random_access()) {
+            // Legacy block-compressed sizes would decode a block per lookup.
+            decoded_document_sizes_ = document_sizes_.to_vector();
+        }
 
         score_stats_ = index::transform_score_stats_map(
             data->score_stats_views(),
@@ -449,6 +552,23 @@ public:
                                score_table_type(tuple.max_scores)};
             scores_.emplace(std::make_pair(name, t));
         }
+        if (auto term_info = data->term_info_view(); term_info.has_value()) {
+            term_info_ = index::record_span<index::Term_Info>(*term_info);
+            EXPECTS(static_cast<ptrdiff_t>(term_info_.size()) == term_count_);
+        }
+        for (const auto& [name, view] : data->score_term_info_views()) {
+            auto info = index::record_span<index::Score_Term_Info>(view);
+            EXPECTS(static_cast<ptrdiff_t>(info.size()) == term_count_);
+            score_term_info_.emplace(name, info);
+        }
+        if (auto term_hash = data->term_hash_view(); term_hash.has_value()) {
+            term_hash_ = load_hash_dictionary(*term_hash);
+            EXPECTS(term_hash_->size() == term_count_);
+        }
+        if (auto title_table = data->title_table_view(); title_table.has_value()) {
+            title_table_ = load_string_table(*title_table);
+            EXPECTS(title_table_->size() == title_map_.size());
+        }
         default_score_ = data->default_score();
         auto props = index::Properties::read(data->properties_view());
         document_count_ = props.document_count;
@@ -466,19 +586,20 @@ public:
         return gsl::make_span(this, 1);
     }
 
+    //! Returns the size of `doc`, read directly from the mapped size table.
     size_type document_size(document_type doc) const
     {
-        return document_sizes_[doc];
+        if (decoded_document_sizes_.empty()) { return document_sizes_[doc]; }
+        return decoded_document_sizes_[doc];
     }
 
-    auto document_sizes() const { return document_sizes_; }
+    const size_table_type& document_sizes() const { return document_sizes_; }
 
     auto documents(term_id_type term_id) const
     {
         EXPECTS(term_id < term_count_);
-        auto length = term_collection_frequencies_[term_id];
-        return document_list_type{
-            term_id, select(term_id, document_offsets_, documents_view_), length};
+        auto length = term_collection_frequency(term_id);
+        return document_list_type{term_id, document_memory(term_id), length};
     }
 
     auto documents(const std::string& term) const
@@ -492,8 +613,8 @@ public:
     auto frequencies(term_id_type term_id) const
     {
         EXPECTS(term_id < term_count_);
-        auto length = term_collection_frequencies_[term_id];
-        return frequency_list_type{term_id, select(term_id, count_offsets_, counts_view_), length};
+        auto length = term_collection_frequency(term_id);
+        return frequency_list_type{term_id, count_memory(term_id), length};
     }
 
     auto frequencies(const std::string& term) const
@@ -507,12 +628,8 @@ public:
     auto scores(term_id_type term_id) const
     {
         EXPECTS(term_id < term_count_);
-        auto length = term_collection_frequencies_[term_id];
-        return score_list_type(term_id,
-                               select(term_id,
-                                      scores_.at(default_score_).offsets,
-                                      scores_.at(default_score_).postings),
-                               length);
+        auto length = term_collection_frequency(term_id);
+        return score_list_type(term_id, score_memory(term_id, default_score_), length);
     }
 
     auto scores(const std::string& term) const
@@ -526,12 +643,8 @@ public:
     auto scores(term_id_type term_id, const std::string& score_fun_name) const
     {
         EXPECTS(term_id < term_count_);
-        auto length = term_collection_frequencies_[term_id];
-        return score_list_type{term_id,
-                               select(term_id,
-                                      scores_.at(score_fun_name).offsets,
-                                      scores_.at(score_fun_name).postings),
-                               length};
+        auto length = term_collection_frequency(term_id);
+        return score_list_type{term_id, score_memory(term_id, score_fun_name), length};
     }
 
     auto score_max(const std::string& name) const
@@ -552,22 +665,20 @@ public:
     auto postings(term_id_type term_id) const
     {
         EXPECTS(term_id < term_count_);
-        auto length = term_collection_frequencies_[term_id];
+        auto length = term_collection_frequency(term_id);
         if (length == 0) {
             document_list_type documents;
             frequency_list_type frequencies;
             return posting_list_view{documents, frequencies};
         }
-        auto documents = document_list_type{
-            term_id, select(term_id, document_offsets_, documents_view_), length};
-        auto counts = frequency_list_type{
-            term_id, select(term_id, count_offsets_, counts_view_), length};
+        auto documents = document_list_type{term_id, document_memory(term_id), length};
+        auto counts = frequency_list_type{term_id, count_memory(term_id), length};
         return posting_list_view{documents, counts};
     }
 
-    auto postings(const std::string& term) const
+    //! Returns the postings of a term, or an empty list if `idopt` is empty.
+    auto postings(std::optional<term_id_type> const& idopt) const
     {
-        auto idopt = term_id(term);
         if (not idopt.has_value()) {
             document_list_type documents;
             frequency_list_type frequencies;
@@ -576,6 +687,11 @@ public:
         return postings(*idopt);
     }
 
+    auto postings(const std::string& term) const
+    {
+        return postings(term_id(term));
+    }
+
     auto scored_postings(term_id_type term_id) const
     {
         return scored_postings(term_id, default_score_);
@@ -587,18 +703,14 @@ public:
         if (scores_.empty()) {
             throw std::runtime_error("scores not loaded");
         }
-        auto length = term_collection_frequencies_[term_id];
+        auto length = term_collection_frequency(term_id);
         if (length == 0) {
             document_list_type documents;
             score_list_type scores;
             return posting_list_view{documents, scores};
         }
-        auto documents = document_list_type{
-            term_id, select(term_id, document_offsets_, documents_view_), length};
-        auto scores = score_list_type{
-            term_id,
-            select(term_id, scores_.at(score).offsets, scores_.at(score).postings),
-            length};
+        auto documents = document_list_type{term_id, document_memory(term_id), length};
+        auto scores = score_list_type{term_id, score_memory(term_id, score), length};
         return posting_list_view{documents, scores};
     }
 
@@ -614,10 +726,67 @@ public:
         return scored_postings(*idopt);
     }
 
+    //! Returns the postings of a term, with lists decoded into `arena`.
+    /*!
+     * Unlike `postings`, neither opening the lists nor decoding their blocks
+     * allocates on the heap (see `ir::Arena_Block_List`). The postings are
+     * valid until `arena` is reset.
+     */
+    auto postings(term_id_type term_id, ir::Arena& arena) const
+    {
+        EXPECTS(term_id < term_count_);
+        auto length = term_collection_frequency(term_id);
+        if (length == 0) {
+            return posting_list_view{arena_document_list_type{}, arena_frequency_list_type{}};
+        }
+        return posting_list_view{
+            arena_document_list_type{term_id, document_memory(term_id), length, arena},
+            arena_frequency_list_type{term_id, count_memory(term_id), length, arena}};
+    }
+
+    //! Returns the postings of a term decoded into `arena`, or an empty list
+    //! if `idopt` is empty.
+    auto postings(std::optional<term_id_type> const& idopt, ir::Arena& arena) const
+    {
+        if (not idopt.has_value()) {
+            return posting_list_view{arena_document_list_type{}, arena_frequency_list_type{}};
+        }
+        return postings(*idopt, arena);
+    }
+
+    //! Returns the scored postings of a term, with lists decoded into `arena`.
+    /*!
+     * \see postings(term_id_type, ir::Arena&)
+     */
+    auto scored_postings(term_id_type term_id, const std::string& score, ir::Arena& arena) const
+    {
+        EXPECTS(term_id < term_count_);
+        if (scores_.empty()) {
+            throw std::runtime_error("scores not loaded");
+        }
+        auto length = term_collection_frequency(term_id);
+        if (length == 0) {
+            return posting_list_view{arena_document_list_type{}, arena_score_list_type{}};
+        }
+        return posting_list_view{
+            arena_document_list_type{term_id, document_memory(term_id), length, arena},
+            arena_score_list_type{term_id, score_memory(term_id, score), length, arena}};
+    }
+
+    //! Returns the postings of a term scored with the default score function
+    //! and decoded into `arena`, or an empty list if `idopt` is empty.
+    auto scored_postings(std::optional<term_id_type> const& idopt, ir::Arena& arena) const
+    {
+        if (not idopt.has_value()) {
+            return posting_list_view{arena_document_list_type{}, arena_score_list_type{}};
+        }
+        return scored_postings(*idopt, default_score_, arena);
+    }
+
     auto term_scorer(term_id_type term_id, score::bm25_tag) const
     {
         return score::BM25TermScorer{*this,
-                                     score::bm25_scorer(term_collection_frequencies_[term_id],
+                                     score::bm25_scorer(term_collection_frequency(term_id),
                                                         document_count_,
                                                         avg_document_size_)};
     }
@@ -632,9 +801,55 @@ public:
 
     std::optional<term_id_type> term_id(const std::string& term) const
     {
+        if (term_hash_.has_value()) {
+            return term_hash_->index_at(term);
+        }
         return term_map_.index_at(term);
     }
 
+    //! Returns the IDs of multiple terms, in the order of `terms`.
+    /*!
+     * Without a term hash, the lexicon resolves all terms in a single pass
+     * over the blocks they fall into.
+     */
+    std::vector<std::optional<term_id_type>>
+    term_ids(gsl::span<std::string const> terms) const
+    {
+        if (term_hash_.has_value()) {
+            std::vector<std::optional<term_id_type>> ids;
+            ids.reserve(terms.size());
+            for (const auto& term : terms) {
+                ids.push_back(term_hash_->index_at(term));
+            }
+            return ids;
+        }
+        auto indices = term_map_.indices_at(terms);
+        return std::vector<std::optional<term_id_type>>(
+            indices.begin(), indices.end());
+    }
+
+    //! Returns the IDs `[first, last)` of all terms starting with `prefix`.
+    /*!
+     * Term IDs follow the lexicographical order of terms, so the terms
+     * matching a prefix always form a contiguous interval.
+     */
+    std::pair<term_id_type, term_id_type>
+    prefix_term_ids(const std::string& prefix) const
+    {
+        auto [first, last] = term_map_.prefix_range(prefix);
+        return {static_cast<term_id_type>(first),
+                static_cast<term_id_type>(last)};
+    }
+
+    //! Returns the IDs `[first, last)` of all terms in `[lo, hi)`.
+    std::pair<term_id_type, term_id_type>
+    term_id_range(const std::string& lo, const std::string& hi) const
+    {
+        auto [first, last] = term_map_.range(lo, hi);
+        return {static_cast<term_id_type>(first),
+                static_cast<term_id_type>(last)};
+    }
+
     std::string term(const term_id_type& id) const
     {
         return term_map_.key_at(id);
@@ -652,30 +867,45 @@ public:
 
     int32_t term_collection_frequency(term_id_type term_id) const
     {
+        if (not term_info_.empty()) {
+            return term_info_[term_id].document_frequency;
+        }
         return term_collection_frequencies_[term_id];
     }
 
     int32_t term_collection_frequency(const std::string& term) const
     {
         if (auto id = term_id(term); id.has_value()) {
-            return term_collection_frequencies_[*id];
+            return term_collection_frequency(*id);
         }
         return 0;
     }
 
     int32_t term_occurrences(term_id_type term_id) const
     {
+        if (not term_info_.empty()) {
+            return term_info_[term_id].occurrences;
+        }
         return term_collection_occurrences_[term_id];
     }
 
     int32_t term_occurrences(const std::string& term) const
     {
         if (auto id = term_id(term); id.has_value()) {
-            return term_collection_occurrences_[*id];
+            return term_occurrences(*id);
         }
         return 0;
     }
 
+    //! Returns the maximum quantized score of a term's list.
+    score_type max_score(term_id_type term_id, const std::string& name) const
+    {
+        if (auto pos = score_term_info_.find(name); pos != score_term_info_.end()) {
+            return pos->second[term_id].max_score;
+        }
+        return scores_.at(name).max_scores[term_id];
+    }
+
     int32_t term_count() const { return term_map_.size(); }
     int64_t occurrences_count() const { return occurrences_count_; }
     int skip_block_size() const { return block_size_; }
@@ -690,6 +920,20 @@ public:
     {
         return title_map_;
     }
+
+    //! Returns the title of a document.
+    /*!
+     * Resolved in constant time if the index has a title table; otherwise,
+     * it is decoded from the title lexicon.
+     */
+    std::string title(document_type document) const
+    {
+        if (title_table_.has_value()) {
+            return std::string(title_table_->key_at(document));
+        }
+        return title_map_.key_at(document);
+    }
+
     const auto& score_data(const std::string& name) const
     {
         return scores_.at(name);
@@ -711,6 +955,34 @@ public:
         return copy_list(counts_view_, offset, out);
     }
 
+    //! Returns where the lists of a term are stored: its documents,
+    //! frequencies, and each loaded score list.
+    /*!
+     * The ranges are translated by the source, so they point into the files
+     * the lists are actually read from, e.g., the packed file of a packed
+     * index. No list data is accessed, so this can be used to read lists
+     * ahead of time, e.g., with a `block_prefetcher`.
+     */
+    std::vector<index::File_Range> posting_ranges(term_id_type term_id) const
+    {
+        EXPECTS(term_id < term_count_);
+        std::vector<index::File_Range> ranges;
+        if (term_collection_frequency(term_id) == 0) {
+            return ranges;
+        }
+        auto [document_offset, document_size] = document_range(term_id);
+        ranges.push_back(
+            file_range_(index::doc_ids_path(dir_), document_offset, document_size));
+        auto [count_offset, count_size] = count_range(term_id);
+        ranges.push_back(file_range_(index::doc_counts_path(dir_), count_offset, count_size));
+        for (const auto& entry : scores_) {
+            auto [offset, size] = score_range(term_id, entry.first);
+            ranges.push_back(
+                file_range_(index::score_paths(dir_, entry.first).postings, offset, size));
+        }
+        return ranges;
+    }
+
     std::vector<std::string> score_names() const
     {
         std::vector<std::string> names;
@@ -723,18 +995,26 @@ public:
 private:
     std::shared_ptr<void const> data_handle_;
     boost::filesystem::path dir_;
+    std::function<index::File_Range(boost::filesystem::path const&, std::ptrdiff_t, std::ptrdiff_t)>
+        file_range_;
     memory_view documents_view_;
     memory_view counts_view_;
     offset_table_type document_offsets_;
     offset_table_type count_offsets_;
     size_table_type document_sizes_;
+    std::vector<int32_t> decoded_document_sizes_{};
     index::ScoreStatsMap<gsl::span<const float>> score_stats_{};
     std::unordered_map<std::string, score_tuple_type> scores_;
     std::string default_score_;
     frequency_table_type term_collection_frequencies_;
     frequency_table_type term_collection_occurrences_;
+    gsl::span<index::Term_Info const> term_info_{};
+    std::unordered_map<std::string, gsl::span<index::Score_Term_Info const>>
+        score_term_info_{};
     lexicon<hutucker_codec<char>, memory_view> term_map_;
     lexicon<hutucker_codec<char>, memory_view> title_map_;
+    std::optional<hash_dictionary<memory_view>> term_hash_{};
+    std::optional<string_table<memory_view>> title_table_{};
     std::ptrdiff_t term_count_ = 0;
     std::ptrdiff_t document_count_ = 0;
     std::ptrdiff_t occurrences_count_ = 0;
@@ -758,7 +1038,8 @@ private:
         return size;
     }
 
-    memory_view select(term_id_type term_id,
+    //! Returns the offset and size of a list stored in `memory`.
+    std::pair<std::ptrdiff_t, std::ptrdiff_t> select(term_id_type term_id,
         const offset_table_type& offsets,
         const memory_view& memory) const
     {
@@ -766,7 +1047,54 @@ private:
         offset_t next_offset = (term_id + 1 < term_count_)
             ? offsets[term_id + 1]
             : memory.size();
-        return memory(offset, next_offset);
+        return {offset, next_offset - offset};
+    }
+
+    std::pair<std::ptrdiff_t, std::ptrdiff_t> document_range(term_id_type term_id) const
+    {
+        if (not term_info_.empty()) {
+            const auto& info = term_info_[term_id];
+            return {info.document_offset, info.document_list_size};
+        }
+        return select(term_id, document_offsets_, documents_view_);
+    }
+
+    std::pair<std::ptrdiff_t, std::ptrdiff_t> count_range(term_id_type term_id) const
+    {
+        if (not term_info_.empty()) {
+            const auto& info = term_info_[term_id];
+            return {info.count_offset, info.count_list_size};
+        }
+        return select(term_id, count_offsets_, counts_view_);
+    }
+
+    std::pair<std::ptrdiff_t, std::ptrdiff_t>
+    score_range(term_id_type term_id, const std::string& name) const
+    {
+        const auto& score = scores_.at(name);
+        if (auto pos = score_term_info_.find(name); pos != score_term_info_.end()) {
+            const auto& info = pos->second[term_id];
+            return {info.offset, info.list_size};
+        }
+        return select(term_id, score.offsets, score.postings);
+    }
+
+    memory_view document_memory(term_id_type term_id) const
+    {
+        auto [offset, size] = document_range(term_id);
+        return documents_view_.range(offset, size);
+    }
+
+    memory_view count_memory(term_id_type term_id) const
+    {
+        auto [offset, size] = count_range(term_id);
+        return counts_view_.range(offset, size);
+    }
+
+    memory_view score_memory(term_id_type term_id, const std::string& name) const
+    {
+        auto [offset, size] = score_range(term_id, name);
+        return scores_.at(name).postings.range(offset, size);
     }
 };
 
@@ -825,8 +1153,23 @@ inline auto query_postings(
         decltype(index.postings(std::declval<std::string>()));
     std::vector<posting_list_type> postings;
     postings.reserve(query.size());
-    for (const auto& term : query) {
-        postings.push_back(index.postings(term));
+    for (const auto& term_id : index.term_ids(query)) {
+        postings.push_back(index.postings(term_id));
+    }
+    return postings;
+}
+
+//! Returns the posting lists of all terms starting with `prefix`.
+inline auto prefix_postings(
+    const irk::inverted_index_view& index, const std::string& prefix)
+{
+    using posting_list_type =
+        decltype(index.postings(std::declval<std::string>()));
+    auto [first, last] = index.prefix_term_ids(prefix);
+    std::vector<posting_list_type> postings;
+    postings.reserve(last - first);
+    for (auto term_id = first; term_id < last; ++term_id) {
+        postings.push_back(index.postings(term_id));
     }
     return postings;
 }
@@ -839,8 +1182,8 @@ inline auto fetched_query_postings(
         decltype(index.postings(std::declval<std::string>()).fetch());
     std::vector<posting_list_type> postings;
     postings.reserve(query.size());
-    for (const auto& term : query) {
-        postings.push_back(index.postings(term).fetch());
+    for (const auto& term_id : index.term_ids(query)) {
+        postings.push_back(index.postings(term_id).fetch());
     }
     return postings;
 }
@@ -906,8 +1249,8 @@ inline auto query_scored_postings(
         decltype(unscored[0].scored(std::declval<score_fn_type>()));
     std::vector<scored_list_type> postings;
     postings.reserve(query.size());
-    for (const auto& [idx, term] : iter::enumerate(query)) {
-        if (auto term_id = index.term_id(term); term_id.has_value()) {
+    for (const auto& [idx, term_id] : iter::enumerate(index.term_ids(query))) {
+        if (term_id.has_value()) {
             postings.push_back(unscored[idx].scored(
                 index.term_scorer(term_id.value(), score::bm25)));
         }
@@ -925,8 +1268,8 @@ inline auto query_scored_postings(
         decltype(unscored[0].scored(std::declval<score_fn_type>()));
     std::vector<scored_list_type> postings;
     postings.reserve(query.size());
-    for (const auto& [idx, term] : iter::enumerate(query)) {
-        if (auto term_id = index.term_id(term); term_id.has_value()) {
+    for (const auto& [idx, term_id] : iter::enumerate(index.term_ids(query))) {
+        if (term_id.has_value()) {
             postings.push_back(unscored[idx].scored(
                 index.term_scorer(term_id.value(), score::query_likelihood)));
         }
@@ -27,13 +27,19 @@
 #pragma once
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <iostream>
+#include <mutex>
 #include <optional>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include <spdlog/spdlog.h>
 
+#include <irkit/assert.hpp>
 #include <irkit/index/builder.hpp>
 #include <irkit/index/merger.hpp>
 #include <irkit/index/metadata.hpp>
@@ -43,6 +49,73 @@
 
 namespace irk::index {
 
+namespace detail::assembler {
+
+    //! A FIFO queue blocking producers when full and consumers when empty.
+    template<class T>
+    class bounded_queue {
+    public:
+        explicit bounded_queue(std::ptrdiff_t capacity) : capacity_(capacity)
+        {
+            EXPECTS(capacity > 0);
+        }
+
+        //! Waits for a free slot; returns `false` if the queue was aborted.
+        bool push(T value)
+        {
+            std::unique_lock lock(mutex_);
+            not_full_.wait(lock, [this]() {
+                return aborted_ || irk::sgnd(items_.size()) < capacity_;
+            });
+            if (aborted_) { return false; }
+            items_.push_back(std::move(value));
+            not_empty_.notify_one();
+            return true;
+        }
+
+        //! Waits for an item; returns `std::nullopt` once the queue is
+        //! closed and drained, or aborted.
+        std::optional<T> pop()
+        {
+            std::unique_lock lock(mutex_);
+            not_empty_.wait(
+                lock, [this]() { return aborted_ || closed_ || not items_.empty(); });
+            if (aborted_ || items_.empty()) { return std::nullopt; }
+            T value = std::move(items_.front());
+            items_.pop_front();
+            not_full_.notify_one();
+            return std::make_optional(std::move(value));
+        }
+
+        //! Signals that no more items will be pushed.
+        void close()
+        {
+            std::lock_guard lock(mutex_);
+            closed_ = true;
+            not_empty_.notify_all();
+        }
+
+        //! Wakes up and stops all producers and consumers.
+        void abort()
+        {
+            std::lock_guard lock(mutex_);
+            aborted_ = true;
+            not_empty_.notify_all();
+            not_full_.notify_all();
+        }
+
+    private:
+        std::ptrdiff_t capacity_;
+        std::deque<T> items_{};
+        std::mutex mutex_{};
+        std::condition_variable not_full_{};
+        std::condition_variable not_empty_{};
+        bool closed_ = false;
+        bool aborted_ = false;
+    };
+
+}  // namespace detail::assembler
+
 //! Builds an index in batches and merges them together on disk.
 //!
 //! See assemble() function documentation for the format of the input file.
@@ -63,12 +136,21 @@ public:
     using merger_type =
         irk::basic_index_merger<document_codec_type, frequency_codec_type>;
 
+    //! Collection lines of a single batch, excluding spam documents.
+    struct batch_type {
+        int number;
+        document_type first_id;
+        std::vector<std::string> documents;
+    };
+
 private:
     fs::path output_dir_;
     int batch_size_;
     int block_size_;
     int lexicon_block_size_;
     std::optional<std::unordered_set<std::string>> spam_;
+    ir::Block_List_Options list_options_;
+    int threads_;
 
 public:
     //! \param output_dir       final directory of the index
@@ -76,18 +158,23 @@ public:
     //! \param block_size       size of inverted list block (and skip length)
     //! \param document_codec   codec for document IDs
     //! \param frequency_codec  codec for frequencies
+    //! \param list_options     options of list representation
+    //! \param threads          number of batches built concurrently
     basic_index_assembler(
         fs::path output_dir,
         int batch_size,
         int block_size,
         int lexicon_block_size,
-        std::optional<std::unordered_set<std::string>> spam =
-            std::nullopt) noexcept
+        std::optional<std::unordered_set<std::string>> spam = std::nullopt,
+        ir::Block_List_Options list_options = {},
+        int threads = 1) noexcept
         : output_dir_(std::move(output_dir)),
           batch_size_(batch_size),
           block_size_(block_size),
           lexicon_block_size_(lexicon_block_size),
-          spam_(spam)
+          spam_(spam),
+          list_options_(list_options),
+          threads_(std::max(threads, 1))
     {}
 
     //! \brief Builds all batches and assembles the final index.
@@ -106,32 +193,121 @@ public:
 
         auto log = spdlog::get("buildindex");
 
-        int batch_number = 0;
-        std::vector<fs::path> batch_dirs;
-        document_type next_id(0);
-        while (input && input.peek() != EOF)
-        {
-            if (log) { log->info("Building batch {}", batch_number); }
-            fs::path batch_dir = work_dir / std::to_string(batch_number);
-            metadata batch_metadata(batch_dir);
-            next_id = build_batch(input, batch_metadata, next_id);
-            batch_dirs.push_back(std::move(batch_dir));
-            ++batch_number;
-        }
-        if (log) { log->info("Merging {} batches", batch_number); }
-        merger_type merger(output_dir_, batch_dirs, block_size_);
+        auto batch_dirs = build_batches(input, work_dir);
+        if (log) { log->info("Merging {} batches", batch_dirs.size()); }
+        merger_type merger(output_dir_, batch_dirs, block_size_, false, list_options_);
         merger.merge();
         auto term_map = build_lexicon(
             irk::index::terms_path(output_dir_), lexicon_block_size_);
         term_map.serialize(irk::index::term_map_path(output_dir_));
+        build_hash_dictionary(irk::index::terms_path(output_dir_))
+            .serialize(irk::index::term_hash_path(output_dir_));
         auto title_map = build_lexicon(
             irk::index::titles_path(output_dir_), lexicon_block_size_);
         title_map.serialize(irk::index::title_map_path(output_dir_));
+        build_string_table(irk::index::titles_path(output_dir_))
+            .serialize(irk::index::title_table_path(output_dir_));
         if (log) { log->info("Success!"); }
     }
 
+    //! Builds all batches in `work_dir`, and returns their directories.
+    //!
+    //! With a single thread, each batch is streamed from the input directly
+    //! into the builder. With more than one thread, the calling thread reads
+    //! batches and passes them to a pool of builders through a queue of at
+    //! most as many batches as there are builders. Thus, counting the batches being built
+    //! and the one being read, at most `2 * threads + 1` batches are held in
+    //! memory at once. Each batch is assigned its number and
+    //! document IDs when read, so the batches are identical to those built
+    //! sequentially.
+    std::vector<fs::path>
+    build_batches(std::istream& input, const fs::path& work_dir) const
+    {
+        auto log = spdlog::get("buildindex");
+        std::vector<fs::path> batch_dirs;
+        document_type next_id(0);
+        if (threads_ == 1) {
+            while (input && input.peek() != EOF) {
+                int batch_number = batch_dirs.size();
+                if (log) { log->info("Building batch {}", batch_number); }
+                batch_dirs.push_back(work_dir / std::to_string(batch_number));
+                next_id = build_batch(input, metadata(batch_dirs.back()), next_id);
+            }
+            return batch_dirs;
+        }
+
+        detail::assembler::bounded_queue<batch_type> queue(threads_);
+        std::exception_ptr error = nullptr;
+        std::mutex error_mutex;
+        std::vector<std::thread> builders;
+        for (int thread = 0; thread < threads_; ++thread) {
+            builders.emplace_back([&]() {
+                try {
+                    while (auto batch = queue.pop()) {
+                        if (log) { log->info("Building batch {}", batch->number); }
+                        build_batch(
+                            *batch,
+                            metadata(work_dir / std::to_string(batch->number)));
+                    }
+                } catch (...) {
+                    std::lock_guard lock(error_mutex);
+                    if (error == nullptr) { error = std::current_exception(); }
+                    queue.abort();
+                }
+            });
+        }
+        auto join = [&]() {
+            for (auto& builder : builders) { builder.join(); }
+        };
+
+        try {
+            while (input && input.peek() != EOF) {
+                int batch_number = batch_dirs.size();
+                auto batch = read_batch(input, batch_number, next_id);
+                next_id += batch.documents.size();
+                batch_dirs.push_back(work_dir / std::to_string(batch_number));
+                if (not queue.push(std::move(batch))) { break; }
+            }
+        } catch (...) {
+            queue.abort();
+            join();
+            throw;
+        }
+        queue.close();
+        join();
+        if (error != nullptr) { std::rethrow_exception(error); }
+        return batch_dirs;
+    }
+
+    //! Reads the next batch of at most `batch_size` documents.
+    //!
+    //! \param[in] input            collection stream; see assemble() for
+    //!                             more details
+    //! \param[in] batch_number     number of the batch
+    //! \param[in] first_id         ID of the first document in the batch
+    batch_type read_batch(
+        std::istream& input, int batch_number, document_type first_id) const
+    {
+        batch_type batch{batch_number, first_id, {}};
+        std::string line;
+        while (irk::sgnd(batch.documents.size()) < batch_size_) {
+            if (not std::getline(input, line)) { break; }
+            if (spam_.has_value()) {
+                std::istringstream linestream(line);
+                std::string title;
+                linestream >> title;
+                if (spam_->find(title) != spam_->end()) { continue; }
+            }
+            batch.documents.push_back(std::move(line));
+        }
+        return batch;
+    }
+
     //! Builds a single batch.
     //!
+    //! Documents are read directly into the builder, without buffering the
+    //! text of the batch.
+    //!
     //! \param[in] input            collection stream; see assemble() for
     //!                             more details
     //! \param[in] batch_metadata   information about file paths
@@ -139,6 +315,63 @@ public:
         std::istream& input,
         metadata batch_metadata,
         document_type next_id) const
+    {
+        return build_batch_from(
+            std::move(batch_metadata),
+            [&](builder_type& builder, std::ostream& of_titles) {
+                std::string line;
+                while (irk::sgnd(builder.size()) < batch_size_) {
+                    if (not std::getline(input, line)) { break; }
+                    std::istringstream linestream(line);
+                    std::string title;
+                    linestream >> title;
+                    if (spam_.has_value() && spam_->find(title) != spam_->end()) {
+                        continue;
+                    }
+                    add_document(builder, of_titles, title, linestream, next_id++);
+                }
+                return next_id;
+            });
+    }
+
+    //! Builds a single batch that has been already read.
+    //!
+    //! \param[in] batch            documents of the batch
+    //! \param[in] batch_metadata   information about file paths
+    void build_batch(const batch_type& batch, metadata batch_metadata) const
+    {
+        build_batch_from(
+            std::move(batch_metadata),
+            [&](builder_type& builder, std::ostream& of_titles) {
+                document_type next_id = batch.first_id;
+                for (const auto& line : batch.documents) {
+                    std::istringstream linestream(line);
+                    std::string title;
+                    linestream >> title;
+                    add_document(builder, of_titles, title, linestream, next_id++);
+                }
+                return next_id;
+            });
+    }
+
+private:
+    static void add_document(builder_type& builder,
+                             std::ostream& of_titles,
+                             const std::string& title,
+                             std::istream& terms,
+                             document_type id)
+    {
+        builder.add_document(id);
+        of_titles << title << '\n';
+        std::string term;
+        while (terms >> term) { builder.add_term(term); }
+    }
+
+    //! Builds a batch of documents passed to the builder by `add_documents`,
+    //! and returns the ID following the last added document.
+    template<class AddDocuments>
+    document_type
+    build_batch_from(metadata batch_metadata, AddDocuments add_documents) const
     {
         if (not fs::exists(batch_metadata.dir))
         {
@@ -157,21 +390,8 @@ public:
             batch_metadata.term_occurrences.c_str());
         std::ofstream of_properties(batch_metadata.properties.c_str());
 
-        builder_type builder(block_size_);
-        std::string line;
-        while (irk::sgnd(builder.size()) < batch_size_) {
-            if (not std::getline(input, line)) { break; }
-            std::istringstream linestream(line);
-            std::string title;
-            linestream >> title;
-            if (spam_.has_value() && spam_->find(title) != spam_->end()) {
-                continue;
-            }
-            builder.add_document(next_id++);
-            of_titles << title << '\n';
-            std::string term;
-            while (linestream >> term) { builder.add_term(term); }
-        }
+        builder_type builder(block_size_, list_options_);
+        document_type next_id = add_documents(builder, of_titles);
 
         builder.sort_terms();
         builder.write_terms(of_terms);
@@ -189,7 +409,6 @@ public:
         auto title_map = build_lexicon(
             irk::index::titles_path(batch_metadata.dir), lexicon_block_size_);
         title_map.serialize(irk::index::title_map_path(batch_metadata.dir));
-
         return next_id;
     }
 };
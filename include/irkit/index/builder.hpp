@@ -67,6 +67,7 @@ private:
     };
 
     int block_size_;
+    ir::Block_List_Options list_options_;
     document_type current_doc_ = 0;
     int64_t all_occurrences_ = 0;
     std::optional<std::vector<term_type>> sorted_terms_;
@@ -74,10 +75,12 @@ private:
     std::vector<frequency_type> term_occurrences_;
     std::vector<frequency_type> document_sizes_;
     std::unordered_map<term_type, term_id_type> term_map_;
+    std::vector<std::vector<typename document_list_builder_type::size_type>> block_ends_;
 
 public:
-    explicit basic_index_builder(int block_size = 64)
-        : block_size_(block_size)
+    explicit basic_index_builder(
+        int block_size = 64, ir::Block_List_Options list_options = {})
+        : block_size_(block_size), list_options_(list_options)
     {}
 
     //! Initiates a new document with an incremented ID.
@@ -167,16 +170,42 @@ public:
         {
             offsets.push_back(offset);
             term_id_type term_id = term_map_[term];
-            document_list_builder_type list_builder(block_size_);
+            document_list_builder_type list_builder(block_size_, list_options_);
+            list_builder.set_document_count(size());
             for (const auto& posting : postings_[term_id]) {
                 list_builder.add(posting.doc);
             }
+            if (list_options_.variable_blocks) {
+                if (block_ends_.size() < postings_.size()) {
+                    block_ends_.resize(postings_.size());
+                }
+                block_ends_[term_id] = list_builder.partition();
+            }
             offset += list_builder.write(out);
         }
-        offset_table<> offset_table = build_offset_table<>(offsets);
+        auto offset_table = build_elias_fano_table(offsets);
         off << offset_table;
     }
 
+    //! Returns the block ends of the document list of the given term.
+    /*!
+     * The partition computed in `write_document_ids` is reused; it is
+     * computed here only if document IDs have not been written yet.
+     */
+    auto document_partition(term_id_type term_id)
+        -> std::vector<typename document_list_builder_type::size_type>
+    {
+        if (static_cast<std::size_t>(term_id) < block_ends_.size() && not block_ends_[term_id].empty()) {
+            return block_ends_[term_id];
+        }
+        document_list_builder_type document_builder(block_size_, list_options_);
+        document_builder.set_document_count(size());
+        for (const auto& posting : postings_[term_id]) {
+            document_builder.add(posting.doc);
+        }
+        return document_builder.partition();
+    }
+
     //! Writes term-document frequencies (tf).
     void write_document_counts(std::ostream& out, std::ostream& off)
     {
@@ -186,13 +215,16 @@ public:
         for (auto& term : sorted_terms_.value()) {
             offsets.push_back(offset);
             term_id_type term_id = term_map_[term];
-            frequency_list_builder_type list_builder(block_size_);
+            frequency_list_builder_type list_builder(block_size_, list_options_);
+            if (list_options_.variable_blocks) {
+                list_builder.set_partition(document_partition(term_id));
+            }
             for (const auto& posting : postings_[term_id]) {
                 list_builder.add(posting.freq);
             }
             offset += list_builder.write(out);
         }
-        offset_table<> offset_table = build_offset_table<>(offsets);
+        auto offset_table = build_elias_fano_table(offsets);
         off << offset_table;
     }
 
@@ -206,14 +238,14 @@ public:
             term_id_type term_id = term_map_[term];
             dfs.push_back(document_frequency(term_id));
         }
-        auto compact_term_dfs = irk::build_compact_table<frequency_type>(dfs);
+        auto compact_term_dfs = irk::build_packed_table<frequency_type>(dfs);
         out << compact_term_dfs;
     }
 
     //! Writes document sizes.
     void write_document_sizes(std::ostream& out) const
     {
-        auto compact_sizes = irk::build_compact_table<frequency_type>(
+        auto compact_sizes = irk::build_packed_table<frequency_type>(
             document_sizes_);
         out << compact_sizes;
     }
@@ -221,7 +253,7 @@ public:
     //! Writes document sizes.
     void write_term_occurrences(std::ostream& out) const
     {
-        auto compact_table = irk::build_compact_table<frequency_type>(
+        auto compact_table = irk::build_packed_table<frequency_type>(
             term_occurrences_);
         out << compact_table;
     }
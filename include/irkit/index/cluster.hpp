@@ -52,6 +52,9 @@ public:
         for (const auto& shard_source : source->shards()) {
             shards_.emplace_back(shard_source);
         }
+        if (auto term_hash = source->term_hash_view(); term_hash.has_value()) {
+            term_hash_ = load_hash_dictionary(*term_hash);
+        }
 
         score_stats_ = index::transform_score_stats_map(
             source->score_stats_views(),
@@ -68,9 +71,27 @@ public:
 
     [[nodiscard]] auto term_id(std::string const& term) const -> std::optional<term_id_type>
     {
+        if (term_hash_.has_value()) {
+            return term_hash_->index_at(term);
+        }
         return term_map_.index_at(term);
     }
 
+    [[nodiscard]] auto term_ids(gsl::span<std::string const> terms) const
+        -> std::vector<std::optional<term_id_type>>
+    {
+        if (term_hash_.has_value()) {
+            std::vector<std::optional<term_id_type>> ids;
+            ids.reserve(terms.size());
+            for (auto const& term : terms) {
+                ids.push_back(term_hash_->index_at(term));
+            }
+            return ids;
+        }
+        auto indices = term_map_.indices_at(terms);
+        return std::vector<std::optional<term_id_type>>(indices.begin(), indices.end());
+    }
+
     [[nodiscard]] auto term(term_id_type const& id) const -> std::string
     {
         return term_map_.key_at(id);
@@ -133,6 +154,7 @@ private:
     frequency_table_type term_collection_frequencies_;
     frequency_table_type term_collection_occurrences_;
     lexicon<hutucker_codec<char>, memory_view> term_map_;
+    std::optional<hash_dictionary<memory_view>> term_hash_{};
     index::ScoreStatsMap<gsl::span<float const>> score_stats_{};
 };
 
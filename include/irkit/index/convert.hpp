@@ -0,0 +1,201 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <spdlog/spdlog.h>
+
+#include <irkit/compacttable.hpp>
+#include <irkit/index.hpp>
+#include <irkit/index/source.hpp>
+#include <irkit/index/types.hpp>
+#include <irkit/list/standard_block_list.hpp>
+
+namespace irk::index {
+
+namespace detail::convert {
+
+    //! Re-encodes a list with the same blocks, codec, and representation.
+    template<class List>
+    auto rewrite_list(List const& list, ir::Block_List_Options options, std::ostream& out)
+        -> std::streamsize
+    {
+        using builder_type = ir::Standard_Block_List_Builder<typename List::value_type,
+                                                             typename List::codec_type,
+                                                             List::is_delta_encoded()>;
+        options.variable_blocks = list.has_variable_blocks();
+        builder_type builder(list.block_size(), options);
+        if constexpr (List::is_delta_encoded()) {
+            builder.set_bitmap(list.is_bitmap());
+        }
+        if (list.has_variable_blocks()) {
+            auto block_ends = list.block_ends();
+            builder.set_partition({block_ends.begin(), block_ends.end()});
+        }
+        for (auto value : list) {
+            builder.add(value);
+        }
+        return builder.write(out);
+    }
+
+    //! Returns whether a list rewritten with `options` has an extended header.
+    template<class List>
+    auto has_extended_header(List const& list, ir::Block_List_Options options) -> bool
+    {
+        auto format = list.format();
+        format.flags &= ~ir::Block_List_Format::Fixed_Width;
+        return options.fixed_width || not format.is_default();
+    }
+
+    //! Rewrites all lists, and returns whether any of them has an extended header.
+    /*!
+     * Offsets are written as an Elias-Fano table, unless `legacy_tables` is set,
+     * in which case the block-compressed table readable by all versions is used.
+     */
+    template<class ListFn>
+    auto rewrite_lists(term_id_t term_count,
+                       ListFn list_fn,
+                       ir::Block_List_Options options,
+                       bool legacy_tables,
+                       path const& lists_path,
+                       path const& offsets_path) -> bool
+    {
+        std::ofstream out(lists_path.c_str(), std::ios::binary);
+        std::vector<std::size_t> offsets;
+        std::size_t offset = 0;
+        bool extended = false;
+        for (term_id_t term_id = 0; term_id < term_count; ++term_id) {
+            offsets.push_back(offset);
+            auto list = list_fn(term_id);
+            extended = extended || has_extended_header(list, options);
+            offset += rewrite_list(list, options, out);
+        }
+        if (legacy_tables) {
+            irk::io::dump(irk::build_offset_table(offsets), offsets_path);
+        } else {
+            irk::io::dump(irk::build_elias_fano_table(offsets), offsets_path);
+        }
+        return extended;
+    }
+
+}  // namespace detail::convert
+
+//! Rewrites the lists of the index in `input_dir` into `output_dir`.
+/*!
+ * Lists are written with fixed-width headers and Elias-Fano offset tables,
+ * unless `legacy_headers` is set. All other files are copied, except for a
+ * packed index, which would still hold the unconverted lists.
+ *
+ * \throws std::invalid_argument    if the directories are the same
+ */
+inline void
+convert_lists(path const& input_dir, path const& output_dir, bool legacy_headers = false)
+{
+    using detail::convert::rewrite_lists;
+    if (boost::filesystem::exists(output_dir)
+        && boost::filesystem::equivalent(input_dir, output_dir)) {
+        throw std::invalid_argument("Input and output directories must differ");
+    }
+    boost::filesystem::create_directories(output_dir);
+
+    auto score_names = all_score_names(input_dir);
+    auto data = irtl::value(Inverted_Index_Mapped_Source::from(input_dir, score_names));
+    inverted_index_view index(data);
+    ir::Block_List_Options options{};
+    options.fixed_width = not legacy_headers;
+
+    std::set<path> rewritten = {doc_ids_path(output_dir),
+                                doc_ids_off_path(output_dir),
+                                doc_counts_path(output_dir),
+                                doc_counts_off_path(output_dir),
+                                properties_path(output_dir),
+                                term_info_path(output_dir),
+                                packed_index_path(output_dir)};
+    for (auto const& name : score_names) {
+        auto paths = score_paths(output_dir, name);
+        rewritten.insert(paths.postings);
+        rewritten.insert(paths.offsets);
+        rewritten.insert(score_term_info_path(output_dir, name));
+    }
+    for (auto const& entry : boost::filesystem::directory_iterator(input_dir)) {
+        auto target = output_dir / entry.path().filename();
+        if (boost::filesystem::is_regular_file(entry.path()) && rewritten.count(target) == 0) {
+            boost::filesystem::copy_file(
+                entry.path(), target, boost::filesystem::copy_option::overwrite_if_exists);
+        }
+    }
+
+    auto log = spdlog::get("convert-lists");
+    term_id_t term_count = index.term_count();
+    if (log) { log->info("Converting document lists"); }
+    bool extended = false;
+    extended |= rewrite_lists(term_count,
+                              [&](auto term_id) { return index.documents(term_id); },
+                              options,
+                              legacy_headers,
+                              doc_ids_path(output_dir),
+                              doc_ids_off_path(output_dir));
+    if (log) { log->info("Converting frequency lists"); }
+    extended |= rewrite_lists(term_count,
+                              [&](auto term_id) { return index.frequencies(term_id); },
+                              options,
+                              legacy_headers,
+                              doc_counts_path(output_dir),
+                              doc_counts_off_path(output_dir));
+    for (auto const& name : score_names) {
+        if (log) { log->info("Converting {} score lists", name); }
+        auto paths = score_paths(output_dir, name);
+        extended |= rewrite_lists(term_count,
+                                  [&](auto term_id) { return index.scores(term_id, name); },
+                                  options,
+                                  legacy_headers,
+                                  paths.postings,
+                                  paths.offsets);
+    }
+    write_term_info(output_dir);
+    for (auto const& name : score_names) {
+        write_score_term_info(output_dir, name);
+    }
+
+    // The lowest version that can read the output: Elias-Fano offsets,
+    // as well as tables copied from a version 3 index, require version 3,
+    // and extended list headers require version 2.
+    auto properties = Properties::read(input_dir);
+    if (not legacy_headers || properties.version >= 3) {
+        properties.version = 3;
+    } else {
+        properties.version = extended ? 2 : 1;
+    }
+    Properties::write(properties, output_dir);
+}
+
+}  // namespace irk::index
@@ -71,7 +71,7 @@ namespace index::detail {
             range.begin(),
             range.end(),
             [&](auto idx) {
-                auto part_sizes = indices[idx].document_sizes();
+                const auto& part_sizes = indices[idx].document_sizes();
                 auto offset = partial_count[idx] - part_sizes.size();
                 std::copy(
                     part_sizes.begin(),
@@ -86,7 +86,7 @@ namespace index::detail {
         double avg_doc_size =
             static_cast<double>(sum_doc_size) / document_count;
 
-        sout << irk::build_compact_table(sizes, false);
+        sout << irk::build_packed_table(sizes);
         return std::make_tuple(document_count, avg_doc_size, max_doc_size);
     }
 
@@ -168,6 +168,8 @@ private:
     index::offset_t doc_offset_;
     index::offset_t count_offset_;
     int block_size_;
+    ir::Block_List_Options list_options_;
+    std::int64_t document_count_ = 0;
     document_codec_type document_codec_;
     frequency_codec_type frequency_codec_;
 
@@ -188,14 +190,17 @@ public:
     basic_index_merger(const fs::path& target_dir,
         std::vector<fs::path> indices,
         int block_size,
-        bool skip_unique = false)
+        bool skip_unique = false,
+        ir::Block_List_Options list_options = {})
         : target_dir_(target_dir),
           skip_unique_(skip_unique),
-          block_size_(block_size)
+          block_size_(block_size),
+          list_options_(list_options)
     {
         for (fs::path index_dir : indices) {
             sources_.push_back(source_type::from(index_dir).value());
             indices_.emplace_back(sources_.back());
+            document_count_ += indices_.back().collection_size();
         }
         terms_out_.open(index::terms_path(target_dir).c_str());
         doc_ids_.open(index::doc_ids_path(target_dir).c_str());
@@ -251,12 +256,15 @@ public:
 
         // Write documents and counts.
         ir::Standard_Block_List_Builder<document_type, document_codec_type, true> doc_list_builder(
-            block_size_);
+            block_size_, list_options_);
+        doc_list_builder.set_document_count(document_count_);
         for (const auto& doc : doc_ids) { doc_list_builder.add(doc); }
+        doc_list_builder.partition();
         doc_offset_ += doc_list_builder.write(doc_ids_);
 
         ir::Standard_Block_List_Builder<frequency_type, frequency_codec_type, false>
-            count_list_builder(block_size_);
+            count_list_builder(block_size_, list_options_);
+        count_list_builder.set_partition(doc_list_builder.partition());
         for (const auto& count : doc_counts) { count_list_builder.add(count); }
         count_offset_ += count_list_builder.write(doc_counts_);
 
@@ -311,18 +319,18 @@ public:
             }
         }
         // Write occurrences
-        io::dump(build_compact_table<>(occurrences),
+        io::dump(build_packed_table(occurrences),
             index::term_occurrences_path(target_dir_));
 
         // Write offsets
-        io::dump(build_offset_table<>(doc_ids_off_),
+        io::dump(build_elias_fano_table(doc_ids_off_),
             index::doc_ids_off_path(target_dir_));
-        io::dump(build_offset_table<>(doc_counts_off_),
+        io::dump(build_elias_fano_table(doc_counts_off_),
             index::doc_counts_off_path(target_dir_));
 
         // Write term dfs.
         auto compact_term_dfs =
-            irk::build_compact_table<frequency_type>(term_dfs_);
+            irk::build_packed_table<frequency_type>(term_dfs_);
         irk::io::dump(compact_term_dfs, index::term_doc_freq_path(target_dir_));
 
         return all_occurrences;
@@ -366,6 +374,10 @@ public:
         merge_titles();
         if (log) { log->info("Merging terms"); }
         int64_t occurrences = merge_terms();
+        if (log) { log->info("Writing term info"); }
+        doc_ids_.flush();
+        doc_counts_.flush();
+        index::write_term_info(target_dir_);
         if (log) { log->info("Merging sizes"); }
         auto [documents, avg_doc_size, max_doc_size] = merge_sizes();
         if (log) { log->info("Writing properties"); }
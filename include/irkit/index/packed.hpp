@@ -0,0 +1,380 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <fmt/format.h>
+#include <nonstd/expected.hpp>
+
+#include <irkit/hash_dictionary.hpp>
+#include <irkit/index.hpp>
+#include <irkit/index/source.hpp>
+#include <irkit/io.hpp>
+#include <irkit/memoryview.hpp>
+
+namespace irk::index {
+
+//! A single index file stored within a packed index.
+struct Packed_Section {
+    std::string name;
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint64_t checksum;
+};
+
+namespace detail::packed {
+
+    // Header: [magic: 8B][version: u32][section count: u32][alignment: u64]
+    //         [table checksum: u64][reserved: 32B]
+    // Entry:  [name: 40B, zero-padded][offset: u64][size: u64][checksum: u64]
+    constexpr char magic[8] = {'I', 'R', 'K', 'P', 'A', 'C', 'K', '\0'};
+    constexpr std::uint32_t version = 1;
+    constexpr std::size_t header_size = 64;
+    constexpr std::size_t entry_size = 64;
+    constexpr std::size_t max_name_size = 40;
+    constexpr std::uint64_t checksum_seed = 0x6a09e667f3bcc908ULL;
+
+    template<class T>
+    T load(const char* ptr)
+    {
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        return value;
+    }
+
+    template<class T>
+    void store(char* ptr, T value)
+    {
+        std::memcpy(ptr, &value, sizeof(T));
+    }
+
+    inline std::uint64_t align(std::uint64_t offset, std::uint64_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+}  // namespace detail::packed
+
+//! Checksum of a section's bytes.
+inline std::uint64_t section_checksum(const char* data, std::size_t size)
+{
+    return irk::detail::hash_dictionary::hash(
+        std::string_view(data, size), detail::packed::checksum_seed);
+}
+
+//! Reads and validates the header and the section table of a packed index.
+/*!
+ * Only the table itself is checksummed here; see `verify_sections` for
+ * checking the section data, which requires reading the entire file.
+ *
+ * \throws std::runtime_error   if the memory is not a valid packed index
+ */
+inline std::vector<Packed_Section> read_section_table(const memory_view& memory)
+{
+    using namespace detail::packed;
+    auto size = static_cast<std::uint64_t>(memory.size());
+    if (size < header_size
+        || std::memcmp(memory.data(), magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("not a packed index");
+    }
+    const char* header = memory.data();
+    if (auto v = load<std::uint32_t>(header + 8); v != version) {
+        throw std::runtime_error(
+            fmt::format("unsupported packed index version: {}", v));
+    }
+    auto count = load<std::uint32_t>(header + 12);
+    auto table_checksum = load<std::uint64_t>(header + 24);
+    std::uint64_t table_end = header_size + count * entry_size;
+    if (table_end > size) {
+        throw std::runtime_error("packed index section table is truncated");
+    }
+    if (section_checksum(header + header_size, count * entry_size)
+        != table_checksum) {
+        throw std::runtime_error("packed index section table is corrupted");
+    }
+    std::vector<Packed_Section> sections;
+    sections.reserve(count);
+    for (std::uint32_t idx = 0; idx < count; ++idx) {
+        const char* entry = header + header_size + idx * entry_size;
+        Packed_Section section{
+            std::string(entry, strnlen(entry, max_name_size)),
+            load<std::uint64_t>(entry + max_name_size),
+            load<std::uint64_t>(entry + max_name_size + 8),
+            load<std::uint64_t>(entry + max_name_size + 16)};
+        if (section.offset < table_end || section.offset > size
+            || section.size > size - section.offset) {
+            throw std::runtime_error(fmt::format(
+                "packed index section {} is out of bounds", section.name));
+        }
+        sections.push_back(std::move(section));
+    }
+    return sections;
+}
+
+//! Returns the names of the sections whose data do not match their checksums.
+inline std::vector<std::string>
+verify_sections(const memory_view& memory,
+                const std::vector<Packed_Section>& sections)
+{
+    std::vector<std::string> corrupted;
+    for (const auto& section : sections) {
+        if (section_checksum(memory.data() + section.offset, section.size)
+            != section.checksum) {
+            corrupted.push_back(section.name);
+        }
+    }
+    return corrupted;
+}
+
+//! Returns the names of the sections that differ from the files in `dir`.
+/*!
+ * A section is stale if the file it was packed from has since changed size or
+ * been modified after `packed`, e.g., rewritten by scoring or copied over by
+ * another tool. Sections whose files are no longer present are not checked.
+ */
+inline std::vector<std::string>
+stale_sections(const path& dir,
+               const path& packed,
+               const std::vector<Packed_Section>& sections)
+{
+    auto packed_time = boost::filesystem::last_write_time(packed);
+    std::vector<std::string> stale;
+    for (const auto& section : sections) {
+        auto file = dir / section.name;
+        if (not boost::filesystem::is_regular_file(file)) {
+            continue;
+        }
+        if (boost::filesystem::file_size(file) != section.size
+            || boost::filesystem::last_write_time(file) > packed_time) {
+            stale.push_back(section.name);
+        }
+    }
+    return stale;
+}
+
+//! Packs all files of the index in `dir` into the single file `output`.
+/*!
+ * Each file becomes a section named after it, starting at an offset that is
+ * a multiple of `alignment`: 64 keeps sections cache-line aligned, while the
+ * page size (default) also lets each section be advised or locked separately.
+ * Text files, which are not read by index views, are not packed.
+ *
+ * \throws std::invalid_argument    if `alignment` is not a power of two of at
+ *                                  least 64, or a file name is too long
+ */
+inline void pack_index(const path& dir,
+                       const path& output,
+                       std::uint64_t alignment = 4096)
+{
+    using namespace detail::packed;
+    if (alignment < 64 || (alignment & (alignment - 1)) != 0) {
+        throw std::invalid_argument(
+            fmt::format("invalid section alignment: {}", alignment));
+    }
+    std::vector<path> files;
+    for (auto& entry : boost::make_iterator_range(directory_iterator(dir), {})) {
+        const auto& file = entry.path();
+        if (is_regular_file(file) && file.extension() != ".txt"
+            && file.extension() != ".pack"
+            && not boost::filesystem::equivalent(file, output)) {
+            files.push_back(file);
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<char> header(header_size + files.size() * entry_size, 0);
+    std::uint64_t offset = align(header.size(), alignment);
+    std::vector<boost::iostreams::mapped_file_source> contents;
+    for (std::size_t idx = 0; idx < files.size(); ++idx) {
+        auto name = files[idx].filename().string();
+        if (name.size() > max_name_size) {
+            throw std::invalid_argument(
+                fmt::format("file name too long to pack: {}", name));
+        }
+        std::uint64_t size = boost::filesystem::file_size(files[idx]);
+        std::uint64_t checksum = section_checksum("", 0);
+        auto& content = contents.emplace_back();
+        if (size > 0) {
+            content.open(files[idx]);
+            checksum = section_checksum(content.data(), size);
+        }
+        char* entry = header.data() + header_size + idx * entry_size;
+        std::memcpy(entry, name.data(), name.size());
+        store(entry + max_name_size, offset);
+        store(entry + max_name_size + 8, size);
+        store(entry + max_name_size + 16, checksum);
+        offset = align(offset + size, alignment);
+    }
+    std::memcpy(header.data(), magic, sizeof(magic));
+    store(header.data() + 8, version);
+    store(header.data() + 12, static_cast<std::uint32_t>(files.size()));
+    store(header.data() + 16, alignment);
+    store(header.data() + 24,
+          section_checksum(header.data() + header_size,
+                           files.size() * entry_size));
+
+    std::ofstream out(output.c_str(), std::ios::binary);
+    std::vector<char> padding(alignment, 0);
+    std::uint64_t written = 0;
+    auto write = [&](const char* data, std::uint64_t size) {
+        out.write(data, size);
+        written += size;
+    };
+    auto pad = [&]() {
+        write(padding.data(), align(written, alignment) - written);
+    };
+    write(header.data(), header.size());
+    for (const auto& content : contents) {
+        pad();
+        if (content.is_open()) {
+            write(content.data(), content.size());
+        }
+    }
+    pad();
+    if (not out) {
+        throw std::runtime_error(
+            fmt::format("failed to write packed index to {}", output.string()));
+    }
+}
+
+}  // namespace irk::index
+
+namespace irk {
+
+//! Index source reading all files from a single packed file.
+/*!
+ * The packed file `index::packed_index_path(dir)` is mapped once, and each
+ * index file is a view of its section. The section table is validated when
+ * the source is created, but section checksums are only checked by `verify`.
+ * A pack is rejected if any of the loose files next to it has changed since
+ * it was packed, so that stale lists are never read in their place.
+ *
+ * \throws std::runtime_error   if the pack is invalid or stale
+ */
+class Packed_Index_Source
+    : public Inverted_Index_Source<Packed_Index_Source, memory_view> {
+public:
+    explicit Packed_Index_Source(path const& dir)
+        : Inverted_Index_Source<Packed_Index_Source, memory_view>(dir)
+    {
+        auto file = index::packed_index_path(dir);
+        io::enforce_exist(file);
+        file_.open(file);
+        memory_ = make_memory_view(file_.data(), file_.size());
+        auto sections = index::read_section_table(memory_);
+        if (auto stale = index::stale_sections(dir, file, sections); not stale.empty()) {
+            std::ostringstream os;
+            os << "Packed index is older than its files; pack it again:";
+            for (auto const& name : stale) {
+                os << " " << name;
+            }
+            throw std::runtime_error(os.str());
+        }
+        for (auto& section : sections) {
+            sections_.emplace(section.name, std::move(section));
+        }
+    }
+
+    [[nodiscard]] static memory_view make_view(memory_view const& memory_source)
+    {
+        return memory_source;
+    }
+
+    [[nodiscard]] auto contains(path const& file) const -> bool
+    {
+        return sections_.count(file.filename().string()) > 0;
+    }
+
+    [[nodiscard]] auto size_of(path const& file) const -> std::uintmax_t
+    {
+        return section(file).size;
+    }
+
+    [[nodiscard]] auto init(path const& file) const -> memory_view
+    {
+        auto const& s = section(file);
+        return memory_(s.offset, s.offset + s.size);
+    }
+
+    void init(memory_view& source, path const& file) const { source = init(file); }
+
+    //! Returns the range within the packed file where the given range is stored.
+    [[nodiscard]] auto
+    file_range(path const& file, std::ptrdiff_t offset, std::ptrdiff_t size) const
+        -> index::File_Range
+    {
+        auto section_offset = static_cast<std::ptrdiff_t>(section(file).offset);
+        return {index::packed_index_path(dir()), section_offset + offset, size};
+    }
+
+    //! Checks the data of all sections against their checksums.
+    [[nodiscard]] auto verify() const -> nonstd::expected<void, std::string>
+    {
+        std::vector<index::Packed_Section> sections;
+        for (auto const& entry : sections_) {
+            sections.push_back(entry.second);
+        }
+        auto corrupted = index::verify_sections(memory_, sections);
+        if (corrupted.empty()) {
+            return {};
+        }
+        std::sort(corrupted.begin(), corrupted.end());
+        std::ostringstream os;
+        os << "Corrupted sections:";
+        for (auto const& name : corrupted) {
+            os << " " << name;
+        }
+        return nonstd::make_unexpected(os.str());
+    }
+
+private:
+    [[nodiscard]] auto section(path const& file) const -> index::Packed_Section const&
+    {
+        if (auto pos = sections_.find(file.filename().string()); pos != sections_.end()) {
+            return pos->second;
+        }
+        throw std::invalid_argument("File not found: " + file.generic_string());
+    }
+
+    mapped_file_source file_{};
+    memory_view memory_{};
+    std::unordered_map<std::string, index::Packed_Section> sections_{};
+};
+
+}  // namespace irk
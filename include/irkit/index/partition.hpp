@@ -94,21 +94,36 @@ namespace index {
             const Range& score_names)
         {
             write_terms(input_dir, output_dir, lex_keys_per_block);
-            build_offset_table(document_offsets)
+            build_elias_fano_table(document_offsets)
                 .serialize(doc_ids_off_path(output_dir));
-            build_offset_table(frequency_offsets)
+            build_elias_fano_table(frequency_offsets)
                 .serialize(doc_counts_off_path(output_dir));
             for (const auto& [idx, name] : iter::enumerate(score_names)) {
                 auto paths = index::score_paths(output_dir, name);
-                build_offset_table(score_offsets[idx]).serialize(paths.offsets);
+                build_elias_fano_table(score_offsets[idx]).serialize(paths.offsets);
                 using score_type = inverted_index_view::score_type;
                 build_compact_table<score_type>(max_scores[idx])
                     .serialize(paths.max_scores);
+                std::ofstream score_info_out(
+                    score_term_info_path(output_dir, name).c_str());
+                write_records<Score_Term_Info>(
+                    score_info_out,
+                    build_score_term_info(score_offsets[idx],
+                                          cur_score_offsets[idx],
+                                          max_scores[idx]));
             }
-            build_compact_table<frequency_t>(term_frequencies)
+            build_packed_table<frequency_t>(term_frequencies)
                 .serialize(term_doc_freq_path(output_dir));
-            build_compact_table<frequency_t>(term_occurrences)
+            build_packed_table<frequency_t>(term_occurrences)
                 .serialize(term_occurrences_path(output_dir));
+            std::ofstream term_info_out(term_info_path(output_dir).c_str());
+            write_records<Term_Info>(term_info_out,
+                                     build_term_info(document_offsets,
+                                                     cur_document_offset,
+                                                     frequency_offsets,
+                                                     cur_frequency_offset,
+                                                     term_frequencies,
+                                                     term_occurrences));
         }
 
         /// Accumulates data for a term.
@@ -153,7 +168,9 @@ namespace index {
                 terms_path(input_dir), terms_path(output_dir), term_ids);
             build_lexicon(terms_path(output_dir), keys_per_block)
                 .serialize(term_map_path(output_dir));
-            build_compact_table(term_frequencies)
+            build_hash_dictionary(terms_path(output_dir))
+                .serialize(term_hash_path(output_dir));
+            build_packed_table(term_frequencies)
                 .serialize(term_doc_freq_path(output_dir));
         }
     };
@@ -335,7 +352,7 @@ namespace detail::partition {
                     create_directory(dir);
                 }
                 std::ofstream os(index::doc_sizes_path(dir).string());
-                irk::build_compact_table(sizes).serialize(os);
+                irk::build_packed_table(sizes).serialize(os);
                 avg_size /= sizes.size();
             }
 
@@ -343,7 +360,7 @@ namespace detail::partition {
                 std::move(avg_shard_sizes), std::move(max_shard_sizes));
         }
 
-        /// Partitions document titles and title map.
+        /// Partitions document titles, title map, and title table.
         auto titles()
         {
             auto [buf, lex_view] =
@@ -365,6 +382,8 @@ namespace detail::partition {
                 std::ofstream tos(index::titles_path(shard_dir).string());
                 irk::build_lexicon(partitioned_titles, keys_per_block)
                     .serialize(los);
+                irk::build_string_table(partitioned_titles)
+                    .serialize(index::title_table_path(shard_dir));
                 for (const auto& title : partitioned_titles) {
                     tos << title << '\n';
                 }
@@ -688,6 +707,9 @@ namespace detail::partition {
             copy(index::term_occurrences_path(input_dir_),
                  index::term_occurrences_path(cluster_dir));
             copy(index::term_map_path(input_dir_), index::term_map_path(cluster_dir));
+            if (exists(index::term_hash_path(input_dir_))) {
+                copy(index::term_hash_path(input_dir_), index::term_hash_path(cluster_dir));
+            }
             for (auto const& [name, path] : index::find_score_stats_paths(input_dir_)) {
                 if (path.max) {
                     copy(path.max.value(), cluster_dir / fmt::format("{}.max", name));
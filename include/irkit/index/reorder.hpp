@@ -54,7 +54,7 @@ auto sizes(const Table& size_table, const std::vector<document_t>& permutation)
     std::vector<size_type> new_sizes(
         boost::make_permutation_iterator(sizes.begin(), permutation.begin()),
         boost::make_permutation_iterator(sizes.end(), permutation.end()));
-    return irk::build_compact_table<size_type>(new_sizes);
+    return irk::build_packed_table<size_type>(new_sizes);
 }
 
 template<typename Lexicon>
@@ -229,12 +229,12 @@ void postings(
         }
         frequencies[term] = mask.size();
     }
-    document_offsets_os << irk::build_offset_table(document_offsets);
-    frequency_offsets_os << irk::build_offset_table(frequency_offsets);
-    term_freq_os << irk::build_compact_table(frequencies);
-    term_occ_os << irk::build_compact_table(occurrences);
+    document_offsets_os << irk::build_elias_fano_table(document_offsets);
+    frequency_offsets_os << irk::build_elias_fano_table(frequency_offsets);
+    term_freq_os << irk::build_packed_table(frequencies);
+    term_occ_os << irk::build_packed_table(occurrences);
     for (int idx = 0; idx < score_functions; ++idx) {
-        scores_offset_os[idx] << irk::build_offset_table(scores_offsets[idx]);
+        scores_offset_os[idx] << irk::build_elias_fano_table(scores_offsets[idx]);
     }
 }
 
@@ -287,6 +287,9 @@ void index(
     auto rtitles = irk::reorder::titles(index.titles(), permutation);
     rtitles.serialize(title_map_os);
     irk::io::write_lines(rtitles, titles_os);
+    irk::build_string_table(
+        std::vector<std::string>(rtitles.begin(), rtitles.end()))
+        .serialize(irk::index::title_table_path(output_dir));
     if (log) { log->info("Reordering sizes..."); }
     irk::reorder::sizes(index.document_sizes(), permutation)
         .serialize(sizes_os);
@@ -309,9 +312,27 @@ void index(
     boost::filesystem::copy(
         irk::index::term_map_path(input_dir),
         irk::index::term_map_path(output_dir));
-    boost::filesystem::copy(
-        irk::index::properties_path(input_dir),
-        irk::index::properties_path(output_dir));
+    // Compact tables and the lexicon are written in the version 3 format.
+    auto properties = irk::index::Properties::read(input_dir);
+    properties.version = irk::index::Properties::current_version;
+    irk::index::Properties::write(properties, output_dir);
+    if (boost::filesystem::exists(irk::index::term_hash_path(input_dir))) {
+        boost::filesystem::copy(irk::index::term_hash_path(input_dir),
+                                irk::index::term_hash_path(output_dir));
+    }
+    if (log) { log->info("Writing term info..."); }
+    term_freq_os.flush();
+    term_occ_os.flush();
+    document_os.flush();
+    document_offsets_os.flush();
+    frequency_os.flush();
+    frequency_offsets_os.flush();
+    for (auto& os : scp) { os.flush(); }
+    for (auto& os : sco) { os.flush(); }
+    irk::index::write_term_info(output_dir);
+    for (const auto& score : score_functions) {
+        irk::index::write_score_term_info(output_dir, score);
+    }
 }
 
 }  // namespace irk::reorder
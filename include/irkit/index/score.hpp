@@ -224,10 +224,18 @@ namespace detail {
             for (term_id_t term_id = 0; term_id < index.terms().size();
                  term_id++) {
                 offsets.push_back(offset);
+                // Score lists must follow the blocks of document lists.
+                auto documents = index.documents(term_id);
+                ir::Block_List_Options list_options{};
+                list_options.variable_blocks = documents.has_variable_blocks();
                 ir::Standard_Block_List_Builder<std::uint32_t,
                                                 stream_vbyte_codec<std::uint32_t>,
                                                 false>
-                    list_builder(index.skip_block_size());
+                    list_builder(index.skip_block_size(), list_options);
+                if (list_options.variable_blocks) {
+                    auto block_ends = documents.block_ends();
+                    list_builder.set_partition({block_ends.begin(), block_ends.end()});
+                }
                 stat_accumulator acc;
                 auto scorer = index.term_scorer(term_id, ScoreTag{});
                 for (const auto& posting : index.postings(term_id)) {
@@ -239,11 +247,14 @@ namespace detail {
                 max_scores.push_back(ba::max(acc));
                 offset += list_builder.write(sout);
             }
-            const auto offset_table = irk::build_offset_table<>(offsets);
+            const auto offset_table = irk::build_elias_fano_table(offsets);
             offout << offset_table;
             const auto maxscore_table =
                 irk::build_compact_table<uint32_t>(max_scores);
             maxout << maxscore_table;
+            std::ofstream infout(index::score_term_info_path(dir, name).c_str());
+            index::write_records<index::Score_Term_Info>(
+                infout, index::build_score_term_info(offsets, offset, max_scores));
 
             index::QuantizationProperties qprops;
             qprops.type = type.value();
@@ -251,6 +262,8 @@ namespace detail {
             qprops.min = min_score;
             qprops.max = max_score;
             props.quantized_scores[name] = qprops;
+            // Elias-Fano offset tables require version 3 readers.
+            props.version = index::Properties::current_version;
             index::Properties::write(props, dir);
 
             return nonstd::expected<void, std::string>();
@@ -32,7 +32,10 @@
 #include <boost/iostreams/device/mapped_file.hpp>
 #include <fmt/format.h>
 
+#include <irkit/block_cache.hpp>
 #include <irkit/index.hpp>
+#include <irkit/index/warmup.hpp>
+#include <irkit/prefetch.hpp>
 #include <irkit/value.hpp>
 #include <irkit/vector.hpp>
 #include <nonstd/expected.hpp>
@@ -40,6 +43,7 @@
 namespace irk {
 
 using boost::filesystem::exists;
+using boost::filesystem::file_size;
 using boost::filesystem::path;
 using boost::iostreams::mapped_file_source;
 using ir::Vector;
@@ -72,31 +76,55 @@ public:
     [[nodiscard]] static auto from(path dir, std::vector<std::string> const& score_names = {})
         -> nonstd::expected<pointer, std::string>
     {
-        auto source = std::make_shared<Index_Source>(dir);
-        Index_Source::init(source->documents, index::doc_ids_path(dir));
-        Index_Source::init(source->counts, index::doc_counts_path(dir));
-        Index_Source::init(source->document_offsets, index::doc_ids_off_path(dir));
-        Index_Source::init(source->count_offsets, index::doc_counts_off_path(dir));
-        Index_Source::init(source->term_collection_frequencies, index::term_doc_freq_path(dir));
-        Index_Source::init(source->term_collection_occurrences, index::term_occurrences_path(dir));
-        Index_Source::init(source->term_map, index::term_map_path(dir));
-        Index_Source::init(source->title_map, index::title_map_path(dir));
-        Index_Source::init(source->document_sizes, index::doc_sizes_path(dir));
-        Index_Source::init(source->properties, index::properties_path(dir));
+        return load(std::make_shared<Index_Source>(dir), score_names);
+    }
+
+protected:
+    //! Initializes all members of a newly created `source`.
+    [[nodiscard]] static auto
+    load(std::shared_ptr<Index_Source> source, std::vector<std::string> const& score_names)
+        -> nonstd::expected<pointer, std::string>
+    {
+        auto const& dir = source->dir();
+        source->init(source->documents, index::doc_ids_path(dir));
+        source->init(source->counts, index::doc_counts_path(dir));
+        source->init(source->document_offsets, index::doc_ids_off_path(dir));
+        source->init(source->count_offsets, index::doc_counts_off_path(dir));
+        source->init(source->term_collection_frequencies, index::term_doc_freq_path(dir));
+        source->init(source->term_collection_occurrences, index::term_occurrences_path(dir));
+        source->init(source->term_map, index::term_map_path(dir));
+        source->init(source->title_map, index::title_map_path(dir));
+        source->init(source->document_sizes, index::doc_sizes_path(dir));
+        source->init(source->properties, index::properties_path(dir));
+        if (auto term_info = index::term_info_path(dir);
+            source->contains(term_info) && source->size_of(term_info) > 0) {
+            source->term_info = source->init(term_info);
+        }
+        if (auto term_hash = index::term_hash_path(dir); source->contains(term_hash)) {
+            source->term_hash = source->init(term_hash);
+        }
+        if (auto title_table = index::title_table_path(dir); source->contains(title_table)) {
+            source->title_table = source->init(title_table);
+        }
 
         source->score_stats = index::transform_score_stats_map(
-            index::find_score_stats_paths(dir),
-            [](auto const& path) { return Index_Source::init(path); });
+            index::find_score_stats_paths(
+                dir, [&](auto const& path) { return source->contains(path); }),
+            [&](auto const& path) { return source->init(path); });
 
         std::vector<std::string> invalid_scores;
         for (const std::string& score_name : score_names) {
             auto score_paths = index::score_paths(dir, score_name);
-            if (exists(score_paths.postings) && exists(score_paths.offsets)
-                && exists(score_paths.max_scores))
+            if (source->contains(score_paths.postings) && source->contains(score_paths.offsets)
+                && source->contains(score_paths.max_scores))
             {
-                source->scores_[score_name] = {Index_Source::init(score_paths.postings),
-                                               Index_Source::init(score_paths.offsets),
-                                               Index_Source::init(score_paths.max_scores)};
+                source->scores_[score_name] = {source->init(score_paths.postings),
+                                               source->init(score_paths.offsets),
+                                               source->init(score_paths.max_scores)};
+                if (auto term_info = index::score_term_info_path(dir, score_name);
+                    source->contains(term_info) && source->size_of(term_info) > 0) {
+                    source->score_term_info_[score_name] = source->init(term_info);
+                }
             } else {
                 invalid_scores.push_back(score_name);
             }
@@ -109,9 +137,19 @@ public:
         }
         return source;
     }
+
+public:
     path dir_;
     [[nodiscard]] auto dir() const -> path const& { return dir_; }
 
+    //! Whether the index has the file `file`; sources that do not read
+    //! from the file system hide this, `size_of`, and `init`.
+    [[nodiscard]] auto contains(path const& file) const -> bool { return exists(file); }
+    [[nodiscard]] auto size_of(path const& file) const -> std::uintmax_t
+    {
+        return file_size(file);
+    }
+
     REGISTER_MEMORY_SOURCE(documents);
     REGISTER_MEMORY_SOURCE(counts);
     REGISTER_MEMORY_SOURCE(document_offsets);
@@ -123,6 +161,33 @@ public:
     REGISTER_MEMORY_SOURCE(document_sizes);
     REGISTER_MEMORY_SOURCE(properties);
 
+    std::optional<Memory_Source> term_info{};
+    [[nodiscard]] auto term_info_view() const -> std::optional<memory_view>
+    {
+        if (term_info.has_value()) {
+            return Index_Source::make_view(*term_info);
+        }
+        return std::nullopt;
+    }
+
+    std::optional<Memory_Source> term_hash{};
+    [[nodiscard]] auto term_hash_view() const -> std::optional<memory_view>
+    {
+        if (term_hash.has_value()) {
+            return Index_Source::make_view(*term_hash);
+        }
+        return std::nullopt;
+    }
+
+    std::optional<Memory_Source> title_table{};
+    [[nodiscard]] auto title_table_view() const -> std::optional<memory_view>
+    {
+        if (title_table.has_value()) {
+            return Index_Source::make_view(*title_table);
+        }
+        return std::nullopt;
+    }
+
     index::ScoreStatsMap<Memory_Source> score_stats;
     [[nodiscard]] auto score_stats_views() const
     {
@@ -156,6 +221,71 @@ public:
         return view_map;
     }
     [[nodiscard]] auto default_score() const -> std::string const& { return default_score_; }
+
+    //! Returns where `size` bytes at `offset` of the index file `file` are stored.
+    /*!
+     * Sources reading loose files return the range as is; sources storing
+     * index files elsewhere translate it.
+     */
+    [[nodiscard]] auto
+    file_range(path const& file, std::ptrdiff_t offset, std::ptrdiff_t size) const
+        -> index::File_Range
+    {
+        return {file, offset, size};
+    }
+
+    std::unordered_map<std::string, Memory_Source> score_term_info_{};
+    [[nodiscard]] auto score_term_info_views() const
+        -> std::unordered_map<std::string, memory_view>
+    {
+        std::unordered_map<std::string, memory_view> view_map;
+        for (const auto& [name, info] : score_term_info_) {
+            view_map[name] = Index_Source::make_view(info);
+        }
+        return view_map;
+    }
+
+    //! Brings the index memory into the page cache according to `policy`.
+    /*!
+     * Posting data (document IDs, frequencies, and quantized scores) is warmed
+     * up with `policy.postings`, and everything else with `policy.metadata`.
+     */
+    void warm_up(index::Warmup_Policy const& policy) const
+    {
+        auto apply = [](memory_view const& view, index::Warmup_Mode mode) {
+            if (mode != index::Warmup_Mode::Lazy) {
+                index::warm_up(view.data(), view.size(), mode);
+            }
+        };
+        apply(documents_view(), policy.postings);
+        apply(counts_view(), policy.postings);
+        for (auto const& [name, tuple] : scores_sources()) {
+            apply(tuple.postings, policy.postings);
+            apply(tuple.offsets, policy.metadata);
+            apply(tuple.max_scores, policy.metadata);
+        }
+        for (auto const& view : {document_offsets_view(),
+                                 count_offsets_view(),
+                                 term_collection_frequencies_view(),
+                                 term_collection_occurrences_view(),
+                                 term_map_view(),
+                                 title_map_view(),
+                                 document_sizes_view(),
+                                 properties_view()}) {
+            apply(view, policy.metadata);
+        }
+        for (auto const& view : {term_info_view(), term_hash_view(), title_table_view()}) {
+            if (view.has_value()) { apply(*view, policy.metadata); }
+        }
+        for (auto const& [name, view] : score_term_info_views()) {
+            apply(view, policy.metadata);
+        }
+        for (auto const& [name, stats] : score_stats_views()) {
+            for (auto const& view : {stats.max, stats.mean, stats.var}) {
+                if (view.has_value()) { apply(*view, policy.metadata); }
+            }
+        }
+    }
 };
 
 class Inverted_Index_Mapped_Source
@@ -204,6 +334,75 @@ public:
     }
 };
 
+//! Index source reading posting data through a bounded `block_cache`.
+/*!
+ * Document IDs, frequencies, and quantized scores are read with `pread` into
+ * the cache, which can be shared by many indexes, while all other files are
+ * mapped. Memory used by postings is thus bounded by the cache capacity
+ * rather than left to the page cache.
+ */
+class Inverted_Index_Disk_Source
+    : public Inverted_Index_Source<Inverted_Index_Disk_Source, memory_view> {
+public:
+    Inverted_Index_Disk_Source(path const& dir, std::shared_ptr<block_cache> cache)
+        : Inverted_Index_Source<Inverted_Index_Disk_Source, memory_view>(dir),
+          cache_(std::move(cache))
+    {}
+
+    [[nodiscard]] static auto from(path const& dir,
+                                   std::shared_ptr<block_cache> cache,
+                                   std::vector<std::string> const& score_names = {})
+        -> nonstd::expected<pointer, std::string>
+    {
+        return load(std::make_shared<Inverted_Index_Disk_Source>(dir, std::move(cache)),
+                    score_names);
+    }
+
+    [[nodiscard]] static memory_view make_view(memory_view const& memory_source)
+    {
+        return memory_source;
+    }
+
+    [[nodiscard]] auto init(path const& file_path) -> memory_view
+    {
+        io::enforce_exist(file_path);
+        auto name = file_path.filename();
+        if (name == index::doc_ids_path("").filename()
+            || name == index::doc_counts_path("").filename()
+            || name.extension() == ".scores") {
+            auto file = std::make_shared<cached_file const>(file_path, cache_);
+            cached_files_[file_path.string()] = file;
+            return memory_view(cached_file_memory_source(std::move(file)));
+        }
+        auto const& file = mapped_files_.emplace_back(file_path);
+        return make_memory_view(file.data(), file.size());
+    }
+
+    void init(memory_view& source, path const& file_path) { source = init(file_path); }
+
+    //! Posting data is never warmed up: it is only read on demand.
+    void warm_up(index::Warmup_Policy const& policy) const
+    {
+        Inverted_Index_Source<Inverted_Index_Disk_Source, memory_view>::warm_up(
+            index::Warmup_Policy{index::Warmup_Mode::Lazy, policy.metadata});
+    }
+
+    [[nodiscard]] auto cache() const -> block_cache const& { return *cache_; }
+
+    //! Starts reading `range` into the cache, if it is in a cached file.
+    void prefetch(block_prefetcher& prefetcher, index::File_Range const& range) const
+    {
+        if (auto pos = cached_files_.find(range.file.string()); pos != cached_files_.end()) {
+            prefetcher.prefetch(pos->second, range.offset, range.size);
+        }
+    }
+
+private:
+    std::shared_ptr<block_cache> cache_;
+    std::unordered_map<std::string, std::shared_ptr<cached_file const>> cached_files_{};
+    std::vector<mapped_file_source> mapped_files_{};
+};
+
 template<class T>
 struct PropertySource {
     auto properties() const {
@@ -222,6 +421,9 @@ public:
         term_collection_frequencies_.open(index::term_doc_freq_path(dir));
         term_collection_occurrences_.open(index::term_occurrences_path(dir));
         term_map_.open(index::term_map_path(dir));
+        if (exists(index::term_hash_path(dir))) {
+            term_hash_.emplace(index::term_hash_path(dir));
+        }
     }
 
     memory_view term_collection_frequencies_view() const
@@ -241,10 +443,31 @@ public:
         return make_memory_view(term_map_.data(), term_map_.size());
     }
 
+    std::optional<memory_view> term_hash_view() const
+    {
+        if (term_hash_.has_value()) {
+            return make_memory_view(term_hash_->data(), term_hash_->size());
+        }
+        return std::nullopt;
+    }
+
+    void warm_up_tables(index::Warmup_Mode mode) const
+    {
+        for (auto const& view : {term_collection_frequencies_view(),
+                                 term_collection_occurrences_view(),
+                                 term_map_view()}) {
+            index::warm_up(view.data(), view.size(), mode);
+        }
+        if (auto term_hash = term_hash_view(); term_hash.has_value()) {
+            index::warm_up(term_hash->data(), term_hash->size(), mode);
+        }
+    }
+
 private:
     mapped_file_source term_collection_frequencies_{};
     mapped_file_source term_collection_occurrences_{};
     mapped_file_source term_map_{};
+    std::optional<mapped_file_source> term_hash_{};
 };
 
 template<class T>
@@ -302,6 +525,15 @@ public:
     [[nodiscard]] auto const& shards() const noexcept { return shards_; }
     [[nodiscard]] auto const& dir() const noexcept { return dir_; }
 
+    //! Warms up all shards, and the cluster-wide tables as metadata.
+    void warm_up(index::Warmup_Policy const& policy) const
+    {
+        this->warm_up_tables(policy.metadata);
+        for (auto const& shard : shards_) {
+            shard->warm_up(policy);
+        }
+    }
+
 private:
     path dir_;
     shard_vector shards_;
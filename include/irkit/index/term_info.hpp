@@ -0,0 +1,172 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <fmt/format.h>
+#include <gsl/span>
+
+#include <irkit/assert.hpp>
+#include <irkit/memoryview.hpp>
+
+namespace irk::index {
+
+//! Fixed-size record with everything needed to open the postings of a term.
+/*!
+ * Records are stored in a flat array indexed by term ID (see
+ * `term_info_path`) and are never compressed, so that resolving a term
+ * reads a single 32-byte record instead of decoding several compact tables.
+ * When the array is memory mapped, no record crosses a cache line.
+ */
+struct Term_Info {
+    std::uint64_t document_offset;
+    std::uint64_t count_offset;
+    std::uint32_t document_list_size;
+    std::uint32_t count_list_size;
+    std::int32_t document_frequency;
+    std::int32_t occurrences;
+};
+static_assert(sizeof(Term_Info) == 32);
+
+//! Fixed-size record of a score list of a term, one array per score function.
+struct Score_Term_Info {
+    std::uint64_t offset;
+    std::uint32_t list_size;
+    std::uint32_t max_score;
+};
+static_assert(sizeof(Score_Term_Info) == 16);
+
+namespace detail::term_info {
+
+    //! Returns the byte size of each list given its offsets and the total size.
+    template<class Offsets>
+    std::vector<std::uint32_t>
+    list_sizes(Offsets const& offsets, std::uint64_t total_size)
+    {
+        std::vector<std::uint32_t> sizes(offsets.size());
+        for (std::size_t term = 0; term < offsets.size(); ++term) {
+            std::uint64_t next = term + 1 < offsets.size() ? offsets[term + 1]
+                                                           : total_size;
+            EXPECTS(next >= offsets[term]);
+            EXPECTS(next - offsets[term]
+                    <= std::numeric_limits<std::uint32_t>::max());
+            sizes[term] = static_cast<std::uint32_t>(next - offsets[term]);
+        }
+        return sizes;
+    }
+
+}  // namespace detail::term_info
+
+//! Builds term records from per-term tables.
+/*!
+ * \param document_offsets  offsets of document lists
+ * \param documents_size    size in bytes of the document list file
+ * \param count_offsets     offsets of frequency lists
+ * \param counts_size       size in bytes of the frequency list file
+ * \param frequencies       document frequencies of terms
+ * \param occurrences       total occurrences of terms
+ *
+ * All tables must have the same number of elements; any random access
+ * container (including `irk::compact_table`) can be passed.
+ */
+template<class Offsets, class Frequencies>
+std::vector<Term_Info> build_term_info(Offsets const& document_offsets,
+                                       std::uint64_t documents_size,
+                                       Offsets const& count_offsets,
+                                       std::uint64_t counts_size,
+                                       Frequencies const& frequencies,
+                                       Frequencies const& occurrences)
+{
+    auto term_count = document_offsets.size();
+    EXPECTS(count_offsets.size() == term_count);
+    EXPECTS(frequencies.size() == term_count);
+    EXPECTS(occurrences.size() == term_count);
+    auto document_sizes =
+        detail::term_info::list_sizes(document_offsets, documents_size);
+    auto count_sizes = detail::term_info::list_sizes(count_offsets, counts_size);
+    std::vector<Term_Info> info(term_count);
+    for (std::size_t term = 0; term < term_count; ++term) {
+        info[term] = Term_Info{document_offsets[term],
+                               count_offsets[term],
+                               document_sizes[term],
+                               count_sizes[term],
+                               static_cast<std::int32_t>(frequencies[term]),
+                               static_cast<std::int32_t>(occurrences[term])};
+    }
+    return info;
+}
+
+//! Builds score records from score list offsets and max scores.
+template<class Offsets, class Scores>
+std::vector<Score_Term_Info> build_score_term_info(Offsets const& offsets,
+                                                   std::uint64_t scores_size,
+                                                   Scores const& max_scores)
+{
+    EXPECTS(max_scores.size() == offsets.size());
+    auto sizes = detail::term_info::list_sizes(offsets, scores_size);
+    std::vector<Score_Term_Info> info(offsets.size());
+    for (std::size_t term = 0; term < offsets.size(); ++term) {
+        info[term] = Score_Term_Info{
+            offsets[term], sizes[term], static_cast<std::uint32_t>(max_scores[term])};
+    }
+    return info;
+}
+
+//! Writes an array of fixed-size records.
+template<class Record>
+std::ostream& write_records(std::ostream& out, gsl::span<Record const> records)
+{
+    return out.write(reinterpret_cast<char const*>(records.data()),
+                     records.size() * sizeof(Record));
+}
+
+//! Interprets memory as an array of fixed-size records.
+/*!
+ * The memory must be suitably aligned for `Record`, which is always the case
+ * for memory mapped files and heap buffers.
+ */
+template<class Record>
+gsl::span<Record const> record_span(memory_view const& memory)
+{
+    if (memory.size() % sizeof(Record) != 0) {
+        throw std::runtime_error(fmt::format(
+            "term info size {} is not a multiple of record size {}",
+            memory.size(),
+            sizeof(Record)));
+    }
+    if (memory.size() == 0) { return {}; }
+    auto const* data = memory.data();
+    EXPECTS(reinterpret_cast<std::uintptr_t>(data) % alignof(Record) == 0);
+    return gsl::make_span(reinterpret_cast<Record const*>(data),
+                          memory.size() / sizeof(Record));
+}
+
+}  // namespace irk::index
@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/format.h>
+#include <nonstd/expected.hpp>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace irk::index {
+
+//! How the pages of a mapped index file are brought into memory.
+enum class Warmup_Mode {
+    //! Pages are faulted in on first access.
+    Lazy,
+    //! All pages are read before the index is used.
+    Populate,
+    //! The kernel is asked to read pages ahead, without waiting for it.
+    Will_Need,
+    //! All pages are read and locked in memory.
+    Lock,
+    //! Transparent huge pages are requested, and all pages are read.
+    Huge_Pages
+};
+
+inline std::ostream& operator<<(std::ostream& os, Warmup_Mode mode)
+{
+    switch (mode) {
+    case Warmup_Mode::Lazy: os << "lazy"; break;
+    case Warmup_Mode::Populate: os << "populate"; break;
+    case Warmup_Mode::Will_Need: os << "willneed"; break;
+    case Warmup_Mode::Lock: os << "mlock"; break;
+    case Warmup_Mode::Huge_Pages: os << "hugepages"; break;
+    default: throw std::domain_error("Warmup_Mode: non-exhaustive switch");
+    }
+    return os;
+}
+
+[[nodiscard]] inline auto parse_warmup_mode(std::string const& name)
+    -> nonstd::expected<Warmup_Mode, std::string>
+{
+    if (name == "lazy") { return Warmup_Mode::Lazy; }
+    if (name == "populate") { return Warmup_Mode::Populate; }
+    if (name == "willneed") { return Warmup_Mode::Will_Need; }
+    if (name == "mlock") { return Warmup_Mode::Lock; }
+    if (name == "hugepages") { return Warmup_Mode::Huge_Pages; }
+    return nonstd::make_unexpected(fmt::format("unknown warmup mode: {}", name));
+}
+
+//! Warmup modes for different parts of a mapped index.
+/*!
+ * Posting data (document IDs, frequencies, and quantized scores) is usually
+ * the bulk of an index and is accessed sparsely, while everything else
+ * (offsets, lexicons, document sizes, term statistics) is small and touched
+ * by almost every query, so it often pays to warm up only the latter.
+ */
+struct Warmup_Policy {
+    Warmup_Mode postings = Warmup_Mode::Lazy;
+    Warmup_Mode metadata = Warmup_Mode::Lazy;
+};
+
+namespace detail::warmup {
+
+    inline std::size_t page_size()
+    {
+        static const auto size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    //! Reads one byte of each page to fault the pages in.
+    inline void touch_pages(char const* data, std::size_t size)
+    {
+        auto step = page_size();
+        volatile char sink = 0;
+        for (std::size_t pos = 0; pos < size; pos += step) {
+            sink = sink + data[pos];
+        }
+        (void)sink;
+    }
+
+    inline void populate(void* begin, std::size_t length, char const* data, std::size_t size)
+    {
+#ifdef MADV_POPULATE_READ
+        if (madvise(begin, length, MADV_POPULATE_READ) == 0) { return; }
+#endif
+        (void)begin;
+        (void)length;
+        touch_pages(data, size);
+    }
+
+}  // namespace detail::warmup
+
+//! Applies a warmup mode to a region of mapped memory.
+/*!
+ * Advice that the kernel does not support is ignored, and populating falls
+ * back to reading a byte of every page. Locking, however, is an explicit
+ * request, and throws if it fails, e.g., due to `RLIMIT_MEMLOCK`.
+ */
+inline void warm_up(char const* data, std::size_t size, Warmup_Mode mode)
+{
+    if (mode == Warmup_Mode::Lazy || data == nullptr || size == 0) { return; }
+    auto page_mask = ~(static_cast<std::uintptr_t>(detail::warmup::page_size()) - 1);
+    auto first = reinterpret_cast<std::uintptr_t>(data) & page_mask;
+    auto* begin = reinterpret_cast<void*>(first);
+    auto length = reinterpret_cast<std::uintptr_t>(data) + size - first;
+    switch (mode) {
+    case Warmup_Mode::Populate: detail::warmup::populate(begin, length, data, size); break;
+    case Warmup_Mode::Will_Need: madvise(begin, length, MADV_WILLNEED); break;
+    case Warmup_Mode::Lock:
+        if (mlock(begin, length) != 0) {
+            throw std::runtime_error(
+                fmt::format("failed to lock {} bytes: {}", length, std::strerror(errno)));
+        }
+        break;
+    case Warmup_Mode::Huge_Pages:
+#ifdef MADV_HUGEPAGE
+        madvise(begin, length, MADV_HUGEPAGE);
+#endif
+        detail::warmup::populate(begin, length, data, size);
+        break;
+    default: break;
+    }
+}
+
+}  // namespace irk::index
@@ -80,10 +80,26 @@ public:
         return &list_->block(position_.block)[position_.offset];
     }
 
+    //! Moves to the next position.
+    /*!
+     * If the list has variable blocks, i.e., non-empty `block_ends()`,
+     * the block is switched when the offset reaches the block length, and
+     * the end position is `{block_count, 0}`. Otherwise, all blocks but
+     * the last are assumed to be of length `block_size()`.
+     */
     constexpr Block_Iterator& operator++() noexcept
     {
-        auto block_size = list_->block_size();
         ++position_.offset;
+        auto const& block_ends = list_->block_ends();
+        if (not block_ends.empty()) {
+            auto block_begin = position_.block > 0 ? block_ends[position_.block - 1] : 0;
+            if (block_begin + position_.offset == block_ends[position_.block]) {
+                ++position_.block;
+                position_.offset = 0;
+            }
+            return *this;
+        }
+        auto block_size = list_->block_size();
         position_.block += position_.offset / block_size;
         position_.offset %= block_size;
         return *this;
@@ -133,6 +149,11 @@ public:
 
     [[nodiscard]] constexpr auto idx() const noexcept -> size_type
     {
+        auto const& block_ends = list_->block_ends();
+        if (not block_ends.empty()) {
+            auto block_begin = position_.block > 0 ? block_ends[position_.block - 1] : 0;
+            return block_begin + position_.offset;
+        }
         return list_->block_size() * position_.block + position_.offset;
     }
 
@@ -185,12 +206,7 @@ private:
 
     constexpr void finish() noexcept
     {
-        // auto len = list_->size();
-        // auto block_size = list_->block_size();
-        // position_.block = len / block_size;
-        // position_.offset = (len - ((list_->block_count() - 1) * block_size))
-        //    % block_size;
-        position_ = end(list_->size(), list_->block_size(), list_->block_count());
+        position_ = list_->end().blocked_postition();
     }
 
     [[nodiscard]] constexpr auto end() const noexcept -> Block_Iterator
@@ -26,10 +26,31 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/iostreams/stream.hpp>
 #include <boost/range/irange.hpp>
+#include <fmt/format.h>
+#include <gsl/span>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
 
 #include <irkit/alphabetical_bst.hpp>
 #include <irkit/assert.hpp>
@@ -39,10 +60,147 @@
 #include <irkit/coding/vbyte.hpp>
 #include <irkit/io.hpp>
 #include <irkit/memoryview.hpp>
-#include <irkit/radix_tree.hpp>
 
 namespace irk {
 
+namespace detail::lexicon {
+
+    //! Marks the current format; older files begin with a positive header size.
+    constexpr std::int64_t format_marker = -2;
+
+    inline std::uint64_t load_word(const char* data)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        return word;
+    }
+
+    inline void append_word(std::uint64_t word, std::vector<char>& memory)
+    {
+        const char* bytes = reinterpret_cast<const char*>(&word);
+        memory.insert(memory.end(), bytes, bytes + sizeof(word));
+    }
+
+    inline void pad(std::vector<char>& memory)
+    {
+        memory.resize((memory.size() + 7) / 8 * 8, 0);
+    }
+
+    inline std::uint64_t padded(std::uint64_t size) { return (size + 7) / 8 * 8; }
+
+}  // namespace detail::lexicon
+
+//! Block offsets and leading keys of a lexicon, read in place.
+/*!
+ * Leading keys are stored uncompressed, so that a block can be found with a
+ * binary search directly in (possibly memory mapped) memory, without
+ * building any structure when a lexicon is loaded.
+ *
+ * Memory layout (all integers are 64-bit little-endian):
+ * ```
+ * [block count][block offsets: count][key offsets: count + 1][key bytes]
+ * ```
+ */
+template<class MemoryContainer>
+class lexicon_directory {
+public:
+    using memory_container = MemoryContainer;
+
+    explicit lexicon_directory(memory_container memory)
+        : memory_(std::move(memory))
+    {
+        auto memory_size = static_cast<std::uint64_t>(memory_.size());
+        if (memory_size < sizeof(std::uint64_t)) {
+            throw std::runtime_error("lexicon directory is truncated");
+        }
+        block_count_ = detail::lexicon::load_word(memory_.data());
+        keys_offset_ = (2 * block_count_ + 2) * sizeof(std::uint64_t);
+        if (keys_offset_ > memory_size
+            || keys_offset_ + key_offset(memory_.data(), block_count_)
+                > memory_size) {
+            throw std::runtime_error(fmt::format(
+                "lexicon directory size {} does not match its header",
+                memory_size));
+        }
+    }
+
+    std::ptrdiff_t size() const { return block_count_; }
+
+    std::ptrdiff_t block_offset(std::ptrdiff_t block) const
+    {
+        EXPECTS(block >= 0 && block < size());
+        return detail::lexicon::load_word(
+            memory_.data() + (block + 1) * sizeof(std::uint64_t));
+    }
+
+    std::string_view leading_key(std::ptrdiff_t block) const
+    {
+        EXPECTS(block >= 0 && block < size());
+        return leading_key(memory_.data(), block);
+    }
+
+    //! Returns the last block whose leading key is not greater than `key`.
+    std::optional<std::ptrdiff_t> seek_le(std::string_view key) const
+    {
+        const char* data = memory_.data();
+        std::ptrdiff_t first = 0;
+        std::ptrdiff_t count = block_count_;
+        while (count > 0) {
+            auto step = count / 2;
+            if (leading_key(data, first + step) <= key) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        if (first == 0) { return std::nullopt; }
+        return first - 1;
+    }
+
+    const memory_container& memory() const { return memory_; }
+
+private:
+    memory_container memory_;
+    std::uint64_t block_count_ = 0;
+    std::uint64_t keys_offset_ = 0;
+
+    std::uint64_t key_offset(const char* data, std::uint64_t idx) const
+    {
+        return detail::lexicon::load_word(
+            data + (block_count_ + 1 + idx) * sizeof(std::uint64_t));
+    }
+
+    std::string_view leading_key(const char* data, std::uint64_t block) const
+    {
+        auto first = key_offset(data, block);
+        auto last = key_offset(data, block + 1);
+        return std::string_view(data + keys_offset_ + first, last - first);
+    }
+};
+
+//! Builds the directory memory of a lexicon.
+inline std::vector<char>
+build_lexicon_directory(const std::vector<std::ptrdiff_t>& block_offsets,
+                        const std::vector<std::string>& leading_keys)
+{
+    EXPECTS(block_offsets.size() == leading_keys.size());
+    namespace dl = detail::lexicon;
+    std::vector<char> memory;
+    dl::append_word(block_offsets.size(), memory);
+    for (auto offset : block_offsets) { dl::append_word(offset, memory); }
+    std::uint64_t key_offset = 0;
+    for (const auto& key : leading_keys) {
+        dl::append_word(key_offset, memory);
+        key_offset += key.size();
+    }
+    dl::append_word(key_offset, memory);
+    for (const auto& key : leading_keys) {
+        memory.insert(memory.end(), key.begin(), key.end());
+    }
+    return memory;
+}
+
 template<class C, class M>
 class lexicon {
 public:
@@ -53,21 +211,18 @@ public:
     using index_type = std::ptrdiff_t;
     using codec_type = C;
     using memory_container = M;
+    using directory_type = lexicon_directory<memory_container>;
 
     lexicon() = delete;
-    lexicon(std::vector<std::ptrdiff_t> block_offsets,
-        std::vector<index_type> leading_indices,
+    lexicon(directory_type directory,
         memory_container blocks,
         std::ptrdiff_t count,
         int keys_per_block,
-        std::shared_ptr<irk::radix_tree<int>> leading_keys,  // NOLINT
         irk::prefix_codec<codec_type> codec)
-        : block_offsets_(std::move(block_offsets)),
-          leading_indices_(std::move(leading_indices)),
+        : directory_(std::move(directory)),
           blocks_(std::move(blocks)),
           count_(count),
           keys_per_block_(keys_per_block),
-          leading_keys_(std::move(leading_keys)),
           codec_(std::move(codec))
     {}
     lexicon(const lexicon&) = default;
@@ -76,14 +231,14 @@ public:
     lexicon& operator=(lexicon&&) noexcept = delete;
     ~lexicon() = default;
 
-    irk::memory_view block_memory_view(std::size_t block) const
+    irk::memory_view block_memory_view(std::ptrdiff_t block) const
     {
         EXPECTS(block >= 0);
-        EXPECTS(block < block_offsets_.size());
-        auto block_offset = block_offsets_[block];
-        auto next_block_offset = block + 1 < block_offsets_.size()
-            ? block_offsets_[block + 1]
-            : blocks_.size();
+        EXPECTS(block < directory_.size());
+        auto block_offset = directory_.block_offset(block);
+        auto next_block_offset = block + 1 < directory_.size()
+            ? directory_.block_offset(block + 1)
+            : static_cast<std::ptrdiff_t>(blocks_.size());
         std::ptrdiff_t size = next_block_offset - block_offset;
         ENSURES(size > 0);
         ENSURES(size <= static_cast<std::ptrdiff_t>(blocks_.size()));
@@ -99,81 +254,173 @@ public:
 
     std::optional<index_type> index_at(const std::string& key) const
     {
-        auto block = leading_keys_->seek_le(key);
+        auto block = directory_.seek_le(key);
         if (not block.has_value()) { return std::nullopt; }
         auto block_memory = block_memory_view(*block);
-        boost::iostreams::stream<boost::iostreams::basic_array_source<char>>
-            buffer(block_memory.data(), block_memory.size());
-        irk::input_bit_stream bin(buffer);
+        irk::memory_bit_stream bin(block_memory.data(), block_memory.size());
 
-        index_type value = leading_indices_[*block];
-        std::string k;
+        index_type value = leading_index(*block);
+        index_type last_value = last_index(*block);
         codec_.reset();
-        codec_.decode(bin, k);
-        int idx = 1;
-        while (k < key && idx++ < keys_per_block_) {
-            codec_.decode(bin, k);
+        std::string_view k = codec_.decode(bin);
+        while (k < key && value < last_value) {
+            k = codec_.decode(bin);
             ++value;
         }
         return k == key ? std::make_optional(value) : std::nullopt;
     }
 
-    std::string key_at(std::ptrdiff_t index) const
+    //! Returns the indices of multiple keys, in the order of `keys`.
+    /*!
+     * Keys are resolved in sorted order, so that each block is decoded at most
+     * once, and consecutive keys falling into the same block continue decoding
+     * where the previous one stopped instead of starting from the block's
+     * leading key. This is equivalent to calling `index_at` for each key.
+     */
+    std::vector<std::optional<index_type>>
+    indices_at(gsl::span<std::string const> keys) const
     {
-        EXPECTS(index < size());
-        auto block_pos = std::prev(std::upper_bound(
-            leading_indices_.begin(), leading_indices_.end(), index));
-        auto block = std::distance(leading_indices_.begin(), block_pos);
-        auto block_memory = block_memory_view(block);
-        boost::iostreams::stream<boost::iostreams::basic_array_source<char>>
-            buffer(block_memory.data(), block_memory.size());
-        irk::input_bit_stream bin(buffer);
+        std::vector<std::optional<index_type>> indices(keys.size());
+        std::vector<std::ptrdiff_t> order(keys.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&keys](auto lhs, auto rhs) {
+            return keys[lhs] < keys[rhs];
+        });
+
+        std::optional<std::ptrdiff_t> current_block{};
+        irk::memory_bit_stream bin(nullptr, 0);
+        std::string_view k;
+        index_type value = 0;
+        index_type last_value = 0;
+        for (auto pos : order) {
+            const auto& key = keys[pos];
+            auto block = directory_.seek_le(key);
+            if (not block.has_value()) { continue; }
+            if (block != current_block) {
+                auto block_memory = block_memory_view(*block);
+                bin = irk::memory_bit_stream(
+                    block_memory.data(), block_memory.size());
+                value = leading_index(*block);
+                last_value = last_index(*block);
+                codec_.reset();
+                k = codec_.decode(bin);
+                current_block = block;
+            }
+            while (k < key && value < last_value) {
+                k = codec_.decode(bin);
+                ++value;
+            }
+            if (k == key) { indices[pos] = value; }
+        }
+        return indices;
+    }
 
-        index_type value = *block_pos;
-        std::string key;
+    //! Returns the index of the first key not less than `key`.
+    /*!
+     * Since keys are sorted, this is the number of keys less than `key`,
+     * and it equals `size()` if there are none.
+     */
+    index_type lower_bound(std::string_view key) const
+    {
+        auto block = directory_.seek_le(key);
+        if (not block.has_value()) { return 0; }
+        index_type value = leading_index(*block);
+        if (directory_.leading_key(*block) == key) { return value; }
+        auto block_memory = block_memory_view(*block);
+        irk::memory_bit_stream bin(block_memory.data(), block_memory.size());
+        index_type last_value = last_index(*block);
         codec_.reset();
-        codec_.decode(bin, key);
-        while (value < index) {
-            codec_.decode(bin, key);
+        std::string_view k = codec_.decode(bin);
+        while (k < key && value < last_value) {
+            k = codec_.decode(bin);
             ++value;
         }
-        return key;
+        return k < key ? value + 1 : value;
     }
 
-    std::ostream& serialize(std::ostream& out) const
+    //! Returns the interval of indices `[first, last)` of keys in `[lo, hi)`.
+    std::pair<index_type, index_type>
+    range(std::string_view lo, std::string_view hi) const
     {
-        std::vector<char> header(max_serialized_header_size());
-        vbyte_codec<std::ptrdiff_t> intcodec;
-        auto header_iter = std::begin(header);
-
-        std::advance(header_iter, intcodec.encode(&count_, header_iter));
-        auto size = block_offsets_.size();
-        std::advance(header_iter, intcodec.encode(&size, header_iter));
-        std::advance(
-            header_iter, intcodec.encode(&keys_per_block_, header_iter));
+        auto first = lower_bound(lo);
+        if (hi <= lo) { return {first, first}; }
+        return {first, lower_bound(hi)};
+    }
 
-        for (const auto& offset : block_offsets_)
-        { std::advance(header_iter, intcodec.encode(&offset, header_iter)); }
-        for (const auto& index : leading_indices_)
-        { std::advance(header_iter, intcodec.encode(&index, header_iter)); }
+    //! Returns the interval of indices `[first, last)` of keys with `prefix`.
+    std::pair<index_type, index_type> prefix_range(std::string_view prefix) const
+    {
+        std::string upper(prefix);
+        while (not upper.empty()
+               && static_cast<unsigned char>(upper.back()) == 0xFFu) {
+            upper.pop_back();
+        }
+        if (upper.empty()) { return {lower_bound(prefix), count_}; }
+        upper.back() = static_cast<char>(
+            static_cast<unsigned char>(upper.back()) + 1);
+        return {lower_bound(prefix), lower_bound(upper)};
+    }
 
-        header.resize(std::distance(std::begin(header), header_iter));
+    std::string key_at(std::ptrdiff_t index) const
+    {
+        std::string key;
+        key_at(index, key);
+        return key;
+    }
 
-        boost::iostreams::stream<
-            boost::iostreams::back_insert_device<std::vector<char>>>
-            buffer(boost::iostreams::back_inserter(header));
+    //! Writes the key at `index` to a reusable `buffer`.
+    /*!
+     * Keys within the block are decoded in place, so nothing is allocated
+     * unless `buffer` has to grow. The returned view points to `buffer`.
+     */
+    std::string_view key_at(std::ptrdiff_t index, std::string& buffer) const
+    {
+        EXPECTS(index >= 0 && index < size());
+        auto block = index / keys_per_block_;
+        auto block_memory = block_memory_view(block);
+        irk::memory_bit_stream bin(block_memory.data(), block_memory.size());
 
-        dump_coding_tree(buffer);
-        dump_leading_keys(buffer);
-        buffer.flush();
+        index_type value = leading_index(block);
+        codec_.reset();
+        std::string_view key = codec_.decode(bin);
+        while (value < index) {
+            key = codec_.decode(bin);
+            ++value;
+        }
+        buffer.assign(key.data(), key.size());
+        return buffer;
+    }
 
-        std::ptrdiff_t header_size = header.size() + sizeof(std::ptrdiff_t);
-        out.write(
-            reinterpret_cast<char*>(&header_size), sizeof(std::ptrdiff_t));
-        out.write(&header[0], header.size());
+    //! Writes the lexicon in a format that can be loaded without decoding.
+    /*!
+     * Layout (all integers are 64-bit little-endian; sections are padded to
+     * a multiple of 8 bytes):
+     * ```
+     * [format marker][key count][keys per block][tree size][directory size]
+     * [coding tree][directory][blocks]
+     * ```
+     * See `lexicon_directory` for the directory layout.
+     */
+    std::ostream& serialize(std::ostream& out) const
+    {
+        namespace dl = detail::lexicon;
+        const auto& tree = codec_.codec().tree().memory_container();
+        const auto& directory = directory_.memory();
+        std::vector<char> header;
+        dl::append_word(dl::format_marker, header);
+        dl::append_word(count_, header);
+        dl::append_word(keys_per_block_, header);
+        dl::append_word(tree.size(), header);
+        dl::append_word(directory.size(), header);
+        header.insert(header.end(), tree.data(), tree.data() + tree.size());
+        dl::pad(header);
+        out.write(header.data(), header.size());
+        out.write(directory.data(), directory.size());
+        std::vector<char> padding(
+            dl::padded(directory.size()) - directory.size(), 0);
+        out.write(padding.data(), padding.size());
+        out.write(blocks_.data(), blocks_.size());
         out.flush();
-
-        dump_blocks(out);
         return out;
     }
 
@@ -219,7 +466,6 @@ public:
             {
                 pos_in_block_ = 0;
                 block_num_++;
-                decoded_block_.clear();
                 decode_block(block_num_, decoded_block_);
             }
         }
@@ -235,23 +481,25 @@ public:
             return decoded_block_[pos_in_block_];
         }
 
+        //! Decodes a block, overwriting the strings decoded from the
+        //! previous one, so that their memory is reused.
         void decode_block(int block, std::vector<std::string>& keys) const
         {
-            if (block
-                >= static_cast<std::ptrdiff_t>(lex_.block_offsets_.size())) {
-                return;
-            }
+            if (block >= lex_.directory_.size()) { return; }
             auto block_memory = lex_.block_memory_view(block);
-            boost::iostreams::stream<boost::iostreams::basic_array_source<char>>
-                buffer(block_memory.data(), block_memory.size());
-            irk::input_bit_stream bin(buffer);
+            irk::memory_bit_stream bin(
+                block_memory.data(), block_memory.size());
 
+            auto key_count =
+                lex_.last_index(block) - lex_.leading_index(block) + 1;
+            if (static_cast<index_type>(keys.size()) < key_count) {
+                keys.resize(key_count);
+            }
             codec_.reset();
-            for (index_type idx = 0; idx < keys_per_block_; ++idx)
+            for (index_type idx = 0; idx < key_count; ++idx)
             {
-                std::string key;
-                codec_.decode(bin, key);
-                keys.push_back(key);
+                auto key = codec_.decode(bin);
+                keys[idx].assign(key.data(), key.size());
             }
         }
 
@@ -260,7 +508,6 @@ public:
         int block_num_;
         int pos_in_block_;
         int keys_per_block_;
-        mutable std::string val_;
         mutable std::vector<std::string> decoded_block_;
         const irk::prefix_codec<codec_type>& codec_;
     };
@@ -271,8 +518,8 @@ public:
     }
 
     iterator end() const {
-        auto block_count = block_offsets_.size();
-        auto pos_in_block = (count_ - leading_indices_.back())
+        auto block_count = directory_.size();
+        auto pos_in_block = (count_ - leading_index(block_count - 1))
             % keys_per_block_;
         auto block = pos_in_block == 0 ? block_count : block_count - 1;
         return iterator(*this,
@@ -285,122 +532,287 @@ public:
 
     int keys_per_block() const { return keys_per_block_; }
 
+    const directory_type& directory() const { return directory_; }
+    const memory_container& blocks() const { return blocks_; }
+
 private:
-    std::vector<std::ptrdiff_t> block_offsets_;
-    std::vector<index_type> leading_indices_;
+    directory_type directory_;
     memory_container blocks_;
     std::ptrdiff_t count_;
     int keys_per_block_;
-    std::shared_ptr<irk::radix_tree<int>> leading_keys_;
     irk::prefix_codec<codec_type> codec_;
 
-    std::ptrdiff_t max_serialized_header_size() const
+    //! Every block but the last holds exactly `keys_per_block_` keys.
+    index_type leading_index(std::ptrdiff_t block) const
     {
-        auto size = block_offsets_.size();
-        return sizeof(count_) + sizeof(size) + sizeof(keys_per_block_)
-            + size * sizeof(block_offsets_[0])
-            + size * sizeof(leading_indices_[0]);
+        return block * keys_per_block_;
     }
 
-    std::ostream& dump_coding_tree(std::ostream& out) const
+    //! Returns the index of the last key in `block`.
+    index_type last_index(std::ptrdiff_t block) const
     {
-        auto coding_tree = codec_.codec().tree();
-        auto mem = coding_tree.memory_container();
-        std::size_t tree_size = mem.size();
-        out.write(reinterpret_cast<char*>(&tree_size), sizeof(tree_size));
-        out.write(mem.data(), tree_size);
-        out.flush();
-        return out;
+        return std::min<index_type>(
+                   leading_index(block) + keys_per_block_, count_)
+            - 1;
     }
+};
 
-    std::ostream& dump_blocks(std::ostream& out) const
-    {
-        std::size_t blocks_size = blocks_.size();
-        out.write(blocks_.data(), blocks_size);
-        return out;
-    }
+template<class C>
+using lexicon_view = lexicon<C, irk::memory_view>;
 
-    std::ostream& dump_leading_keys(std::ostream& out) const
+namespace detail::lexicon {
+
+    //! Loads a lexicon written before the directory was stored in place.
+    /*!
+     * The block offsets and leading keys are decoded and a directory is built
+     * in memory, so this is slower than loading the current format.
+     */
+    inline lexicon_view<hutucker_codec<char>>
+    load_legacy_lexicon(const irk::memory_view& memory)
     {
-        output_bit_stream bout(out);
-        irk::prefix_codec<codec_type> encoder(codec_.codec());
-        for (const auto& block : boost::irange<int>(0, block_offsets_.size()))
-        {
-            codec_.reset();
-            auto buffer = block_memory_view(block).stream();
-            irk::input_bit_stream bin(buffer);
+        // Total header size: everything that will be always read to memory.
+        auto header_size =
+            memory.range(0, sizeof(ptrdiff_t)).as<std::ptrdiff_t>();
+        auto header_memory = memory(sizeof(ptrdiff_t), header_size);
+        irk::vbyte_codec<std::ptrdiff_t> intcodec;
+        auto header_iter = header_memory.begin();
+
+        // Block metadata
+        std::ptrdiff_t block_count, value_count, keys_per_block;
+        std::vector<std::ptrdiff_t> block_offsets;
+        header_iter = intcodec.decode(header_iter, &value_count);
+        header_iter = intcodec.decode(header_iter, &block_count);
+        header_iter = intcodec.decode(header_iter, &keys_per_block);
+        for (int idx : boost::irange<int>(0, block_count)) {
+            (void)idx;
+            std::ptrdiff_t offset;
+            header_iter = intcodec.decode(header_iter, &offset);
+            block_offsets.push_back(offset);
+        }
+        for (int idx : boost::irange<int>(0, block_count)) {
+            std::ptrdiff_t first_index;
+            header_iter = intcodec.decode(header_iter, &first_index);
+            if (first_index != idx * keys_per_block) {
+                throw std::runtime_error(
+                    "lexicon blocks are not of uniform size");
+            }
+        }
+
+        // Encoding tree
+        std::size_t tree_size =
+            *reinterpret_cast<const std::size_t*>(&*header_iter);
+        std::advance(header_iter, sizeof(std::size_t));
+        auto tree_end = std::next(header_iter, tree_size);
+        std::vector<char> tree_data(header_iter, tree_end);
+        alphabetical_bst<> encoding_tree(std::move(tree_data));
+        hutucker_codec<char> ht_codec(std::move(encoding_tree));
+
+        // Block leading values
+        irk::memory_bit_stream bin(
+            tree_end,
+            header_size - std::distance(header_memory.begin(), tree_end)
+                - sizeof(header_size));
+        auto pcodec =
+            irk::prefix_codec<hutucker_codec<char>>(std::move(ht_codec));
+        std::vector<std::string> leading_keys;
+        for (int idx : boost::irange<int>(0, block_count)) {
+            (void)idx;
             std::string key;
-            codec_.decode(bin, key);
-            encoder.encode(key, bout);
+            pcodec.decode(bin, key);
+            leading_keys.push_back(std::move(key));
         }
-        bout.flush();
-        return out;
+        auto directory = std::make_shared<const std::vector<char>>(
+            build_lexicon_directory(block_offsets, leading_keys));
+        return lexicon_view<hutucker_codec<char>>(
+            lexicon_directory<irk::memory_view>(
+                irk::memory_view(irk::shared_memory_source(directory))),
+            memory(header_size, memory.size()),
+            value_count,
+            keys_per_block,
+            std::move(pcodec));
     }
-};
 
-template<class C>
-using lexicon_view = lexicon<C, irk::memory_view>;
+}  // namespace detail::lexicon
 
+//! Loads a lexicon from memory.
+/*!
+ * Only the coding tree is copied; blocks and the block directory are read in
+ * place. Lexicons written in the older format are also supported.
+ */
 inline lexicon_view<hutucker_codec<char>>
 load_lexicon(const irk::memory_view& memory)
 {
-    // Total header size: everything that will be always read to memory.
-    auto header_size = memory.range(0, sizeof(ptrdiff_t)).as<std::ptrdiff_t>();
-    auto header_memory = memory(sizeof(ptrdiff_t), header_size);
-    irk::vbyte_codec<std::ptrdiff_t> intcodec;
-    auto header_iter = header_memory.begin();
-
-    // Block metadata
-    std::ptrdiff_t block_count, value_count, keys_per_block;
-    std::vector<std::ptrdiff_t> block_offsets;
-    std::vector<std::ptrdiff_t> leading_indices;
-    header_iter = intcodec.decode(header_iter, &value_count);
-    header_iter = intcodec.decode(header_iter, &block_count);
-    header_iter = intcodec.decode(header_iter, &keys_per_block);
-    for (int idx : boost::irange<int>(0, block_count)) {
-        (void)idx;
-        std::ptrdiff_t offset;
-        header_iter = intcodec.decode(header_iter, &offset);
-        block_offsets.push_back(offset);
-    }
-    for (int idx : boost::irange<int>(0, block_count)) {
-        (void)idx;
-        std::ptrdiff_t first_index;
-        header_iter = intcodec.decode(header_iter, &first_index);
-        leading_indices.push_back(first_index);
-    }
-
-    // Encoding tree
-    std::size_t tree_size = *reinterpret_cast<const std::size_t*>(
-        &*header_iter);
-    std::advance(header_iter, sizeof(std::size_t));
-    auto tree_end = std::next(header_iter, tree_size);
-    std::vector<char> tree_data(header_iter, tree_end);
-    alphabetical_bst<> encoding_tree(std::move(tree_data));
-    hutucker_codec<char> ht_codec(std::move(encoding_tree));
-
-    // Block leading values
-    boost::iostreams::stream<boost::iostreams::basic_array_source<char>> buffer(
-        tree_end,
-        header_size - std::distance(header_memory.begin(), tree_end)
-            - sizeof(header_size));
-    irk::input_bit_stream bin(buffer);
-    auto leading_keys = std::make_shared<irk::radix_tree<int>>();
-    auto pcodec = irk::prefix_codec<hutucker_codec<char>>(std::move(ht_codec));
-    for (int idx : boost::irange<int>(0, block_count)) {
-        std::string key;
-        pcodec.decode(bin, key);
-        leading_keys->insert(key, idx);
+    namespace dl = detail::lexicon;
+    constexpr std::ptrdiff_t header_size = 5 * sizeof(std::uint64_t);
+    if (memory.size() < header_size) {
+        throw std::runtime_error("lexicon is truncated");
+    }
+    const char* data = memory.data();
+    auto marker = static_cast<std::int64_t>(dl::load_word(data));
+    if (marker != dl::format_marker) {
+        return dl::load_legacy_lexicon(memory);
+    }
+    auto count = dl::load_word(data + 8);
+    auto keys_per_block = dl::load_word(data + 16);
+    auto tree_size = dl::load_word(data + 24);
+    auto directory_size = dl::load_word(data + 32);
+    std::uint64_t directory_offset = header_size + dl::padded(tree_size);
+    std::uint64_t blocks_offset =
+        directory_offset + dl::padded(directory_size);
+    if (blocks_offset > static_cast<std::uint64_t>(memory.size())) {
+        throw std::runtime_error("lexicon is truncated");
     }
-    return lexicon_view<hutucker_codec<char>>(std::move(block_offsets),
-        std::move(leading_indices),
-        memory(header_size, memory.size()),
-        value_count,
+
+    std::vector<char> tree_data(
+        data + header_size, data + header_size + tree_size);
+    hutucker_codec<char> ht_codec(alphabetical_bst<>(std::move(tree_data)));
+    return lexicon_view<hutucker_codec<char>>(
+        lexicon_directory<irk::memory_view>(
+            memory(directory_offset, directory_offset + directory_size)),
+        memory(blocks_offset, memory.size()),
+        count,
         keys_per_block,
-        leading_keys,
-        std::move(pcodec));
+        irk::prefix_codec<hutucker_codec<char>>(std::move(ht_codec)));
 }
 
+namespace detail::lexicon {
+
+    //! Number of blocks encoded by a single task when building in parallel.
+    constexpr std::ptrdiff_t blocks_per_chunk = 1024;
+
+    //! Encoded blocks with offsets relative to the beginning of `blocks`.
+    struct encoded_blocks {
+        std::vector<char> blocks{};
+        std::vector<std::ptrdiff_t> block_offsets{};
+        std::vector<std::string> leading_keys{};
+        std::ptrdiff_t count = 0;
+    };
+
+    //! Encodes keys in blocks of `keys_per_block`; each block starts at a
+    //! byte boundary and with a reset prefix, so blocks are independent.
+    template<class KeyIterator>
+    encoded_blocks encode_blocks(KeyIterator keys_begin,
+        KeyIterator keys_end,
+        const hutucker_codec<char>& codec,
+        int keys_per_block)
+    {
+        encoded_blocks encoded;
+        boost::iostreams::stream<
+            boost::iostreams::back_insert_device<std::vector<char>>>
+            buffer(boost::iostreams::back_inserter(encoded.blocks));
+        irk::output_bit_stream bout(buffer);
+        irk::prefix_codec<hutucker_codec<char>> pcodec(codec);
+        while (keys_begin != keys_end) {
+            encoded.block_offsets.push_back(encoded.blocks.size());
+            ++encoded.count;
+            std::string leading_key(*keys_begin++);
+            pcodec.reset();
+            pcodec.encode(leading_key, bout);
+            encoded.leading_keys.push_back(std::move(leading_key));
+            for (int idx_in_block = 1;
+                 idx_in_block < keys_per_block && keys_begin != keys_end;
+                 ++idx_in_block, ++encoded.count, ++keys_begin) {
+                pcodec.encode(*keys_begin, bout);
+            }
+            bout.flush();
+        }
+        return encoded;
+    }
+
+    template<class KeyIterator>
+    std::vector<std::size_t>
+    symbol_frequencies(KeyIterator first, KeyIterator last)
+    {
+        std::vector<std::size_t> frequencies(256, 0);
+        for (; first != last; ++first) {
+            for (const char& ch : *first)
+            { ++frequencies[static_cast<unsigned char>(ch)]; }
+        }
+        return frequencies;
+    }
+
+    //! Counts symbols in parallel chunks of a random-access range.
+    template<class KeyIterator>
+    std::vector<std::size_t>
+    parallel_symbol_frequencies(KeyIterator first, KeyIterator last)
+    {
+        return tbb::parallel_reduce(
+            tbb::blocked_range<std::ptrdiff_t>(0, std::distance(first, last)),
+            std::vector<std::size_t>(256, 0),
+            [first](const tbb::blocked_range<std::ptrdiff_t>& range,
+                    std::vector<std::size_t> frequencies) {
+                auto chunk = symbol_frequencies(
+                    std::next(first, range.begin()),
+                    std::next(first, range.end()));
+                std::transform(frequencies.begin(),
+                    frequencies.end(),
+                    chunk.begin(),
+                    frequencies.begin(),
+                    std::plus<>{});
+                return frequencies;
+            },
+            [](std::vector<std::size_t> lhs,
+               const std::vector<std::size_t>& rhs) {
+                std::transform(lhs.begin(),
+                    lhs.end(),
+                    rhs.begin(),
+                    lhs.begin(),
+                    std::plus<>{});
+                return lhs;
+            });
+    }
+
+    //! Encodes chunks of blocks in parallel and concatenates them.
+    /*!
+     * The result is byte-for-byte the same as of `encode_blocks` called on
+     * the entire range.
+     */
+    template<class KeyIterator>
+    encoded_blocks parallel_encode_blocks(KeyIterator keys_begin,
+        KeyIterator keys_end,
+        const hutucker_codec<char>& codec,
+        int keys_per_block)
+    {
+        std::ptrdiff_t key_count = std::distance(keys_begin, keys_end);
+        std::ptrdiff_t chunk_size = blocks_per_chunk * keys_per_block;
+        std::ptrdiff_t chunk_count = (key_count + chunk_size - 1) / chunk_size;
+        std::vector<encoded_blocks> chunks(chunk_count);
+        tbb::parallel_for(std::ptrdiff_t{0}, chunk_count, [&](auto chunk) {
+            auto first = chunk * chunk_size;
+            auto last = std::min(first + chunk_size, key_count);
+            chunks[chunk] = encode_blocks(std::next(keys_begin, first),
+                std::next(keys_begin, last),
+                codec,
+                keys_per_block);
+        });
+
+        encoded_blocks encoded;
+        std::size_t total_size = 0;
+        for (const auto& chunk : chunks) { total_size += chunk.blocks.size(); }
+        encoded.blocks.reserve(total_size);
+        for (auto& chunk : chunks) {
+            std::ptrdiff_t shift = encoded.blocks.size();
+            for (auto offset : chunk.block_offsets) {
+                encoded.block_offsets.push_back(shift + offset);
+            }
+            std::move(chunk.leading_keys.begin(),
+                chunk.leading_keys.end(),
+                std::back_inserter(encoded.leading_keys));
+            encoded.blocks.insert(
+                encoded.blocks.end(), chunk.blocks.begin(), chunk.blocks.end());
+            encoded.count += chunk.count;
+            chunk = encoded_blocks{};
+        }
+        return encoded;
+    }
+
+    template<class Iterator>
+    constexpr bool is_random_access = std::is_base_of_v<
+        std::random_access_iterator_tag,
+        typename std::iterator_traits<Iterator>::iterator_category>;
+
+}  // namespace detail::lexicon
+
 //! Build a lexicon in memory.
 //!
 //! \param keys_begin   begin iterator of keys to insert
@@ -412,6 +824,9 @@ load_lexicon(const irk::memory_view& memory)
 //! Typically, both keys and corpus will be the same collection.
 //! They are separated mainly for situations when these are single-pass
 //! iterators. See overloads for a more convenient interface.
+//!
+//! If the iterators are random-access, symbols are counted and blocks are
+//! encoded in parallel; the resulting lexicon is identical.
 template<class KeyIterator, class CorpusIterator>
 lexicon<hutucker_codec<char>, std::vector<char>> build_lexicon(
     KeyIterator keys_begin,
@@ -422,51 +837,32 @@ lexicon<hutucker_codec<char>, std::vector<char>> build_lexicon(
 {
     EXPECTS(keys_begin != keys_end);
     EXPECTS(corpus_begin != corpus_end);
+    namespace dl = detail::lexicon;
 
-    std::vector<std::size_t> frequencies(256, 0);
-    for (; corpus_begin != corpus_end; ++corpus_begin)
-    {
-        for (const char& ch : *corpus_begin)
-        { ++frequencies[static_cast<unsigned char>(ch)]; }
-    }
+    auto frequencies = [&]() {
+        if constexpr (dl::is_random_access<CorpusIterator>) {  // NOLINT
+            return dl::parallel_symbol_frequencies(corpus_begin, corpus_end);
+        } else {  // NOLINT
+            return dl::symbol_frequencies(corpus_begin, corpus_end);
+        }
+    }();
     auto codec = hutucker_codec<char>(frequencies);
-
-    std::vector<std::ptrdiff_t> block_offsets;
-    std::vector<std::ptrdiff_t> leading_indices;
-    auto leading_keys = std::make_shared<irk::radix_tree<int>>();
-    std::vector<char> blocks;
-    boost::iostreams::stream<
-        boost::iostreams::back_insert_device<std::vector<char>>>
-        buffer(boost::iostreams::back_inserter(blocks));
-    irk::output_bit_stream bout(buffer);
-    auto pcodec = irk::prefix_codec<hutucker_codec<char>>(std::move(codec));
-
-    std::ptrdiff_t index = 0;
-    int block_idx = 0;
-    while (keys_begin != keys_end) {
-        block_offsets.push_back(blocks.size());
-        leading_indices.push_back(index++);
-        std::string leading_key = *keys_begin++;
-        leading_keys->insert(leading_key, block_idx);
-        pcodec.reset();
-        pcodec.encode(leading_key, bout);
-        for (int idx_in_block = 1;
-             idx_in_block < keys_per_block && keys_begin != keys_end;
-             ++idx_in_block, ++index, ++keys_begin) {
-            pcodec.encode(*keys_begin, bout);
+    auto encoded = [&]() {
+        if constexpr (dl::is_random_access<KeyIterator>) {  // NOLINT
+            return dl::parallel_encode_blocks(
+                keys_begin, keys_end, codec, keys_per_block);
+        } else {  // NOLINT
+            return dl::encode_blocks(
+                keys_begin, keys_end, codec, keys_per_block);
         }
-        ++block_idx;
-        bout.flush();
-    }
-    pcodec.reset();
+    }();
     return lexicon<irk::hutucker_codec<char>, std::vector<char>>(
-        std::move(block_offsets),
-        std::move(leading_indices),
-        std::move(blocks),
-        index,
+        lexicon_directory<std::vector<char>>(build_lexicon_directory(
+            encoded.block_offsets, encoded.leading_keys)),
+        std::move(encoded.blocks),
+        encoded.count,
         keys_per_block,
-        leading_keys,
-        std::move(pcodec));
+        irk::prefix_codec<hutucker_codec<char>>(std::move(codec)));
 }
 
 inline lexicon<hutucker_codec<char>, std::vector<char>>
@@ -476,17 +872,23 @@ build_lexicon(const std::vector<std::string>& keys, int keys_per_block)
         keys.begin(), keys.end(), keys.begin(), keys.end(), keys_per_block);
 }
 
+//! Builds a lexicon of the lines of `file`.
+//!
+//! The file is memory-mapped, and the lexicon is built in parallel over
+//! views of its lines: only the leading key of each block is copied.
 inline lexicon<hutucker_codec<char>, std::vector<char>>
 build_lexicon(const boost::filesystem::path& file, int keys_per_block)
 {
-    std::ifstream keys(file.c_str());
-    std::ifstream corpus(file.c_str());
+    boost::iostreams::mapped_file_source source(file.string());
+    std::string_view data(source.data(), source.size());
+    std::vector<std::string_view> keys;
+    while (not data.empty()) {
+        auto end = std::min(data.find('\n'), data.size());
+        keys.push_back(data.substr(0, end));
+        data.remove_prefix(std::min(end + 1, data.size()));
+    }
     return build_lexicon(
-        irk::io::line_iterator(keys),
-        irk::io::line_iterator(),
-        irk::io::line_iterator(corpus),
-        irk::io::line_iterator(),
-        keys_per_block);
+        keys.begin(), keys.end(), keys.begin(), keys.end(), keys_per_block);
 }
 
 }  // namespace irk
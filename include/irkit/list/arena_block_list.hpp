@@ -0,0 +1,265 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <gsl/span>
+
+#include <irkit/arena.hpp>
+#include <irkit/list/standard_block_list.hpp>
+
+namespace ir {
+
+//! A read-only view of a list in the `Standard_Block_List` format backed by an arena.
+/*!
+ * Unlike `Standard_Block_List`, this list does not allocate on the heap:
+ * the block offsets and upper bounds decoded from the header (unless it is
+ * fixed-width, in which case they are read in place), as well as decoded
+ * blocks, are all stored in memory taken from the arena passed at
+ * construction. The arena must outlive the list, and must not be reset while
+ * the list or any of its iterators are in use. A typical use is to construct
+ * the lists of a query with `thread_arena()`, and reset it once the query is
+ * processed.
+ *
+ * `inverted_index_view::postings` and `scored_postings` return lists of this
+ * type when given an arena, which is how `Query_Engine` reads postings.
+ */
+template<class Value, class Codec, bool delta_encoded>
+class Arena_Block_List {
+public:
+    using size_type      = std::int32_t;
+    using value_type     = Value;
+    using iterator       = Block_Iterator<Arena_Block_List<Value, Codec, delta_encoded>>;
+    using const_iterator = iterator;
+    using codec_type     = Codec;
+
+    Arena_Block_List() = default;
+    Arena_Block_List(irk::index::term_id_t term_id,
+                     irk::memory_view mem,
+                     size_type length,
+                     Arena& arena)
+        : term_id_(term_id), length_(length), memory_(std::move(mem)), arena_(&arena)
+    {
+        Block_List_Header header;
+        auto pos = read_block_list_header<codec_type, delta_encoded>(term_id, memory_, header);
+        block_size_ = header.block_size;
+        block_count_ = header.block_count;
+        format_ = header.format;
+        auto num_blocks = header.block_count;
+        decoded_blocks_ = arena.allocate<value_type*>(num_blocks, nullptr);
+        if (delta_encoded && is_fixed_width() && sizeof(value_type) != sizeof(std::int32_t)) {
+            panic(fmt::format("fixed-width list of term {} requires 32-bit values", term_id));
+        }
+
+        if constexpr (delta_encoded) {
+            if (is_bitmap()) {
+                irk::vbyte_codec<int64_t> vb;
+                pos = vb.decode(pos, &bitmap_base_);
+                pos = read_upper_bounds(pos, num_blocks, arena);
+                bitmap_ = pos;
+                return;
+            }
+        }
+
+        if (is_fixed_width()) {
+            if (has_variable_blocks()) {
+                block_ends_ = {pos, num_blocks};
+                pos += num_blocks * sizeof(size_type);
+            }
+            block_offsets_ = {pos, num_blocks};
+            pos += num_blocks * sizeof(size_type);
+            if constexpr (delta_encoded) {
+                read_upper_bounds(pos, num_blocks, arena);
+            }
+            return;
+        }
+
+        irk::vbyte_codec<size_type> vb;
+        if (has_variable_blocks()) {
+            auto block_ends = arena.allocate<size_type>(num_blocks);
+            pos = vb.delta_decode(pos, block_ends.data(), num_blocks, 0);
+            block_ends_ = Unaligned_Span<size_type>(block_ends);
+        }
+        auto block_offsets = arena.allocate<size_type>(num_blocks);
+        pos = vb.decode(pos, block_offsets.data(), num_blocks);
+        if constexpr (delta_encoded) {
+            pos = read_upper_bounds(pos, num_blocks, arena);
+        }
+        auto offset = static_cast<size_type>(std::distance(memory_.begin(), pos));
+        for (auto& block_offset : block_offsets) {
+            offset += block_offset;
+            block_offset = offset;
+        }
+        block_offsets_ = Unaligned_Span<size_type>(block_offsets);
+    }
+    Arena_Block_List(const Arena_Block_List&)     = default;
+    Arena_Block_List(Arena_Block_List&&) noexcept = default;
+    Arena_Block_List& operator=(const Arena_Block_List&) = default;
+    Arena_Block_List& operator=(Arena_Block_List&&) noexcept = default;
+    ~Arena_Block_List() = default;
+
+    [[nodiscard]] constexpr auto size() const -> size_type { return length_; }
+    [[nodiscard]] constexpr auto block_count() const noexcept -> size_type
+    {
+        return block_count_;
+    }
+
+    [[nodiscard]] constexpr auto begin() const noexcept -> iterator
+    {
+        return iterator({0, 0}, *this);
+    }
+    [[nodiscard]] constexpr auto end() const noexcept -> iterator
+    {
+        if (has_variable_blocks()) {
+            return iterator{{block_count_, 0}, *this};
+        }
+        return iterator{iterator::end(length_, block_size_, block_count()), *this};
+    }
+    [[nodiscard]] constexpr auto lookup(value_type id) const -> iterator
+    {
+        static_assert(delta_encoded, "must be delta encoded");
+        return begin().next_ge(id);
+    }
+    [[nodiscard]] constexpr auto term_id() const -> auto const& { return term_id_; }
+
+    [[nodiscard]] constexpr auto block_size() const -> size_type { return block_size_; }
+    [[nodiscard]] constexpr auto block_size(size_type n) const noexcept -> size_type
+    {
+        if (has_variable_blocks()) {
+            return n > 0 ? block_ends_[n] - block_ends_[n - 1] : block_ends_[0];
+        }
+        size_type block_count = this->block_count();
+        return n < block_count - 1 ? block_size_ : length_ - ((block_count - 1) * block_size_);
+    }
+
+    //! Returns the decoded block `n`, decoding it into the arena on first access.
+    [[nodiscard]] auto block(size_type n) const -> gsl::span<value_type const>
+    {
+        auto count = block_size(n);
+        auto& decoded_block = decoded_blocks_[n];
+        if (decoded_block == nullptr) {
+            // Full blocks are allocated even for the last one, as the codec
+            // may write past the decoded values.
+            decoded_block = arena_->allocate<value_type>(block_size_).data();
+            if constexpr (delta_encoded) {  // NOLINT
+                if (is_bitmap()) {
+                    auto first = n > 0 ? upper_bounds_[n - 1] + 1 : bitmap_base_;
+                    decode_bitmap_block(bitmap_, bitmap_base_, first, decoded_block, count);
+                } else {
+                    auto preceding = n > 0 ? upper_bounds_[n - 1] : value_type{0};
+                    with_codec([&](auto const& codec) {
+                        codec.delta_decode(block_data(n), decoded_block, count, preceding);
+                    });
+                }
+            } else {
+                with_codec([&](auto const& codec) {
+                    codec.decode(block_data(n), decoded_block, count);
+                });
+            }
+        }
+        return gsl::make_span<value_type const>(decoded_block, count);
+    }
+
+    [[nodiscard]] constexpr auto upper_bounds() const -> Unaligned_Span<value_type>
+    {
+        return upper_bounds_;
+    }
+    [[nodiscard]] constexpr auto block_ends() const -> Unaligned_Span<size_type>
+    {
+        return block_ends_;
+    }
+    [[nodiscard]] auto memory() const -> irk::memory_view const& { return memory_; };
+    [[nodiscard]] constexpr auto format() const -> Block_List_Format const& { return format_; }
+
+    [[nodiscard]] constexpr auto is_bitmap() const -> bool
+    {
+        return (format_.flags & Block_List_Format::Bitmap) != 0;
+    }
+
+    [[nodiscard]] constexpr auto is_fixed_width() const -> bool
+    {
+        return (format_.flags & Block_List_Format::Fixed_Width) != 0;
+    }
+
+    [[nodiscard]] constexpr auto has_variable_blocks() const -> bool
+    {
+        return (format_.flags & Block_List_Format::Variable_Blocks) != 0;
+    }
+
+    [[nodiscard]] constexpr static bool is_delta_encoded() { return delta_encoded; }
+
+private:
+    //! Points to upper bounds in a fixed-width header, or decodes them into the arena.
+    auto read_upper_bounds(char const* pos, size_type num_blocks, Arena& arena) -> char const*
+    {
+        if (is_fixed_width()) {
+            upper_bounds_ = {pos, num_blocks};
+            return pos + num_blocks * sizeof(std::int32_t);
+        }
+        auto upper_bounds = arena.allocate<value_type>(num_blocks);
+        pos = codec_.delta_decode(pos, upper_bounds.data(), num_blocks);
+        upper_bounds_ = Unaligned_Span<value_type>(upper_bounds);
+        return pos;
+    }
+
+    [[nodiscard]] auto block_data(size_type n) const -> char const*
+    {
+        return memory_.begin() + block_offsets_[n];
+    }
+
+    template<class Fn>
+    void with_codec(Fn&& fn) const
+    {
+        if constexpr (irk::is_adaptive_codec_v<codec_type>) {
+            codec_.visit(format_.codec_tag, fn);
+        } else {
+            fn(codec_);
+        }
+    }
+
+    irk::index::term_id_t term_id_{};
+    size_type length_{0};
+    size_type block_size_{1};
+    size_type block_count_{0};
+    Block_List_Format format_{};
+    irk::memory_view memory_{};
+    Arena* arena_ = nullptr;
+    codec_type codec_{};
+    char const* bitmap_ = nullptr;
+    value_type bitmap_base_{};
+    Unaligned_Span<size_type> block_ends_{};
+    Unaligned_Span<size_type> block_offsets_{};
+    Unaligned_Span<value_type> upper_bounds_{};
+    gsl::span<value_type*> decoded_blocks_{};
+};
+
+template<class Codec>
+using Arena_Block_Document_List = Arena_Block_List<irk::index::document_t, Codec, true>;
+
+template<class Payload, class Codec>
+using Arena_Block_Payload_List = Arena_Block_List<Payload, Codec, false>;
+
+}  // namespace ir
@@ -26,8 +26,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+
+#include <boost/iterator/iterator_facade.hpp>
 #include <fmt/format.h>
 
+#include <irkit/coding/adaptive.hpp>
 #include <irkit/index/types.hpp>
 #include <irkit/iterator/block_iterator.hpp>
 #include <irkit/memoryview.hpp>
@@ -40,6 +47,235 @@ void panic(std::string_view error)
     std::abort();
 }
 
+//! A read-only array of `T` that is not necessarily aligned.
+/*!
+ * The arrays of a fixed-width header follow its variable-length part, and
+ * thus may start at any byte offset. Elements are therefore copied out with
+ * `memcpy` instead of being accessed through a `T const*`.
+ */
+template<class T>
+class Unaligned_Span {
+public:
+    using value_type = T;
+    using index_type = std::ptrdiff_t;
+
+    class iterator : public boost::iterator_facade<iterator,
+                                                   T const,
+                                                   std::random_access_iterator_tag,
+                                                   T> {
+    public:
+        constexpr iterator() = default;
+        explicit constexpr iterator(char const* pos) : pos_(pos) {}
+
+    private:
+        friend class boost::iterator_core_access;
+
+        [[nodiscard]] auto dereference() const -> T
+        {
+            T value;
+            std::memcpy(&value, pos_, sizeof(T));
+            return value;
+        }
+        [[nodiscard]] auto equal(iterator const& other) const -> bool
+        {
+            return pos_ == other.pos_;
+        }
+        void increment() { pos_ += sizeof(T); }
+        void decrement() { pos_ -= sizeof(T); }
+        void advance(index_type n) { pos_ += n * static_cast<index_type>(sizeof(T)); }
+        [[nodiscard]] auto distance_to(iterator const& other) const -> index_type
+        {
+            return (other.pos_ - pos_) / static_cast<index_type>(sizeof(T));
+        }
+
+        char const* pos_ = nullptr;
+    };
+    using const_iterator = iterator;
+
+    constexpr Unaligned_Span() = default;
+    constexpr Unaligned_Span(char const* data, index_type size) : data_(data), size_(size) {}
+    //! Views decoded, and thus aligned, values.
+    Unaligned_Span(gsl::span<T const> values)
+        : data_(reinterpret_cast<char const*>(values.data())), size_(values.size())
+    {}
+
+    [[nodiscard]] auto operator[](index_type idx) const -> T
+    {
+        T value;
+        std::memcpy(&value, data_ + idx * sizeof(T), sizeof(T));
+        return value;
+    }
+    [[nodiscard]] constexpr auto size() const -> index_type { return size_; }
+    [[nodiscard]] constexpr auto empty() const -> bool { return size_ == 0; }
+    [[nodiscard]] auto begin() const -> iterator { return iterator(data_); }
+    [[nodiscard]] auto end() const -> iterator { return iterator(data_ + size_ * sizeof(T)); }
+
+private:
+    char const* data_ = nullptr;
+    index_type size_ = 0;
+};
+
+//! Optional extension of a block list header.
+/*!
+ * A regular header starts with the list size followed by the (positive)
+ * block size. A zero in place of the block size marks an extended header,
+ * in which it is followed by the layout flags and the codec tag, and only
+ * then by the block size. Lists with default format are always written with
+ * a regular header, and thus lists written before the extension was
+ * introduced are still valid.
+ */
+struct Block_List_Format {
+    //! A document list stored as a bitmap; see `Block_List_Options::bitmap_density`.
+    static constexpr std::int32_t Bitmap = 1;
+    //! Skips and upper bounds stored as 32-bit integers; see `Block_List_Options::fixed_width`.
+    static constexpr std::int32_t Fixed_Width = 2;
+    //! Blocks of varying lengths; see `Block_List_Options::variable_blocks`.
+    static constexpr std::int32_t Variable_Blocks = 4;
+
+    //! Layout flags.
+    std::int32_t flags = 0;
+    //! The position of the codec in `irk::adaptive_codec` used for the list.
+    std::int32_t codec_tag = 0;
+
+    [[nodiscard]] constexpr auto is_default() const -> bool
+    {
+        return flags == 0 && codec_tag == 0;
+    }
+};
+
+//! Options of `Standard_Block_List_Builder` not related to encoding values.
+struct Block_List_Options {
+    //! Minimum density at which a document list is written as a bitmap.
+    /*!
+     * The density is the ratio of the list length to the number of documents
+     * in the collection, which must be passed to the builder with
+     * `Standard_Block_List_Builder::set_document_count`; otherwise, no list
+     * is written as a bitmap. A bitmap takes one bit per document in the
+     * range of IDs the list spans, which beats any gap codec at roughly 1/8
+     * density, and its blocks decode with a few bit operations per document.
+     * Because a list may be dense only in part of that range, a list passing
+     * the threshold is still written as a bitmap only if the bitmap is
+     * smaller than its gap-coded values. Zero disables bitmaps.
+     *
+     * A bitmap list is written as [header][first document][last documents
+     * in blocks][bitmap], where the bitmap is padded to full 64-bit words.
+     * Blocks are still defined by position, so the upper bounds serve as
+     * select samples, and payload lists stay aligned by rank.
+     */
+    double bitmap_density = 0.0;
+
+    //! Whether to store the list header in a fixed-width layout.
+    /*!
+     * By default, the header holds vbyte-encoded skips (relative block
+     * offsets) followed by delta-encoded upper bounds, and both must be
+     * decoded in full when a list is opened. With a fixed-width header, these
+     * are written as arrays of (native-endian, unaligned) 32-bit integers:
+     * the absolute offsets of blocks from the beginning of the list, and the
+     * last values of blocks (only the latter for bitmap lists). Opening such
+     * a list takes constant time, and only the accessed blocks are ever read.
+     */
+    bool fixed_width = false;
+
+    //! Whether to partition document lists into blocks of varying lengths.
+    /*!
+     * Instead of cutting a list into blocks of exactly the block size, the
+     * builder chooses block boundaries minimizing the encoded size plus
+     * `block_overhead` bytes per block, so that blocks of a uniform region are
+     * long, and those of an irregular one are short. The block size becomes
+     * the maximum block length. The end positions of blocks are written after
+     * the header: delta-encoded, or as 32-bit integers in a fixed-width
+     * header, and blocks are then located with a prefix sum rather than by
+     * division.
+     *
+     * Payload lists must be aligned with their document lists, and thus are
+     * never partitioned on their own: their builders must be given the block
+     * ends of the document list with
+     * `Standard_Block_List_Builder::set_partition`.
+     */
+    bool variable_blocks = false;
+
+    //! The cost, in bytes, of each block when partitioning into variable blocks.
+    /*!
+     * It accounts for the header entries of a block, as well as the cost
+     * of skipping to and starting to decode a block.
+     */
+    std::int32_t block_overhead = 12;
+};
+
+//! Fields of a block list header.
+struct Block_List_Header {
+    std::int32_t byte_size = 0;
+    std::int32_t block_size = 0;
+    std::int32_t block_count = 0;
+    Block_List_Format format{};
+};
+
+//! Reads and validates the header of a list, and returns the position following it.
+template<class Codec, bool delta_encoded>
+auto read_block_list_header(irk::index::term_id_t term_id,
+                            irk::memory_view const& memory,
+                            Block_List_Header& header) -> irk::memory_view::iterator
+{
+    auto pos = memory.begin();
+    irk::vbyte_codec<int64_t> vb;
+    pos = vb.decode(pos, &header.byte_size);
+    pos = vb.decode(pos, &header.block_size);
+    if (header.block_size == 0) {
+        pos = vb.decode(pos, &header.format.flags);
+        pos = vb.decode(pos, &header.format.codec_tag);
+        pos = vb.decode(pos, &header.block_size);
+    }
+    pos = vb.decode(pos, &header.block_count);
+    if (header.byte_size != memory.size()) {
+        panic(fmt::format("list size {} does not match memory view size {} for term {}",
+                          header.byte_size,
+                          memory.size(),
+                          term_id));
+    }
+    auto flags = header.format.flags;
+    auto known_flags = Block_List_Format::Bitmap | Block_List_Format::Fixed_Width
+        | Block_List_Format::Variable_Blocks;
+    bool is_bitmap = (flags & Block_List_Format::Bitmap) != 0;
+    if ((flags & ~known_flags) != 0 || (is_bitmap && not delta_encoded)
+        || (is_bitmap && (flags & Block_List_Format::Variable_Blocks) != 0)) {
+        panic(fmt::format("unsupported list flags {} for term {}", flags, term_id));
+    }
+    if constexpr (irk::is_adaptive_codec_v<Codec>) {
+        if (header.format.codec_tag >= Codec::codec_count) {
+            panic(fmt::format(
+                "unknown codec tag {} for term {}", header.format.codec_tag, term_id));
+        }
+    } else if (header.format.codec_tag != 0) {
+        panic(fmt::format("list of term {} requires an adaptive codec (tag {})",
+                          term_id,
+                          header.format.codec_tag));
+    }
+    return pos;
+}
+
+//! Selects `count` set bits of a bitmap list, starting from document `first`.
+template<class Value>
+void decode_bitmap_block(
+    char const* words, Value base, Value first, Value* out, std::int32_t count)
+{
+    auto load_word = [words](std::uint64_t idx) {
+        std::uint64_t word;
+        std::memcpy(&word, words + idx * sizeof(word), sizeof(word));
+        return word;
+    };
+    auto bit = static_cast<std::uint64_t>(first - base);
+    auto word_idx = bit / 64;
+    auto word = load_word(word_idx) & (~std::uint64_t{0} << (bit % 64));
+    for (std::int32_t idx = 0; idx < count;) {
+        while (word == 0) {
+            word = load_word(++word_idx);
+        }
+        auto offset = static_cast<std::uint64_t>(__builtin_ctzll(word));
+        out[idx++] = base + static_cast<Value>(word_idx * 64 + offset);
+        word &= word - 1;
+    }
+}
+
 template<class Value, class Codec, bool delta_encoded>
 class Standard_Block_List {
 public:
@@ -53,43 +289,60 @@ public:
     Standard_Block_List(irk::index::term_id_t term_id, irk::memory_view mem, size_type length)
         : term_id_(term_id), length_(length), memory_(std::move(mem))
     {
-        auto pos = memory_.begin();
+        Block_List_Header header;
+        auto pos = read_block_list_header<codec_type, delta_encoded>(term_id, memory_, header);
+        block_size_ = header.block_size;
+        block_count_ = header.block_count;
+        format_ = header.format;
+        size_type num_blocks = header.block_count;
+        data_ = memory_.data();
         irk::vbyte_codec<int64_t> vb;
-        size_type list_byte_size, num_blocks;
-        pos = vb.decode(pos, &list_byte_size);
-        pos = vb.decode(pos, &block_size_);
-        pos = vb.decode(pos, &num_blocks);
-        if (list_byte_size != memory_.size()) {
-            panic(fmt::format("list size {} does not match memory view size {} for term {}",
-                              list_byte_size,
-                              memory_.size(),
-                              term_id));
+        if (delta_encoded && is_fixed_width() && sizeof(value_type) != sizeof(std::int32_t)) {
+            panic(fmt::format("fixed-width list of term {} requires 32-bit values", term_id));
         }
-        decoded_blocks_.resize(num_blocks);
-
-        std::vector<size_type> skips(num_blocks);
-        pos = vb.decode(pos, &skips[0], num_blocks);
-
-        [[maybe_unused]] std::vector<value_type> last_documents;
 
         if constexpr (delta_encoded) {
-            last_documents.resize(num_blocks);
-            pos = codec_.delta_decode(pos, &last_documents[0], num_blocks);
-            upper_bounds_.reserve(num_blocks);
+            if (is_bitmap()) {
+                pos = vb.decode(pos, &bitmap_base_);
+                if (is_fixed_width()) {
+                    fixed_upper_bounds_ = pos;
+                    pos += num_blocks * sizeof(std::int32_t);
+                } else {
+                    upper_bounds_.resize(num_blocks);
+                    pos = codec_.delta_decode(pos, &upper_bounds_[0], num_blocks);
+                }
+                bitmap_ = memory_.range(std::distance(memory_.begin(), pos),
+                                        std::distance(pos, std::end(memory_)));
+                return;
+            }
         }
 
-        blocks_.reserve(num_blocks);
-        for (size_type block : iter::range(num_blocks - 1)) {
-            std::advance(pos, skips[block]);
-            blocks_.push_back(irk::make_memory_view(pos, skips[block + 1]));
+        if (is_fixed_width()) {
+            if (has_variable_blocks()) {
+                fixed_block_ends_ = pos;
+                pos += num_blocks * sizeof(size_type);
+            }
+            fixed_offsets_ = pos;
             if constexpr (delta_encoded) {
-                upper_bounds_.push_back(last_documents[block]);
+                fixed_upper_bounds_ = pos + num_blocks * sizeof(std::int32_t);
             }
+            return;
+        }
+
+        if (has_variable_blocks()) {
+            block_ends_.resize(num_blocks);
+            pos = vb.delta_decode(pos, block_ends_.data(), num_blocks, 0);
         }
-        std::advance(pos, skips.back());
-        blocks_.push_back(irk::make_memory_view(pos, std::distance(pos, std::end(memory_))));
+        block_offsets_.resize(num_blocks);
+        pos = vb.decode(pos, block_offsets_.data(), num_blocks);
         if constexpr (delta_encoded) {
-            upper_bounds_.push_back(last_documents.back());
+            upper_bounds_.resize(num_blocks);
+            pos = codec_.delta_decode(pos, upper_bounds_.data(), num_blocks);
+        }
+        auto offset = static_cast<size_type>(std::distance(memory_.begin(), pos));
+        for (auto& block_offset : block_offsets_) {
+            offset += block_offset;
+            block_offset = offset;
         }
     }
     constexpr Standard_Block_List(const Standard_Block_List&)     = default;
@@ -100,7 +353,7 @@ public:
     [[nodiscard]] constexpr auto size() const -> size_type { return length_; }
     [[nodiscard]] constexpr auto block_count() const noexcept -> size_type
     {
-        return (size() + block_size_ - 1) / block_size_;
+        return block_count_;
     }
 
     [[nodiscard]] constexpr auto begin() const noexcept -> iterator
@@ -109,7 +362,10 @@ public:
     }
     [[nodiscard]] constexpr auto end() const noexcept -> iterator
     {
-        return iterator{iterator::end(length_, block_size_, blocks_.size()), *this};
+        if (has_variable_blocks()) {
+            return iterator{{block_count_, 0}, *this};
+        }
+        return iterator{iterator::end(length_, block_size_, block_count()), *this};
     }
     [[nodiscard]] constexpr auto lookup(value_type id) const -> iterator
     {
@@ -118,19 +374,40 @@ public:
     }
     [[nodiscard]] constexpr auto term_id() const -> auto const& { return term_id_; }
 
+    //! Returns the block size, which is the maximum block length for variable blocks.
     [[nodiscard]] constexpr auto block_size() const -> size_type { return block_size_; }
     [[nodiscard]] constexpr auto block_size(size_type n) const noexcept -> size_type
     {
-        size_type block_count = blocks_.size();
+        if (has_variable_blocks()) {
+            auto block_ends = this->block_ends();
+            return n > 0 ? block_ends[n] - block_ends[n - 1] : block_ends[0];
+        }
+        size_type block_count = this->block_count();
         return n < block_count - 1 ? block_size_ : length_ - ((block_count - 1) * block_size_);
     }
 
+    //! Returns the end positions of blocks, or an empty span if all blocks are full.
+    [[nodiscard]] constexpr auto block_ends() const -> Unaligned_Span<size_type>
+    {
+        if (fixed_block_ends_ != nullptr) {
+            return {fixed_block_ends_, block_count_};
+        }
+        return gsl::make_span(block_ends_);
+    }
+
     [[nodiscard]] constexpr auto block(size_type n) const noexcept -> gsl::span<value_type const>
     {
+        if (decoded_blocks_.empty()) {
+            decoded_blocks_.resize(block_count());
+        }
         auto& decoded_block = decoded_blocks_[n];
         if (decoded_block.empty()) {
             if constexpr (delta_encoded) {  // NOLINT
-                decode_delta(n, decoded_block, block_size(n));
+                if (is_bitmap()) {
+                    decode_bitmap(n, decoded_block, block_size(n));
+                } else {
+                    decode_delta(n, decoded_block, block_size(n));
+                }
             } else {
                 decode_no_delta(n, decoded_block, block_size(n));
             }
@@ -138,8 +415,63 @@ public:
         return gsl::make_span(decoded_blocks_[n]);
     }
 
-    [[nodiscard]] constexpr auto upper_bounds() const { return upper_bounds_; }
+    //! Returns the last values of blocks, read in place from a fixed-width header.
+    [[nodiscard]] constexpr auto upper_bounds() const -> Unaligned_Span<value_type>
+    {
+        if (fixed_upper_bounds_ != nullptr) {
+            return {fixed_upper_bounds_, block_count()};
+        }
+        return gsl::make_span(upper_bounds_);
+    }
     [[nodiscard]] auto memory() const -> irk::memory_view { return memory_; };
+    [[nodiscard]] constexpr auto format() const -> Block_List_Format const& { return format_; }
+
+    //! Returns the number of bytes preceding the encoded values: the header,
+    //! block ends, skips, and upper bounds.
+    [[nodiscard]] auto header_size() const -> std::ptrdiff_t
+    {
+        if (is_bitmap()) {
+            return std::distance(memory_.begin(), bitmap_.begin());
+        }
+        if (block_count_ == 0) {
+            return memory_.size();
+        }
+        return std::distance(data_, block_data(0));
+    }
+
+    [[nodiscard]] constexpr auto is_bitmap() const -> bool
+    {
+        return (format_.flags & Block_List_Format::Bitmap) != 0;
+    }
+
+    [[nodiscard]] constexpr auto is_fixed_width() const -> bool
+    {
+        return (format_.flags & Block_List_Format::Fixed_Width) != 0;
+    }
+
+    [[nodiscard]] constexpr auto has_variable_blocks() const -> bool
+    {
+        return (format_.flags & Block_List_Format::Variable_Blocks) != 0;
+    }
+
+    //! Bitmap of a bitmap list, in which bit `i` stands for document `bitmap_base() + i`.
+    /*!
+     * The memory is padded to full words, so it can be read, and intersected
+     * or united with other bitmaps, 64 bits at a time.
+     */
+    [[nodiscard]] auto bitmap() const -> irk::memory_view { return bitmap_; }
+    [[nodiscard]] constexpr auto bitmap_base() const -> value_type { return bitmap_base_; }
+
+    //! Tests membership in constant time. Must only be called for bitmap lists.
+    [[nodiscard]] auto contains(value_type id) const -> bool
+    {
+        auto upper_bounds = this->upper_bounds();
+        if (id < bitmap_base_ || id > upper_bounds[upper_bounds.size() - 1]) {
+            return false;
+        }
+        auto bit = static_cast<std::uint64_t>(id - bitmap_base_);
+        return ((static_cast<unsigned char>(bitmap_[bit / 8]) >> (bit % 8)) & 1u) != 0;
+    }
 
     [[nodiscard]] constexpr static bool is_delta_encoded() { return delta_encoded; }
 
@@ -148,22 +480,62 @@ private:
     decode_no_delta(size_type block, std::vector<value_type>& buffer, size_type count) const
     {
         buffer.resize(block_size_);
-        codec_.decode(std::begin(blocks_[block]), std::begin(buffer), count);
+        with_codec([&](auto const& codec) {
+            codec.decode(block_data(block), buffer.data(), count);
+        });
     }
 
     void decode_delta(size_type block, std::vector<value_type>& buffer, int32_t count) const
     {
-        auto preceding = block > 0 ? upper_bounds_[block - 1] : 0;
+        auto preceding = block > 0 ? upper_bounds()[block - 1] : 0;
         buffer.resize(count);
-        codec_.delta_decode(std::begin(blocks_[block]), std::begin(buffer), count, preceding);
+        with_codec([&](auto const& codec) {
+            codec.delta_decode(block_data(block), buffer.data(), count, preceding);
+        });
+    }
+
+    void decode_bitmap(size_type block, std::vector<value_type>& buffer, size_type count) const
+    {
+        buffer.resize(count);
+        auto first = block > 0 ? upper_bounds()[block - 1] + 1 : bitmap_base_;
+        decode_bitmap_block(bitmap_.data(), bitmap_base_, first, buffer.data(), count);
+    }
+
+    [[nodiscard]] auto block_data(size_type block) const -> char const*
+    {
+        if (fixed_offsets_ != nullptr) {
+            std::int32_t offset;
+            std::memcpy(&offset, fixed_offsets_ + block * sizeof(offset), sizeof(offset));
+            return data_ + offset;
+        }
+        return data_ + block_offsets_[block];
+    }
+
+    template<class Fn>
+    void with_codec(Fn&& fn) const
+    {
+        if constexpr (irk::is_adaptive_codec_v<codec_type>) {
+            codec_.visit(format_.codec_tag, fn);
+        } else {
+            fn(codec_);
+        }
     }
 
     irk::index::term_id_t term_id_{};
     size_type length_{0};
     size_type block_size_{1};
+    size_type block_count_{0};
+    Block_List_Format format_{};
     irk::memory_view memory_{};
+    irk::memory_view bitmap_{};
+    value_type bitmap_base_{};
     codec_type codec_{};
-    std::vector<irk::memory_view> blocks_{};
+    char const* data_ = nullptr;
+    char const* fixed_offsets_ = nullptr;
+    char const* fixed_upper_bounds_ = nullptr;
+    char const* fixed_block_ends_ = nullptr;
+    std::vector<size_type> block_ends_{};
+    std::vector<size_type> block_offsets_{};
     std::vector<value_type> upper_bounds_{};
     mutable std::vector<std::vector<value_type>> decoded_blocks_{};
 };
@@ -184,6 +556,14 @@ public:
 
     explicit constexpr Standard_Block_List_Builder(size_type block_size) : block_size_{block_size}
     {}
+    constexpr Standard_Block_List_Builder(size_type block_size,
+                                          codec_type codec,
+                                          Block_List_Options options = {})
+        : block_size_{block_size}, value_codec_{std::move(codec)}, options_{options}
+    {}
+    constexpr Standard_Block_List_Builder(size_type block_size, Block_List_Options options)
+        : block_size_{block_size}, options_{options}
+    {}
     constexpr Standard_Block_List_Builder(const Standard_Block_List_Builder&) = default;
     constexpr Standard_Block_List_Builder(Standard_Block_List_Builder&&) noexcept = default;
     constexpr Standard_Block_List_Builder& operator=(const Standard_Block_List_Builder&) = default;
@@ -193,42 +573,145 @@ public:
 
     constexpr void add(value_type id) { values_.push_back(id); }
 
+    //! Fixes the partition of the list into blocks, and returns the end positions of blocks.
+    /*!
+     * Must be called after all values are added. A document list written
+     * with variable blocks is partitioned as described in
+     * `Block_List_Options::variable_blocks`, and the returned block ends must
+     * be passed to `set_partition` of the builders of its payload lists.
+     */
+    auto partition() -> std::vector<size_type> const&
+    {
+        if (block_ends_.empty()) {
+            block_ends_ = compute_block_ends();
+        }
+        return block_ends_;
+    }
+
+    //! Makes the list use the given block ends, e.g., those of its document list.
+    void set_partition(std::vector<size_type> block_ends) { block_ends_ = std::move(block_ends); }
+
+    //! Sets the number of documents in the collection.
+    /*!
+     * The density of the list is measured against it when deciding whether
+     * to write a bitmap; see `Block_List_Options::bitmap_density`.
+     */
+    void set_document_count(std::int64_t document_count) { document_count_ = document_count; }
+
+    //! Makes the list a bitmap, or not, regardless of its density.
+    /*!
+     * Useful for keeping the representation of an existing list.
+     */
+    void set_bitmap(bool bitmap) { bitmap_ = bitmap; }
+
+    //! Writes the list to the output stream and returns the number of bytes written.
+    /*!
+     * If the value codec is an `irk::adaptive_codec`, the list is encoded with
+     * each of its codecs, and the one selected by `irk::adaptive_codec::select`
+     * is written along with its tag in the header.
+     */
     auto write(std::ostream& out) const -> std::streamsize
     {
+        if constexpr (delta_encoded) {  // NOLINT
+            if (use_bitmap()) {
+                return write_bitmap(out);
+            }
+        }
+        Block_List_Format format{};
+        if (options_.fixed_width) {
+            format.flags |= Block_List_Format::Fixed_Width;
+        }
+        if (options_.variable_blocks) {
+            format.flags |= Block_List_Format::Variable_Blocks;
+        }
+        auto block_ends = block_ends_.empty() ? compute_block_ends() : block_ends_;
+        validate_block_ends(block_ends);
+        if constexpr (irk::is_adaptive_codec_v<codec_type>) {
+            std::vector<Encoded_Blocks> candidates;
+            std::vector<std::ptrdiff_t> sizes;
+            value_codec_.for_each_codec([&](auto /* tag */, auto const& codec) {
+                candidates.push_back(encode_blocks(codec, block_ends));
+                sizes.push_back(candidates.back().size());
+            });
+            format.codec_tag = value_codec_.select(sizes);
+            return write(out, candidates[format.codec_tag], block_ends, format);
+        } else {
+            return write(out, encode_blocks(value_codec_, block_ends), block_ends, format);
+        }
+    }
+
+    [[nodiscard]] constexpr auto size() const -> size_type { return values_.size(); }
+    [[nodiscard]] constexpr auto values() const -> auto const& { return values_; }
+
+private:
+    struct Encoded_Blocks {
         std::vector<int32_t> absolute_skips;
         std::vector<value_type> last_values;
-        std::vector<char> encoded_blocks;
+        std::vector<char> data;
+
+        [[nodiscard]] auto size() const -> std::ptrdiff_t { return data.size(); }
+    };
+
+    template<class BlockCodec>
+    [[nodiscard]] auto encode_blocks(BlockCodec const& codec,
+                                     std::vector<size_type> const& block_ends) const
+        -> Encoded_Blocks
+    {
+        Encoded_Blocks encoded;
 
         gsl::index pos = 0;
         [[maybe_unused]] value_type previous_doc{0};
-        const int32_t num_blocks = (values_.size() + block_size_ - 1) / block_size_;
+        const int32_t num_blocks = block_ends.size();
         for (gsl::index block = 0; block < num_blocks; ++block) {
-            absolute_skips.push_back(pos);
-            const gsl::index begin_idx = block_size_ * block;
-            const gsl::index end_idx = std::min(begin_idx + block_size_,
-                                                gsl::index(values_.size()));
+            encoded.absolute_skips.push_back(pos);
+            const gsl::index begin_idx = block > 0 ? block_ends[block - 1] : 0;
+            const gsl::index end_idx = block_ends[block];
 
             const value_type* begin = values_.data() + begin_idx;
             const value_type* end = values_.data() + end_idx;
 
-            encoded_blocks.resize(pos + value_codec_.max_encoded_size(end_idx - begin_idx));
+            encoded.data.resize(pos + codec.max_encoded_size(end_idx - begin_idx));
             if constexpr (delta_encoded) {  // NOLINT
-                last_values.push_back(values_[end_idx - 1]);
-                pos += value_codec_.delta_encode(begin, end, &encoded_blocks[pos], previous_doc);
-                previous_doc = last_values.back();
+                encoded.last_values.push_back(values_[end_idx - 1]);
+                pos += codec.delta_encode(begin, end, &encoded.data[pos], previous_doc);
+                previous_doc = encoded.last_values.back();
             } else {
-                pos += value_codec_.encode(begin, end, &encoded_blocks[pos]);
+                pos += codec.encode(begin, end, &encoded.data[pos]);
             }
         }
+        encoded.data.resize(pos);
+        return encoded;
+    }
 
-        const std::vector<char> encoded_header = irk::encode(int_codec_, {block_size_, num_blocks});
-        const std::vector<char> encoded_skips = irk::delta_encode(int_codec_, absolute_skips);
+    auto write(std::ostream& out,
+               Encoded_Blocks const& blocks,
+               std::vector<size_type> const& block_ends,
+               Block_List_Format format) const -> std::streamsize
+    {
+        const int32_t num_blocks = blocks.absolute_skips.size();
+        std::vector<char> encoded_header =
+            format.is_default()
+                ? irk::encode(int_codec_, {block_size_, num_blocks})
+                : irk::encode(int_codec_,
+                              {0, format.flags, format.codec_tag, block_size_, num_blocks});
+        bool variable_blocks = (format.flags & Block_List_Format::Variable_Blocks) != 0;
+        if ((format.flags & Block_List_Format::Fixed_Width) != 0) {
+            return write_fixed_width(
+                out, blocks, variable_blocks ? block_ends : std::vector<size_type>{}, encoded_header);
+        }
+        if (variable_blocks) {
+            auto encoded_block_ends = irk::delta_encode(int_codec_, block_ends);
+            encoded_header.insert(
+                encoded_header.end(), encoded_block_ends.begin(), encoded_block_ends.end());
+        }
+        const std::vector<char> encoded_skips = irk::delta_encode(int_codec_,
+                                                                  blocks.absolute_skips);
 
-        int list_byte_size = encoded_header.size() + encoded_skips.size() + pos;
+        int list_byte_size = encoded_header.size() + encoded_skips.size() + blocks.size();
         std::vector<char> encoded_last_vals;
 
         if constexpr (delta_encoded) {  // NOLINT
-            encoded_last_vals = irk::delta_encode(value_codec_, last_values);  // NOLINT
+            encoded_last_vals = irk::delta_encode(value_codec_, blocks.last_values);  // NOLINT
             list_byte_size += encoded_last_vals.size();
         }  // NOLINT
         list_byte_size = expanded_size(list_byte_size);  // NOLINT
@@ -240,15 +723,224 @@ public:
         if constexpr (delta_encoded) {  // NOLINT
             out.write(&encoded_last_vals[0], encoded_last_vals.size());  // NOLINT
         }
-        out.write(&encoded_blocks[0], pos);  // NOLINT
+        out.write(blocks.data.data(), blocks.size());  // NOLINT
 
         return list_byte_size;
     }
 
-    [[nodiscard]] constexpr auto size() const -> size_type { return values_.size(); }
-    [[nodiscard]] constexpr auto values() const -> auto const& { return values_; }
+    //! Writes [size][header][block ends][block offsets][last values][blocks] with 32-bit arrays.
+    /*!
+     * Block ends are written only if not empty, i.e., for variable blocks.
+     */
+    auto write_fixed_width(std::ostream& out,
+                           Encoded_Blocks const& blocks,
+                           std::vector<size_type> const& block_ends,
+                           std::vector<char> const& encoded_header) const -> std::streamsize
+    {
+        const std::size_t num_blocks = blocks.absolute_skips.size();
+        std::vector<std::int32_t> fixed_width(block_ends.begin(), block_ends.end());
+        const std::size_t offsets_begin = fixed_width.size();
+        fixed_width.resize(offsets_begin + num_blocks);
+        if constexpr (delta_encoded) {  // NOLINT
+            fixed_width.resize(offsets_begin + 2 * num_blocks);
+        }
+        int list_byte_size = expanded_size(
+            encoded_header.size() + fixed_width.size() * sizeof(std::int32_t) + blocks.size());
+        auto encoded_list_byte_size = irk::encode(int_codec_, {list_byte_size});
+        std::int32_t data_offset = list_byte_size - blocks.size();
+        for (std::size_t block = 0; block < num_blocks; ++block) {
+            fixed_width[offsets_begin + block] = data_offset + blocks.absolute_skips[block];
+            if constexpr (delta_encoded) {  // NOLINT
+                fixed_width[offsets_begin + num_blocks + block] = static_cast<std::int32_t>(
+                    blocks.last_values[block]);
+            }
+        }
+        out.write(&encoded_list_byte_size[0], encoded_list_byte_size.size());
+        out.write(&encoded_header[0], encoded_header.size());
+        out.write(reinterpret_cast<char const*>(fixed_width.data()),
+                  fixed_width.size() * sizeof(std::int32_t));
+        out.write(blocks.data.data(), blocks.size());
+        return list_byte_size;
+    }
+
+    [[nodiscard]] auto uniform_block_ends() const -> std::vector<size_type>
+    {
+        std::vector<size_type> block_ends;
+        for (size_type end = block_size_; end < size(); end += block_size_) {
+            block_ends.push_back(end);
+        }
+        if (size() > 0) {
+            block_ends.push_back(size());
+        }
+        return block_ends;
+    }
+
+    [[nodiscard]] auto compute_block_ends() const -> std::vector<size_type>
+    {
+        if constexpr (delta_encoded) {  // NOLINT
+            if (options_.variable_blocks && not use_bitmap()) {
+                return optimal_block_ends();
+            }
+        } else {
+            if (options_.variable_blocks) {
+                panic("payload list with variable blocks requires the partition of its "
+                      "document list");
+            }
+        }
+        return uniform_block_ends();
+    }
+
+    void validate_block_ends(std::vector<size_type> const& block_ends) const
+    {
+        size_type begin = 0;
+        for (auto end : block_ends) {
+            if (end <= begin || end - begin > block_size_) {
+                panic(fmt::format("invalid block [{}, {}) for block size {}",
+                                  begin,
+                                  end,
+                                  block_size_));
+            }
+            begin = end;
+        }
+        if (begin != size()) {
+            panic(fmt::format("blocks end at {} but the list has {} values", begin, size()));
+        }
+    }
+
+    //! Returns the encoded size of the values in [first, last) as a single block.
+    /*!
+     * For an adaptive codec, the smallest size among its codecs is taken,
+     * so that the partition does not depend on the codec selected later.
+     */
+    [[nodiscard]] auto
+    encoded_block_size(gsl::index first, gsl::index last, std::vector<char>& buffer) const
+        -> std::ptrdiff_t
+    {
+        value_type preceding = first > 0 ? values_[first - 1] : value_type{0};
+        auto encode = [&](auto const& codec) -> std::ptrdiff_t {
+            return codec.delta_encode(
+                values_.data() + first, values_.data() + last, buffer.data(), preceding);
+        };
+        if constexpr (irk::is_adaptive_codec_v<codec_type>) {
+            std::ptrdiff_t min_size = std::numeric_limits<std::ptrdiff_t>::max();
+            value_codec_.for_each_codec([&](auto /* tag */, auto const& codec) {
+                min_size = std::min(min_size, encode(codec));
+            });
+            return min_size;
+        } else {
+            return encode(value_codec_);
+        }
+    }
+
+    //! Partitions the list into blocks of variable lengths.
+    /*!
+     * Blocks start at multiples of an eighth of the block size, and their
+     * lengths are that eighth times a power of two (up to the block size),
+     * except for the last block, which is cut at the end of the list.
+     * Among such partitions, the one minimizing the encoded size plus the
+     * block overhead is found with dynamic programming, in which each
+     * candidate block is encoded with the codec. This takes about as much
+     * time as encoding the list 15 times over.
+     */
+    [[nodiscard]] auto optimal_block_ends() const -> std::vector<size_type>
+    {
+        const gsl::index length = values_.size();
+        const gsl::index unit = std::max(size_type{1}, block_size_ / 8);
+        std::vector<gsl::index> unit_counts;
+        for (gsl::index count = 1; count * unit <= block_size_; count *= 2) {
+            unit_counts.push_back(count);
+        }
+        const gsl::index units = (length + unit - 1) / unit;
+
+        // cost[u]: minimum cost of the prefix of `u` units; last[u]: where its last block starts.
+        std::vector<std::int64_t> cost(units + 1, std::numeric_limits<std::int64_t>::max());
+        std::vector<gsl::index> last(units + 1, 0);
+        std::vector<char> buffer(value_codec_.max_encoded_size(block_size_));
+        cost[0] = 0;
+        for (gsl::index first = 0; first < units; ++first) {
+            for (auto count : unit_counts) {
+                gsl::index next = std::min(first + count, units);
+                auto block_cost = options_.block_overhead
+                    + encoded_block_size(
+                        first * unit, std::min(next * unit, length), buffer);
+                if (cost[first] + block_cost < cost[next]) {
+                    cost[next] = cost[first] + block_cost;
+                    last[next] = first;
+                }
+                if (next == units) {
+                    break;
+                }
+            }
+        }
+
+        std::vector<size_type> block_ends;
+        for (gsl::index end = units; end > 0; end = last[end]) {
+            block_ends.push_back(std::min(end * unit, length));
+        }
+        std::reverse(block_ends.begin(), block_ends.end());
+        return block_ends;
+    }
+
+    [[nodiscard]] auto use_bitmap() const -> bool
+    {
+        if (bitmap_.has_value()) {
+            return *bitmap_ && not values_.empty();
+        }
+        if (options_.bitmap_density <= 0.0 || document_count_ <= 0 || values_.empty()) {
+            return false;
+        }
+        if (static_cast<double>(values_.size())
+            < options_.bitmap_density * static_cast<double>(document_count_)) {
+            return false;
+        }
+        auto bits = static_cast<std::int64_t>(values_.back() - values_.front()) + 1;
+        std::ptrdiff_t bitmap_size = ((bits + 63) / 64) * 8;
+        std::vector<char> buffer(value_codec_.max_encoded_size(values_.size()));
+        return bitmap_size < encoded_block_size(0, values_.size(), buffer);
+    }
+
+    auto write_bitmap(std::ostream& out) const -> std::streamsize
+    {
+        const int32_t num_blocks = (values_.size() + block_size_ - 1) / block_size_;
+        const value_type base = values_.front();
+        std::vector<value_type> last_values;
+        for (int32_t block = 0; block < num_blocks; ++block) {
+            auto end_idx = std::min<std::size_t>((block + 1) * block_size_, values_.size());
+            last_values.push_back(values_[end_idx - 1]);
+        }
+
+        const std::size_t bits = values_.back() - base + 1;
+        std::vector<char> bitmap(((bits + 63) / 64) * 8, 0);
+        for (auto value : values_) {
+            auto bit = static_cast<std::size_t>(value - base);
+            bitmap[bit / 8] |= static_cast<char>(1u << (bit % 8));
+        }
+
+        std::int32_t flags = Block_List_Format::Bitmap;
+        std::vector<char> encoded_last_vals;
+        if (options_.fixed_width) {
+            flags |= Block_List_Format::Fixed_Width;
+            encoded_last_vals.resize(last_values.size() * sizeof(std::int32_t));
+            for (std::size_t block = 0; block < last_values.size(); ++block) {
+                auto value = static_cast<std::int32_t>(last_values[block]);
+                std::memcpy(&encoded_last_vals[block * sizeof(value)], &value, sizeof(value));
+            }
+        } else {
+            encoded_last_vals = irk::delta_encode(value_codec_, last_values);
+        }
+        const std::vector<char> encoded_header = irk::encode(
+            int_codec_, {0, flags, 0, block_size_, num_blocks, static_cast<int32_t>(base)});
+        int list_byte_size = expanded_size(
+            encoded_header.size() + encoded_last_vals.size() + bitmap.size());
+
+        auto encoded_list_byte_size = irk::encode(int_codec_, {list_byte_size});
+        out.write(&encoded_list_byte_size[0], encoded_list_byte_size.size());
+        out.write(&encoded_header[0], encoded_header.size());
+        out.write(&encoded_last_vals[0], encoded_last_vals.size());
+        out.write(bitmap.data(), bitmap.size());
+        return list_byte_size;
+    }
 
-private:
     [[nodiscard]] constexpr auto expanded_size(int list_byte_size) const -> size_type
     {
         unsigned int extra_bytes = 1;
@@ -260,8 +952,12 @@ private:
     }
 
     size_type block_size_;
-    codec_type value_codec_;
+    codec_type value_codec_{};
+    Block_List_Options options_{};
+    std::int64_t document_count_ = 0;
+    std::optional<bool> bitmap_{};
     std::vector<value_type> values_;
+    std::vector<size_type> block_ends_;
     irk::vbyte_codec<int32_t> int_codec_;
 };
 
@@ -98,7 +98,16 @@ public:
         return gsl::make_span<value_type const>(begin, len);
     }
 
-    [[nodiscard]] constexpr auto upper_bounds() const { return bounds_; }
+    [[nodiscard]] constexpr auto upper_bounds() const -> std::vector<value_type> const&
+    {
+        return bounds_;
+    }
+
+    //! Always empty, as all blocks but the last are full.
+    [[nodiscard]] constexpr auto block_ends() const -> gsl::span<size_type const>
+    {
+        return {};
+    }
 
 private:
     [[nodiscard]] constexpr auto set_up_bounds() {
@@ -27,6 +27,9 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <type_traits>
 #include <vector>
 
 #include <boost/filesystem.hpp>
@@ -53,6 +56,31 @@ struct reinterpret_cast_fn {
     }
 };
 
+//! Describes how a memory view can access the data of a memory source.
+enum class memory_access {
+    //! Data may not be in memory yet, and must be requested from the source.
+    indirect,
+    //! Data are contiguous in memory and owned by the source.
+    shared,
+    //! Data are contiguous in memory and owned by someone else.
+    borrowed
+};
+
+//! Resolves the access of a memory source.
+/*!
+ * A source declares it with a `static constexpr memory_access access`
+ * member; sources that do not are accessed indirectly.
+ */
+template<class Source, class = void>
+struct memory_source_access
+    : std::integral_constant<memory_access, memory_access::indirect> {
+};
+
+template<class Source>
+struct memory_source_access<Source, std::void_t<decltype(Source::access)>>
+    : std::integral_constant<memory_access, Source::access> {
+};
+
 //! A base class for all types of memory views.
 /*!
  * A memory view is an abstraction for accessing any memory area, be it in
@@ -61,6 +89,13 @@ struct reinterpret_cast_fn {
  * memory access details. These types are hidden with type erasure: only
  * the constructor is a template, and `memory_view` type can be used
  * polymorphically.
+ *
+ * Views of contiguous sources (see \ref memory_access) keep their data
+ * pointer and size, so that data access and ranges do not go through
+ * the type-erased source. Borrowed memory is not even referenced by the
+ * view: its ranges are merely a pointer and a size. Only indirect sources,
+ * such as files read from disk, pay for a virtual call and a heap-allocated
+ * range.
  */
 class memory_view {
 public:
@@ -76,8 +111,17 @@ public:
      */
     template<class source_type>
     explicit memory_view(source_type source)
-        : self_(std::make_shared<model<source_type>>(source))
-    {}
+        : size_(source.size())
+    {
+        constexpr auto access = memory_source_access<source_type>::value;
+        contiguous_ = access != memory_access::indirect;
+        if constexpr (access != memory_access::indirect) {
+            data_ = reinterpret_cast<const char*>(source.data());
+        }
+        if constexpr (access != memory_access::borrowed) {
+            self_ = std::make_shared<model<source_type>>(std::move(source));
+        }
+    }
 
     memory_view() = default;
     memory_view(const memory_view&) = default;
@@ -95,18 +139,34 @@ public:
      * sequentially, use \ref begin() and \ref end(), or \ref operator[]
      * instead.
      */
-    const char* data() const { return self_->data(); }
+    const char* data() const
+    {
+        return contiguous_ ? data_ : self_->data();
+    }
 
     //! Returns the number of characters in the memory area.
-    std::ptrdiff_t size() const { return self_->size(); }
+    std::ptrdiff_t size() const { return size_; }
 
     //! Returns a character at offset `n` in the memory.
-    const char& operator[](std::ptrdiff_t n) const { return (*self_)[n]; }
+    const char& operator[](std::ptrdiff_t n) const
+    {
+        return contiguous_ ? data_[n] : (*self_)[n];
+    }
 
     //! Returns a new memory view defined by the given range.
+    /*!
+     * A range of contiguous memory shares the source of this view;
+     * otherwise, the source is asked for a new one.
+     */
     irk::memory_view range(std::ptrdiff_t first, std::ptrdiff_t size) const
     {
-        return {self_->range(first, size)};
+        if (contiguous_) {
+            memory_view view(*this);
+            view.data_ += first;
+            view.size_ = size;
+            return view;
+        }
+        return self_->range(first, size);
     }
 
     //! Returns a new memory view defined by the given slice.
@@ -184,7 +244,10 @@ public:
     };
 
 private:
-    std::shared_ptr<concept> self_;
+    std::shared_ptr<concept> self_{};
+    const char* data_ = nullptr;
+    std::ptrdiff_t size_ = 0;
+    bool contiguous_ = true;
 };
 
 inline std::ostream& operator<<(std::ostream& out, const memory_view& mv)
@@ -200,6 +263,7 @@ public:
     using char_type = CharT;
     using pointer = char_type*;
     using reference = char_type&;
+    static constexpr memory_access access = memory_access::borrowed;
     span_memory_source() = default;
     explicit span_memory_source(gsl::span<const char_type> memory_span)
         : span_(memory_span){};
@@ -222,6 +286,7 @@ public:
     using char_type = CharT;
     using pointer = char_type*;
     using reference = char_type&;
+    static constexpr memory_access access = memory_access::borrowed;
     pointer_memory_source() = default;
     pointer_memory_source(const pointer_memory_source&) = default;
     pointer_memory_source(pointer_memory_source&&) noexcept = default;
@@ -244,6 +309,41 @@ private:
     std::ptrdiff_t size_ = 0;
 };
 
+//! A memory source sharing ownership of a vector.
+/*!
+ * Useful when a memory view must outlive the scope in which its data was
+ * produced; all ranges keep the vector alive.
+ */
+class shared_memory_source {
+public:
+    using char_type = char;
+    static constexpr memory_access access = memory_access::shared;
+    shared_memory_source() = default;
+    explicit shared_memory_source(std::shared_ptr<const std::vector<char>> data)
+        : data_(std::move(data)), size_(data_->size())
+    {}
+    shared_memory_source(std::shared_ptr<const std::vector<char>> data,
+                         std::ptrdiff_t offset,
+                         std::ptrdiff_t size)
+        : data_(std::move(data)), offset_(offset), size_(size)
+    {}
+    const char* data() const
+    {
+        return data_ != nullptr ? data_->data() + offset_ : nullptr;
+    }
+    std::ptrdiff_t size() const { return size_; }
+    const char& operator[](std::ptrdiff_t n) const { return data()[n]; }
+    shared_memory_source range(std::ptrdiff_t first, std::ptrdiff_t size) const
+    {
+        return shared_memory_source(data_, offset_ + first, size);
+    }
+
+private:
+    std::shared_ptr<const std::vector<char>> data_;
+    std::ptrdiff_t offset_ = 0;
+    std::ptrdiff_t size_ = 0;
+};
+
 inline memory_view make_memory_view(const std::vector<char>& mem)
 {
     return memory_view(pointer_memory_source(mem.data(), mem.size()));
@@ -266,6 +366,7 @@ public:
     using char_type = CharT;
     using pointer = char_type*;
     using reference = char_type&;
+    static constexpr memory_access access = memory_access::borrowed;
     mapped_file_memory_source() = default;
     explicit mapped_file_memory_source(
         const boost::iostreams::mapped_file_source& file)
@@ -0,0 +1,432 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <fmt/format.h>
+#include <unistd.h>
+#ifdef IRKIT_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include <irkit/block_cache.hpp>
+
+namespace irk {
+
+namespace detail::prefetch {
+
+    //! A block to read into the cache of its file.
+    struct block_request {
+        std::shared_ptr<const cached_file> file;
+        std::uint64_t block;
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::shared_ptr<std::vector<char>> buffer;
+
+        block_request(std::shared_ptr<const cached_file> file, std::uint64_t block)
+            : file(std::move(file)), block(block)
+        {
+            std::tie(offset, size) = this->file->block_extent(block);
+            buffer = std::make_shared<std::vector<char>>(size);
+        }
+
+        //! Inserts the block once `bytes_read` bytes have been read into it.
+        void complete(std::int64_t bytes_read) const
+        {
+            // Failed reads are ignored: the block is read again when used,
+            // which reports the error.
+            if (bytes_read == static_cast<std::int64_t>(size)) {
+                file->cache().insert(file->id(), block, buffer);
+            }
+        }
+    };
+
+    //! Tracks the number of reads in flight.
+    class in_flight_counter {
+    public:
+        void add(std::size_t limit)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&]() { return count_ < limit; });
+            ++count_;
+        }
+        void remove()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --count_;
+            }
+            changed_.notify_all();
+        }
+        void wait_for_all()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&]() { return count_ == 0; });
+        }
+
+    private:
+        std::mutex mutex_{};
+        std::condition_variable changed_{};
+        std::size_t count_ = 0;
+    };
+
+    //! Reads blocks with `pread` on a pool of threads.
+    class pread_pool {
+    public:
+        pread_pool(std::size_t thread_count, std::function<void()> on_complete)
+            : on_complete_(std::move(on_complete))
+        {
+            for (std::size_t idx = 0; idx < thread_count; ++idx) {
+                threads_.emplace_back([this]() { work(); });
+            }
+        }
+        pread_pool(pread_pool const&) = delete;
+        pread_pool(pread_pool&&) = delete;
+        pread_pool& operator=(pread_pool const&) = delete;
+        pread_pool& operator=(pread_pool&&) = delete;
+        ~pread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopped_ = true;
+            }
+            available_.notify_all();
+            for (auto& thread : threads_) {
+                thread.join();
+            }
+        }
+
+        void submit(block_request request)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.push_back(std::move(request));
+            }
+            available_.notify_one();
+        }
+
+    private:
+        void work()
+        {
+            while (true) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                available_.wait(lock, [&]() { return stopped_ || not queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                auto request = std::move(queue_.front());
+                queue_.pop_front();
+                lock.unlock();
+                request.complete(read(request));
+                on_complete_();
+            }
+        }
+
+        static auto read(block_request const& request) -> std::int64_t
+        {
+            std::uint64_t done = 0;
+            while (done < request.size) {
+                auto count = ::pread(request.file->fd(),
+                                     request.buffer->data() + done,
+                                     request.size - done,
+                                     request.offset + done);
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (count <= 0) {
+                    return -1;
+                }
+                done += count;
+            }
+            return done;
+        }
+
+        std::function<void()> on_complete_;
+        std::mutex mutex_{};
+        std::condition_variable available_{};
+        std::deque<block_request> queue_{};
+        bool stopped_ = false;
+        std::vector<std::thread> threads_{};
+    };
+
+#ifdef IRKIT_HAVE_LIBURING
+    //! Reads blocks with io_uring; completions are reaped by a single thread.
+    //! All reads must complete before it is destroyed.
+    class uring_reader {
+    public:
+        //! \throws std::runtime_error  if io_uring is not available
+        uring_reader(unsigned depth, std::function<void()> on_complete)
+            : on_complete_(std::move(on_complete))
+        {
+            if (int err = io_uring_queue_init(depth, &ring_, 0); err < 0) {
+                throw std::runtime_error(
+                    fmt::format("io_uring unavailable: {}", std::strerror(-err)));
+            }
+            reaper_ = std::thread([this]() { reap(); });
+        }
+        uring_reader(uring_reader const&) = delete;
+        uring_reader(uring_reader&&) = delete;
+        uring_reader& operator=(uring_reader const&) = delete;
+        uring_reader& operator=(uring_reader&&) = delete;
+        ~uring_reader()
+        {
+            {
+                std::lock_guard<std::mutex> lock(submit_mutex_);
+                auto* sqe = next_sqe();
+                io_uring_prep_nop(sqe);
+                io_uring_sqe_set_data(sqe, nullptr);
+                io_uring_submit(&ring_);
+            }
+            reaper_.join();
+            io_uring_queue_exit(&ring_);
+        }
+
+        //! The caller must ensure that no more requests are in flight than
+        //! the queue depth, so that completions cannot overflow.
+        void submit(block_request request)
+        {
+            auto pending = std::make_unique<block_request>(std::move(request));
+            std::lock_guard<std::mutex> lock(submit_mutex_);
+            auto* sqe = next_sqe();
+            io_uring_prep_read(sqe,
+                               pending->file->fd(),
+                               pending->buffer->data(),
+                               static_cast<unsigned>(pending->size),
+                               pending->offset);
+            io_uring_sqe_set_data(sqe, pending.release());
+            io_uring_submit(&ring_);
+        }
+
+    private:
+        io_uring_sqe* next_sqe()
+        {
+            auto* sqe = io_uring_get_sqe(&ring_);
+            while (sqe == nullptr) {
+                io_uring_submit(&ring_);
+                sqe = io_uring_get_sqe(&ring_);
+            }
+            return sqe;
+        }
+
+        void reap()
+        {
+            while (true) {
+                io_uring_cqe* cqe = nullptr;
+                if (int err = io_uring_wait_cqe(&ring_, &cqe); err == -EINTR) {
+                    continue;
+                } else if (err < 0) {
+                    return;
+                }
+                std::unique_ptr<block_request> request(
+                    static_cast<block_request*>(io_uring_cqe_get_data(cqe)));
+                auto result = cqe->res;
+                io_uring_cqe_seen(&ring_, cqe);
+                if (request == nullptr) {
+                    return;
+                }
+                // A short read leaves the block out of the cache.
+                request->complete(result);
+                on_complete_();
+            }
+        }
+
+        std::function<void()> on_complete_;
+        io_uring ring_{};
+        std::mutex submit_mutex_{};
+        std::thread reaper_{};
+    };
+#endif
+
+}  // namespace detail::prefetch
+
+//! Reads blocks of cached files asynchronously, ahead of their use.
+/*!
+ * With `IRKIT_HAVE_LIBURING` defined, reads are issued with io_uring;
+ * otherwise, or if io_uring cannot be set up, they are issued by a pool of
+ * threads calling `pread`. Either way, `prefetch` only queues the range and
+ * returns: a dispatching thread splits ranges into blocks and issues their
+ * reads, waiting whenever `depth` reads are in flight, so the caller never
+ * waits on read-ahead. Blocks are inserted into the cache as their reads
+ * complete. A block that is used before its read completes is simply read
+ * again synchronously.
+ */
+class block_prefetcher {
+public:
+    static constexpr std::size_t default_depth = 64;
+    static constexpr std::size_t default_threads = 8;
+
+    //! \param depth    maximum number of reads in flight
+    //! \param threads  number of reading threads, if io_uring is not used
+    explicit block_prefetcher(std::size_t depth = default_depth,
+                              std::size_t threads = default_threads)
+        : depth_(depth)
+    {
+        EXPECTS(depth > 0);
+#ifdef IRKIT_HAVE_LIBURING
+        try {
+            uring_ = std::make_unique<detail::prefetch::uring_reader>(
+                depth, [this]() { in_flight_.remove(); });
+        } catch (std::runtime_error const&) {
+            // Falls back to the thread pool below.
+        }
+        if (uring_ == nullptr)
+#endif
+        {
+            pool_ = std::make_unique<detail::prefetch::pread_pool>(
+                threads, [this]() { in_flight_.remove(); });
+        }
+        dispatcher_ = std::thread([this]() { dispatch(); });
+    }
+
+    block_prefetcher(block_prefetcher const&) = delete;
+    block_prefetcher(block_prefetcher&&) = delete;
+    block_prefetcher& operator=(block_prefetcher const&) = delete;
+    block_prefetcher& operator=(block_prefetcher&&) = delete;
+    ~block_prefetcher()
+    {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        pending_changed_.notify_all();
+        dispatcher_.join();
+    }
+
+    //! Queues reads of all blocks of [offset, offset + size) that are not
+    //! cached yet, and returns without waiting for them to be issued.
+    void prefetch(std::shared_ptr<const cached_file> const& file,
+                  std::uint64_t offset,
+                  std::uint64_t size)
+    {
+        if (size == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back({file, offset, size});
+        }
+        pending_changed_.notify_all();
+    }
+
+    //! Waits until all queued reads are issued and complete.
+    void wait()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            pending_changed_.wait(lock, [&]() { return pending_.empty() && not dispatching_; });
+        }
+        in_flight_.wait_for_all();
+    }
+
+    //! Returns `"io_uring"` or `"pread"`.
+    [[nodiscard]] auto backend() const -> std::string_view
+    {
+#ifdef IRKIT_HAVE_LIBURING
+        if (uring_ != nullptr) {
+            return "io_uring";
+        }
+#endif
+        return "pread";
+    }
+
+private:
+    struct pending_range {
+        std::shared_ptr<const cached_file> file;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    void dispatch()
+    {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            pending_changed_.wait(lock, [&]() { return stopped_ || not pending_.empty(); });
+            if (pending_.empty()) {
+                return;
+            }
+            auto range = std::move(pending_.front());
+            pending_.pop_front();
+            dispatching_ = true;
+            lock.unlock();
+            issue(range);
+            lock.lock();
+            dispatching_ = false;
+            lock.unlock();
+            pending_changed_.notify_all();
+        }
+    }
+
+    void issue(pending_range const& range)
+    {
+        auto const& file = range.file;
+        auto block_size = file->cache().block_size();
+        auto last = (range.offset + range.size - 1) / block_size;
+        for (auto block = range.offset / block_size; block <= last; ++block) {
+            if (file->cache().contains(file->id(), block)) {
+                continue;
+            }
+            in_flight_.add(depth_);
+            detail::prefetch::block_request request(file, block);
+#ifdef IRKIT_HAVE_LIBURING
+            if (uring_ != nullptr) {
+                uring_->submit(std::move(request));
+                continue;
+            }
+#endif
+            pool_->submit(std::move(request));
+        }
+    }
+
+    std::size_t depth_;
+    detail::prefetch::in_flight_counter in_flight_{};
+#ifdef IRKIT_HAVE_LIBURING
+    std::unique_ptr<detail::prefetch::uring_reader> uring_{};
+#endif
+    std::unique_ptr<detail::prefetch::pread_pool> pool_{};
+    std::mutex mutex_{};
+    std::condition_variable pending_changed_{};
+    std::deque<pending_range> pending_{};
+    bool dispatching_ = false;
+    bool stopped_ = false;
+    std::thread dispatcher_{};
+};
+
+}  // namespace irk
@@ -33,6 +33,7 @@
 #include <fmt/format.h>
 #include <gsl/span>
 #include <irkit/algorithm/query.hpp>
+#include <irkit/arena.hpp>
 #include <irkit/parsing/stemmer.hpp>
 #include <irkit/score.hpp>
 
@@ -74,8 +75,8 @@ template<class Score_Tag, class Index>
 auto fetch_scorers(Index const& index, gsl::span<std::string const>& terms, Score_Tag score_tag)
 {
     std::vector<decltype(index.term_scorer(0, score_tag))> scorers;
-    for (const auto& term : terms) {
-        if (auto term_id = index.term_id(term); term_id) {
+    for (const auto& term_id : index.term_ids(terms)) {
+        if (term_id) {
             scorers.push_back(index.term_scorer(term_id.value(), score_tag));
         } else {
             scorers.push_back(index.term_scorer(0, score_tag));
@@ -90,8 +91,8 @@ inline auto fetched_query_postings(Index const& index, gsl::span<std::string con
     using posting_list_type = decltype(index.postings(std::declval<std::string>()).fetch());
     std::vector<posting_list_type> postings;
     postings.reserve(query_terms.size());
-    for (const auto& term : query_terms) {
-        postings.push_back(index.postings(term).fetch());
+    for (const auto& term_id : index.term_ids(query_terms)) {
+        postings.push_back(index.postings(term_id).fetch());
     }
     return postings;
 }
@@ -109,6 +110,37 @@ fetched_query_scored_postings(Index const& index, gsl::span<std::string const>&
     return postings;
 }
 
+//! Returns the postings of the query terms, decoded lazily into `arena`.
+template<typename Index>
+inline auto
+arena_query_postings(Index const& index, gsl::span<std::string const>& query_terms, ir::Arena& arena)
+{
+    using posting_list_type = decltype(
+        index.postings(std::optional<typename Index::term_id_type>{}, arena));
+    std::vector<posting_list_type> postings;
+    postings.reserve(query_terms.size());
+    for (const auto& term_id : index.term_ids(query_terms)) {
+        postings.push_back(index.postings(term_id, arena));
+    }
+    return postings;
+}
+
+//! Returns the scored postings of the query terms, decoded lazily into `arena`.
+template<typename Index>
+inline auto arena_query_scored_postings(Index const& index,
+                                        gsl::span<std::string const>& query_terms,
+                                        ir::Arena& arena)
+{
+    using posting_list_type = decltype(
+        index.scored_postings(std::optional<typename Index::term_id_type>{}, arena));
+    std::vector<posting_list_type> postings;
+    postings.reserve(query_terms.size());
+    for (const auto& term_id : index.term_ids(query_terms)) {
+        postings.push_back(index.scored_postings(term_id, arena));
+    }
+    return postings;
+}
+
 struct Printable : boost::te::poly<Printable> {
     using boost::te::poly<Printable>::poly;
 
@@ -268,15 +300,14 @@ private:
         [[nodiscard]] auto run_query_with_precomputed(gsl::span<std::string const> query_terms,
                                                       int const k,
                                                       Index const& index,
-                                                      Traversal_Tag traversal_tag)
+                                                      Traversal_Tag traversal_tag,
+                                                      ir::Arena& arena)
         {
+            const auto postings = arena_query_scored_postings(index, query_terms, arena);
             if constexpr (std::is_same_v<Traversal_Tag, irk::Taat_Traveral_Tag>) {
-                return irk::taat(gsl::make_span(fetched_query_scored_postings(index, query_terms)),
-                                 index.collection_size(),
-                                 k);
+                return irk::taat(gsl::make_span(postings), index.collection_size(), k);
             } else if constexpr (std::is_same_v<Traversal_Tag, irk::Daat_Traveral_Tag>) {
-                return irk::daat(gsl::make_span(fetched_query_scored_postings(index, query_terms)),
-                                 k);
+                return irk::daat(gsl::make_span(postings), k);
             }
             std::clog << "unimplemented traversal tag: " << traversal_tag << '\n';
             std::abort();
@@ -286,10 +317,11 @@ private:
                                                   int const k,
                                                   const Index& index,
                                                   Score_Tag score_tag,
-                                                  Traversal_Tag traversal_tag)
+                                                  Traversal_Tag traversal_tag,
+                                                  ir::Arena& arena)
         {
             const auto scorers = fetch_scorers(index, query_terms, score_tag);
-            const auto postings = fetched_query_postings(index, query_terms);
+            const auto postings = arena_query_postings(index, query_terms, arena);
             assert(scorers.size() == postings.size());
             if constexpr (std::is_same_v<Traversal_Tag, irk::Taat_Traveral_Tag>) {
                 return irk::taat(
@@ -321,12 +353,18 @@ private:
                                      std::back_inserter(stemmed_terms),
                                      [&](auto const& term) { return stem(term); });
             }
+            // Posting lists are decoded into the thread's arena, which is
+            // reset once the results are computed.
+            auto& arena = ir::thread_arena();
             if constexpr (std::is_base_of_v<score::scoring_function_tag, Score_Tag>) {
                 auto results = run_query_with_scoring(
-                    query_terms, k, index_, scorer_, traversal_tag_);
+                    query_terms, k, index_, scorer_, traversal_tag_, arena);
+                arena.reset();
                 return Query_Result_List(std::move(results));
             } else {
-                auto results = run_query_with_precomputed(query_terms, k, index_, traversal_tag_);
+                auto results =
+                    run_query_with_precomputed(query_terms, k, index_, traversal_tag_, arena);
+                arena.reset();
                 return Query_Result_List(std::move(results));
             }
         }
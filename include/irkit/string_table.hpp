@@ -0,0 +1,187 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <fmt/format.h>
+
+#include <irkit/assert.hpp>
+#include <irkit/coding/vbyte.hpp>
+#include <irkit/compacttable.hpp>
+#include <irkit/io.hpp>
+#include <irkit/memoryview.hpp>
+
+namespace irk {
+
+//! An immutable array of strings with constant-time access.
+/*!
+ * Strings are stored back to back, uncompressed, and located with an
+ * Elias-Fano table of their offsets. Thus, contrary to `lexicon`, accessing
+ * a string by its index does not decode any other strings, at the price of
+ * not supporting lookups by value. It is meant for data such as document
+ * titles, which are only ever resolved by ID.
+ *
+ * Memory layout:
+ * ```
+ * [offset table size: u64][offset table: size + 1 offsets][string bytes]
+ * ```
+ */
+template<class MemoryContainer>
+class string_table {
+public:
+    using index_type = std::ptrdiff_t;
+    using memory_container = MemoryContainer;
+    using offset_table_type = compact_table<std::size_t,
+                                            vbyte_codec<std::size_t>,
+                                            memory_container>;
+
+    string_table(offset_table_type offsets, memory_container bytes)
+        : offsets_(std::move(offsets)), bytes_(std::move(bytes))
+    {
+        if (offsets_.size() == 0) {
+            throw std::runtime_error("string table has no offsets");
+        }
+        auto total_size = offsets_[offsets_.size() - 1];
+        if (total_size != static_cast<std::size_t>(bytes_.size())) {
+            throw std::runtime_error(fmt::format(
+                "string table size {} does not match its offsets (expected {})",
+                bytes_.size(),
+                total_size));
+        }
+    }
+
+    //! Returns the string at `index`.
+    /*!
+     * The returned view points to the table's memory and is valid as long
+     * as that memory is.
+     */
+    std::string_view key_at(index_type index) const
+    {
+        EXPECTS(index >= 0 && index < size());
+        auto first = offsets_[index];
+        auto last = offsets_[index + 1];
+        return std::string_view(bytes_.data() + first, last - first);
+    }
+
+    std::string_view operator[](index_type index) const
+    {
+        return key_at(index);
+    }
+
+    //! Resolves a batch of indices, writing `std::string_view`s to `out`.
+    /*!
+     * Indices may come in any order, but sorted ones access both the offsets
+     * and the strings sequentially.
+     */
+    template<class IndexIterator, class OutputIterator>
+    OutputIterator
+    keys_at(IndexIterator first, IndexIterator last, OutputIterator out) const
+    {
+        const char* bytes = bytes_.data();
+        for (; first != last; ++first) {
+            auto index = static_cast<index_type>(*first);
+            EXPECTS(index >= 0 && index < size());
+            auto begin = offsets_[index];
+            *out++ = std::string_view(bytes + begin, offsets_[index + 1] - begin);
+        }
+        return out;
+    }
+
+    std::ptrdiff_t size() const { return offsets_.size() - 1; }
+
+    std::ostream& serialize(std::ostream& out) const
+    {
+        std::vector<char> header;
+        std::uint64_t offset_table_size = offsets_.buffer().size();
+        io::append_object(offset_table_size, header);
+        out.write(header.data(), header.size());
+        offsets_.serialize(out);
+        return out.write(bytes_.data(), bytes_.size());
+    }
+
+    void serialize(const boost::filesystem::path& file) const
+    {
+        std::ofstream out(file.c_str());
+        serialize(out);
+    }
+
+private:
+    offset_table_type offsets_;
+    memory_container bytes_;
+};
+
+//! Builds a string table holding `keys` in the given order.
+inline string_table<std::vector<char>>
+build_string_table(const std::vector<std::string>& keys)
+{
+    std::vector<std::size_t> offsets;
+    offsets.reserve(keys.size() + 1);
+    std::vector<char> bytes;
+    for (const auto& key : keys) {
+        offsets.push_back(bytes.size());
+        bytes.insert(bytes.end(), key.begin(), key.end());
+    }
+    offsets.push_back(bytes.size());
+    return string_table<std::vector<char>>(
+        build_elias_fano_table<std::size_t>(offsets), std::move(bytes));
+}
+
+//! Builds a string table holding the lines of a file.
+inline string_table<std::vector<char>>
+build_string_table(const boost::filesystem::path& file)
+{
+    std::ifstream keys(file.c_str());
+    return build_string_table(std::vector<std::string>(
+        irk::io::line_iterator(keys), irk::io::line_iterator()));
+}
+
+inline string_table<irk::memory_view>
+load_string_table(const irk::memory_view& memory)
+{
+    if (memory.size() < static_cast<std::ptrdiff_t>(sizeof(std::uint64_t))) {
+        throw std::runtime_error("string table is truncated");
+    }
+    std::uint64_t offset_table_size;
+    std::memcpy(&offset_table_size, memory.data(), sizeof(offset_table_size));
+    std::ptrdiff_t bytes_offset = sizeof(std::uint64_t) + offset_table_size;
+    if (bytes_offset > memory.size()) {
+        throw std::runtime_error("string table is truncated");
+    }
+    return string_table<irk::memory_view>(
+        string_table<irk::memory_view>::offset_table_type(
+            memory(sizeof(std::uint64_t), bytes_offset)),
+        memory(bytes_offset, memory.size()));
+}
+
+}  // namespace irk
@@ -26,7 +26,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <ostream>
 #include <vector>
 
 #include <CLI/CLI.hpp>
@@ -35,11 +38,14 @@
 #include <tbb/task_scheduler_init.h>
 
 #include <irkit/algorithm/query.hpp>
+#include <irkit/block_cache.hpp>
 #include <irkit/compacttable.hpp>
 #include <irkit/daat.hpp>
 #include <irkit/index/types.hpp>
+#include <irkit/index/warmup.hpp>
 #include <irkit/memoryview.hpp>
 #include <irkit/parsing/stemmer.hpp>
+#include <irkit/prefetch.hpp>
 #include <irkit/query_engine.hpp>
 #include <irkit/score.hpp>
 #include <irkit/taat.hpp>
@@ -187,6 +193,30 @@ CLI::Option* add_traversal_type(CLI::App& app,
     return opt;
 }
 
+CLI::Option* add_warmup_mode(CLI::App& app,
+                             std::string name,
+                             index::Warmup_Mode& variable,
+                             std::string description = "",
+                             bool defaulted = false)
+{
+    CLI::callback_t fun = [&variable](CLI::results_t res) {
+        if (auto mode = index::parse_warmup_mode(res[0]); mode.has_value()) {
+            variable = mode.value();
+            return true;
+        }
+        return false;
+    };
+
+    CLI::Option *opt = app.add_option(name, fun, description, defaulted);
+    opt->type_name("lazy|populate|willneed|mlock|hugepages")->type_size(1);
+    if (defaulted) {
+        std::stringstream out;
+        out << variable;
+        opt->default_str(out.str());
+    }
+    return opt;
+}
+
 template<class Index, class RngRng>
 inline auto process_query(
     const Index& index, const RngRng& postings, int k, ProcessingType type)
@@ -410,6 +440,103 @@ struct threads_opt {
     }
 };
 
+struct warmup_opt {
+    index::Warmup_Policy warmup{};
+    bool latency_report = false;
+
+    template<class Args>
+    void set(CLI::App& app, Args& args)
+    {
+        add_warmup_mode(app,
+                        "--warmup-postings",
+                        args->warmup.postings,
+                        "How to load posting data into memory",
+                        true);
+        add_warmup_mode(app,
+                        "--warmup-metadata",
+                        args->warmup.metadata,
+                        "How to load offsets, lexicons, sizes, and other tables",
+                        true);
+        app.add_flag("--latency-report",
+                     args->latency_report,
+                     "Report warmup time and when query latency becomes steady");
+    }
+};
+
+struct block_cache_opt {
+    std::size_t cache_size = 0;
+    std::size_t cache_block_size = block_cache::default_block_size / 1024;
+    std::size_t prefetch = 0;
+
+    template<class Args>
+    void set(CLI::App& app, Args& args)
+    {
+        app.add_option("--cache-size",
+                       args->cache_size,
+                       "Read postings into a block cache of this many MB instead of mapping them",
+                       true);
+        app.add_option(
+            "--cache-block-size", args->cache_block_size, "Block cache block size in KB", true);
+        app.add_option("--prefetch",
+                       args->prefetch,
+                       "Read postings of this many next queries into the block cache "
+                       "ahead of processing",
+                       true);
+    }
+
+    [[nodiscard]] auto make_block_cache() const -> std::shared_ptr<block_cache>
+    {
+        return std::make_shared<block_cache>(cache_size * 1024 * 1024, cache_block_size * 1024);
+    }
+};
+
+//! Records query latencies to find out when they reach a steady state.
+/*!
+ * Latency is considered steady from the first query at which the mean latency
+ * of a window of consecutive queries falls within 25% of the overall median.
+ */
+class latency_report {
+public:
+    using duration = std::chrono::microseconds;
+
+    void set_warmup_time(duration time) { warmup_time_ = time; }
+
+    template<class Fn>
+    void run(Fn fn)
+    {
+        latencies_.push_back(irk::run_with_timer<duration>(fn));
+    }
+
+    void print(std::ostream& os) const
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        os << "Warmup time: " << duration_cast<milliseconds>(warmup_time_).count() << " ms\n";
+        if (latencies_.empty()) { return; }
+        std::vector<duration> sorted(latencies_);
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        auto median = sorted[sorted.size() / 2];
+        auto window = std::min<std::size_t>(16, latencies_.size());
+        std::size_t steady = 0;
+        duration window_sum{};
+        for (std::size_t idx = 0; idx < window; ++idx) { window_sum += latencies_[idx]; }
+        while (steady + window < latencies_.size() && window_sum > median * 5 * window / 4) {
+            window_sum += latencies_[steady + window] - latencies_[steady];
+            ++steady;
+        }
+        duration until_steady = warmup_time_;
+        for (std::size_t idx = 0; idx < steady; ++idx) { until_steady += latencies_[idx]; }
+        os << "First query latency: " << latencies_.front().count() << " us\n";
+        os << "Median query latency: " << median.count() << " us\n";
+        os << "Steady state after " << steady << " queries and "
+           << duration_cast<milliseconds>(until_steady).count() << " ms (including warmup)\n";
+    }
+
+private:
+    duration warmup_time_{};
+    std::vector<duration> latencies_{};
+};
+
 struct traversal_type_opt {
     Traversal_Type traversal_type;
 
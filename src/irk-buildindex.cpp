@@ -46,6 +46,9 @@ int main(int argc, char** argv)
     int lexicon_block_size = 256;
     bool merge_only = false;
     std::string spam_titles;
+    ir::Block_List_Options list_options{0.0, true};
+    bool legacy_headers = false;
+    int threads = 1;
 
     CLI::App app{"Build an inverted index."};
     app.add_flag("--merge-only", merge_only, "Merge already existing batches.");
@@ -62,6 +65,25 @@ int main(int argc, char** argv)
         skip_block_size,
         "Size of skip blocks for inverted lists.",
         true);
+    app.add_option("--bitmap-density",
+        list_options.bitmap_density,
+        "Store document lists containing at least this fraction of documents as bitmaps "
+        "(0 to disable).",
+        true);
+    app.add_flag("--legacy-headers",
+        legacy_headers,
+        "Write list headers with varbyte-encoded skips instead of fixed-width.");
+    app.add_flag("--variable-blocks",
+        list_options.variable_blocks,
+        "Partition lists into blocks of at most skip block size, minimizing their size.");
+    app.add_option("--block-overhead",
+        list_options.block_overhead,
+        "Cost of a block in bytes when partitioning with --variable-blocks.",
+        true);
+    app.add_option("--threads,-j",
+        threads,
+        "Number of batches built concurrently; up to 2 * threads + 1 are held in memory.",
+        true);
     app.add_option(
         "--spam",
         spam_titles,
@@ -70,6 +92,7 @@ int main(int argc, char** argv)
     app.add_option("output_dir", output_dir, "Index output directory", false)
         ->required();
     CLI11_PARSE(app, argc, argv);
+    list_options.fixed_width = not legacy_headers;
 
     auto log = spdlog::stderr_color_mt("buildindex");
     if (merge_only)
@@ -81,14 +104,19 @@ int main(int argc, char** argv)
                 std::vector<fs::path> batch_dirs{
                     fs::directory_iterator(batch_dir),
                     fs::directory_iterator()};
-                irk::index_merger merger(dir, batch_dirs, skip_block_size);
+                irk::index_merger merger(
+                    dir, batch_dirs, skip_block_size, false, list_options);
                 merger.merge();
                 auto term_map = irk::build_lexicon(
                     irk::index::terms_path(output_dir), lexicon_block_size);
                 term_map.serialize(irk::index::term_map_path(output_dir));
+                irk::build_hash_dictionary(irk::index::terms_path(output_dir))
+                    .serialize(irk::index::term_hash_path(output_dir));
                 auto title_map = irk::build_lexicon(
                     irk::index::titles_path(output_dir), lexicon_block_size);
                 title_map.serialize(irk::index::title_map_path(output_dir));
+                irk::build_string_table(irk::index::titles_path(output_dir))
+                    .serialize(irk::index::title_table_path(output_dir));
             },
             [&](const auto& time) {
                 log->info("Merged in {}", irk::format_time(time));
@@ -112,7 +140,9 @@ int main(int argc, char** argv)
                     batch_size,
                     skip_block_size,
                     lexicon_block_size,
-                    spamlist);
+                    spamlist,
+                    list_options,
+                    threads);
                 assembler.assemble(std::cin);
             },
             [&](const auto& time) {
@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#include <string>
+
+#include <CLI/CLI.hpp>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <irkit/index/convert.hpp>
+
+int main(int argc, char** argv)
+{
+    std::string input_dir;
+    std::string output_dir;
+    bool legacy_headers = false;
+
+    CLI::App app{"Converts the lists of an index between header layouts.\n"
+                 "By default, the lists are written with fixed-width headers, "
+                 "which can be opened without decoding skips."};
+    app.add_flag("--legacy-headers",
+                 legacy_headers,
+                 "Write headers with varbyte-encoded skips and block-compressed offset tables, "
+                 "readable by older versions (unless the input has bit-packed tables).");
+    app.add_option("input_dir", input_dir, "Input index directory", false)
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    app.add_option("output_dir", output_dir, "Output index directory", false)->required();
+    CLI11_PARSE(app, argc, argv);
+
+    auto log = spdlog::stderr_color_mt("convert-lists");
+    try {
+        irk::index::convert_lists(input_dir, output_dir, legacy_headers);
+    } catch (std::exception const& error) {
+        log->error(error.what());
+        return 1;
+    }
+    return 0;
+}
@@ -24,11 +24,21 @@
 //! \author     Michal Siedlaczek
 //! \copyright  MIT License
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <iostream>
+#include <sstream>
 
 #include <CLI/CLI.hpp>
 #include <boost/filesystem.hpp>
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
 
+#include <irkit/coding/adaptive.hpp>
+#include <irkit/coding/bitpacking.hpp>
 #include <irkit/coding/stream_vbyte.hpp>
 #include <irkit/coding/vbyte.hpp>
 #include <irkit/index.hpp>
@@ -39,6 +49,14 @@
 namespace fs = boost::filesystem;
 using irk::index::term_id_t;
 using irk::index::document_t;
+using irk::index::frequency_t;
+
+template<class T>
+using adaptive_codec = irk::adaptive_codec<T,
+                                           irk::stream_vbyte_codec<T>,
+                                           irk::bitpacking_codec<T>,
+                                           irk::vbyte_codec<T>>;
+const std::array<std::string, 3> adaptive_codec_names = {"stream_vbyte", "bitpacking", "vbyte"};
 
 void disect_document_list(const irk::memory_view& memory, int64_t length)
 {
@@ -47,8 +65,23 @@ void disect_document_list(const irk::memory_view& memory, int64_t length)
     irk::stream_vbyte_codec<document_t> codec;
 
     int64_t list_byte_size, num_blocks, block_size;
+    int64_t flags = 0;
     pos = vb.decode(pos, &list_byte_size);
     pos = vb.decode(pos, &block_size);
+    if (block_size == 0) {
+        int64_t codec_tag;
+        pos = vb.decode(pos, &flags);
+        pos = vb.decode(pos, &codec_tag);
+        pos = vb.decode(pos, &block_size);
+        std::cout << "Flags: " << flags << std::endl;
+        std::cout << "Codec tag: " << codec_tag << std::endl;
+        auto supported_flags =
+            ir::Block_List_Format::Fixed_Width | ir::Block_List_Format::Variable_Blocks;
+        if ((flags & ~supported_flags) != 0 || codec_tag != 0) {
+            std::cout << "Only lists encoded with stream_vbyte can be disected" << std::endl;
+            return;
+        }
+    }
     pos = vb.decode(pos, &num_blocks);
     if (list_byte_size != memory.size())
     {
@@ -62,11 +95,45 @@ void disect_document_list(const irk::memory_view& memory, int64_t length)
     std::cout << "Block size: " << block_size << std::endl;
     std::cout << "Block count: " << num_blocks << std::endl;
 
+    bool variable_blocks = (flags & ir::Block_List_Format::Variable_Blocks) != 0;
+    std::vector<int64_t> block_ends(num_blocks);
+    for (int64_t block = 0; block < num_blocks; ++block) {
+        block_ends[block] = std::min((block + 1) * block_size, length);
+    }
     std::vector<int64_t> skips(num_blocks);
-    pos = vb.decode(pos, &skips[0], num_blocks);
     std::vector<document_t> last_documents(num_blocks);
-    pos = codec.delta_decode(pos, &last_documents[0], num_blocks);
+    if ((flags & ir::Block_List_Format::Fixed_Width) != 0) {
+        if (variable_blocks) {
+            std::vector<int32_t> ends(num_blocks);
+            std::memcpy(ends.data(), pos, num_blocks * sizeof(int32_t));
+            std::advance(pos, num_blocks * sizeof(int32_t));
+            block_ends.assign(ends.begin(), ends.end());
+        }
+        std::vector<int32_t> offsets(num_blocks);
+        std::vector<int32_t> last_values(num_blocks);
+        std::memcpy(offsets.data(), pos, num_blocks * sizeof(int32_t));
+        std::advance(pos, num_blocks * sizeof(int32_t));
+        std::memcpy(last_values.data(), pos, num_blocks * sizeof(int32_t));
+        std::advance(pos, num_blocks * sizeof(int32_t));
+        int64_t previous = std::distance(memory.begin(), pos);
+        for (int64_t block = 0; block < num_blocks; ++block) {
+            skips[block] = offsets[block] - previous;
+            previous = offsets[block];
+            last_documents[block] = last_values[block];
+        }
+    } else {
+        if (variable_blocks) {
+            pos = vb.delta_decode(pos, &block_ends[0], num_blocks);
+        }
+        pos = vb.decode(pos, &skips[0], num_blocks);
+        pos = codec.delta_decode(pos, &last_documents[0], num_blocks);
+    }
 
+    if (variable_blocks) {
+        std::cout << "Block ends: [ ";
+        for (const auto& end : block_ends) { std::cout << end << " "; }
+        std::cout << "]\n";
+    }
     std::cout << "Skips: [ ";
     for (const auto& skip : skips) { std::cout << skip << " "; }
     std::cout << "]\nLast doc in block: [ ";
@@ -77,7 +144,7 @@ void disect_document_list(const irk::memory_view& memory, int64_t length)
     {
         std::advance(pos, skips[block]);
         auto mem = irk::make_memory_view(pos, skips[block + 1]);
-        auto count = block < num_blocks - 1 ? block_size : length % block_size;
+        auto count = block_ends[block] - (block > 0 ? block_ends[block - 1] : 0);
         auto preceding = block > 0 ? last_documents[block - 1] : 0;
         std::vector<document_t> decoded(count);
         codec.delta_decode(
@@ -88,17 +155,351 @@ void disect_document_list(const irk::memory_view& memory, int64_t length)
     }
     std::advance(pos, skips.back());
     auto mem = irk::make_memory_view(pos, std::distance(pos, std::end(memory)));
-    auto count = length % block_size;
+    auto count = num_blocks > 1 ? length - block_ends[num_blocks - 2] : length;
+    auto preceding = num_blocks > 1 ? last_documents[num_blocks - 2] : 0;
     std::vector<document_t> decoded(count);
-    codec.delta_decode(std::begin(mem),
-        std::begin(decoded),
+    codec.delta_decode(mem.data(),
+        decoded.data(),
         count,
-        last_documents[num_blocks - 1]);
+        preceding);
     std::cout << "B" << num_blocks - 1 << ": [ ";
     for (const auto& doc : decoded) { std::cout << doc << " "; }
     std::cout << "]\n";
 }
 
+//! Accumulates statistics of re-encoding lists with an adaptive codec.
+struct Codec_Mix {
+    std::array<int64_t, adaptive_codec_names.size()> lists{};
+    std::array<int64_t, adaptive_codec_names.size()> bytes{};
+    int64_t original_bytes = 0;
+    int64_t adaptive_bytes = 0;
+
+    template<class List, class Value = typename List::value_type>
+    void add(List const& list, adaptive_codec<Value> const& codec)
+    {
+        constexpr bool delta_encoded = List::is_delta_encoded();
+        ir::Standard_Block_List_Builder<Value, adaptive_codec<Value>, delta_encoded> builder(
+            list.block_size(), codec);
+        for (auto value : list) {
+            builder.add(value);
+        }
+        std::ostringstream os;
+        auto size = builder.write(os);
+        auto encoded = os.str();
+        ir::Standard_Block_List<Value, adaptive_codec<Value>, delta_encoded> adaptive_list(
+            list.term_id(), irk::make_memory_view(encoded.data(), encoded.size()), list.size());
+        auto tag = adaptive_list.format().codec_tag;
+        lists[tag] += 1;
+        bytes[tag] += size;
+        original_bytes += list.memory().size();
+        adaptive_bytes += size;
+    }
+
+    void print(std::string const& name) const
+    {
+        std::cout << name << ":\n";
+        for (std::size_t tag = 0; tag < adaptive_codec_names.size(); ++tag) {
+            std::cout << fmt::format("  {:<14}{:>12} lists{:>16} bytes\n",
+                                     adaptive_codec_names[tag],
+                                     lists[tag],
+                                     bytes[tag]);
+        }
+        auto saved = original_bytes - adaptive_bytes;
+        std::cout << fmt::format("  Original size: {} bytes\n", original_bytes);
+        std::cout << fmt::format("  Adaptive size: {} bytes\n", adaptive_bytes);
+        std::cout << fmt::format("  Saved: {} bytes ({:.2f}%)\n",
+                                 saved,
+                                 original_bytes > 0 ? 100.0 * saved / original_bytes : 0.0);
+    }
+};
+
+//! Reports which codecs would be selected by an adaptive codec for each list,
+//! and how many bytes it would save over the current encoding.
+void disect_codec_mix(irk::inverted_index_view const& index, double slack)
+{
+    adaptive_codec<document_t> document_codec(slack);
+    adaptive_codec<frequency_t> frequency_codec(slack);
+    Codec_Mix documents, frequencies;
+    for (term_id_t term_id = 0; term_id < index.term_count(); ++term_id) {
+        documents.add(index.documents(term_id), document_codec);
+        frequencies.add(index.frequencies(term_id), frequency_codec);
+    }
+    documents.print("Documents");
+    frequencies.print("Frequencies");
+}
+
+//! Byte and posting counts of a group of lists.
+struct List_Footprint {
+    int64_t lists = 0;
+    int64_t postings = 0;
+    int64_t bytes = 0;
+    int64_t header_bytes = 0;
+
+    template<class List>
+    void add(List const& list)
+    {
+        lists += 1;
+        postings += list.size();
+        bytes += list.memory().size();
+        header_bytes += list.header_size();
+    }
+
+    void merge(List_Footprint const& other)
+    {
+        lists += other.lists;
+        postings += other.postings;
+        bytes += other.bytes;
+        header_bytes += other.header_bytes;
+    }
+
+    [[nodiscard]] auto to_json() const -> nlohmann::json
+    {
+        auto per_posting = [this](int64_t value) {
+            return postings > 0 ? 8.0 * value / postings : 0.0;
+        };
+        return {{"lists", lists},
+                {"postings", postings},
+                {"bytes", bytes},
+                {"header_bytes", header_bytes},
+                {"data_bytes", bytes - header_bytes},
+                {"bits_per_posting", per_posting(bytes)},
+                {"header_bits_per_posting", per_posting(header_bytes)},
+                {"data_bits_per_posting", per_posting(bytes - header_bytes)}};
+    }
+};
+
+//! Footprint of all posting lists, accumulated over a range of terms.
+struct Posting_Footprint {
+    //! Lists are grouped by length into buckets [2^k, 2^(k+1)).
+    static constexpr int length_buckets = 32;
+
+    List_Footprint documents{};
+    List_Footprint frequencies{};
+    std::vector<List_Footprint> scores{};
+    std::array<List_Footprint, length_buckets> by_length{};
+
+    explicit Posting_Footprint(std::size_t score_count = 0) : scores(score_count) {}
+
+    void add(irk::inverted_index_view const& index,
+             term_id_t term_id,
+             std::vector<std::string> const& score_names)
+    {
+        if (index.term_collection_frequency(term_id) == 0) {
+            return;
+        }
+        auto document_list = index.documents(term_id);
+        auto frequency_list = index.frequencies(term_id);
+        documents.add(document_list);
+        frequencies.add(frequency_list);
+        auto& bucket = by_length[63 - __builtin_clzll(document_list.size())];
+        bucket.lists += 1;
+        bucket.postings += document_list.size();
+        bucket.bytes += document_list.memory().size() + frequency_list.memory().size();
+        bucket.header_bytes += document_list.header_size() + frequency_list.header_size();
+        for (std::size_t idx = 0; idx < score_names.size(); ++idx) {
+            scores[idx].add(index.scores(term_id, score_names[idx]));
+        }
+    }
+
+    void merge(Posting_Footprint const& other)
+    {
+        documents.merge(other.documents);
+        frequencies.merge(other.frequencies);
+        for (std::size_t idx = 0; idx < scores.size(); ++idx) {
+            scores[idx].merge(other.scores[idx]);
+        }
+        for (int bucket = 0; bucket < length_buckets; ++bucket) {
+            by_length[bucket].merge(other.by_length[bucket]);
+        }
+    }
+};
+
+//! Sizes of lists re-encoded with a codec and a block size.
+struct Encoding_Footprint {
+    std::string codec;
+    int32_t block_size;
+    int64_t document_bytes = 0;
+    int64_t frequency_bytes = 0;
+};
+
+template<class Codec>
+void add_encoding(std::vector<Encoding_Footprint>& encodings,
+                  std::string const& name,
+                  int32_t block_size,
+                  irk::inverted_index_view const& index,
+                  std::vector<term_id_t> const& sample)
+{
+    using document_codec = typename Codec::template codec<document_t>;
+    using frequency_codec = typename Codec::template codec<frequency_t>;
+    auto encoded_size = [block_size](auto const& list, auto codec) -> int64_t {
+        using list_type = std::decay_t<decltype(list)>;
+        using value_type = typename list_type::value_type;
+        ir::Standard_Block_List_Builder<value_type,
+                                        decltype(codec),
+                                        list_type::is_delta_encoded()>
+            builder(block_size, codec);
+        for (auto value : list) {
+            builder.add(value);
+        }
+        std::ostringstream os;
+        return builder.write(os);
+    };
+    auto [document_bytes, frequency_bytes] = tbb::parallel_reduce(
+        tbb::blocked_range<std::size_t>(0, sample.size()),
+        std::pair<int64_t, int64_t>{0, 0},
+        [&](auto const& range, std::pair<int64_t, int64_t> sizes) {
+            for (auto idx = range.begin(); idx != range.end(); ++idx) {
+                sizes.first += encoded_size(index.documents(sample[idx]), document_codec{});
+                sizes.second += encoded_size(index.frequencies(sample[idx]), frequency_codec{});
+            }
+            return sizes;
+        },
+        [](auto lhs, auto const& rhs) {
+            return std::make_pair(lhs.first + rhs.first, lhs.second + rhs.second);
+        });
+    encodings.push_back({name, block_size, document_bytes, frequency_bytes});
+}
+
+struct Stream_Vbyte {
+    template<class T>
+    using codec = irk::stream_vbyte_codec<T>;
+};
+struct Bitpacking {
+    template<class T>
+    using codec = irk::bitpacking_codec<T>;
+};
+struct Vbyte {
+    template<class T>
+    using codec = irk::vbyte_codec<T>;
+};
+
+//! Reports the memory footprint of the index as JSON.
+/*!
+ * Contains the size of each index file, the bytes and bits per posting of
+ * document, frequency, and score lists, split into headers and encoded
+ * values, the footprint of lists grouped by length, and the size of
+ * `sample_size` evenly spaced lists re-encoded with each codec and each of
+ * `block_sizes`.
+ */
+void disect_footprint(irk::Inverted_Index_Mapped_Source const& source,
+                      irk::inverted_index_view const& index,
+                      int64_t sample_size,
+                      std::vector<int32_t> const& block_sizes)
+{
+    nlohmann::json sections{
+        {"documents", source.documents_view().size()},
+        {"frequencies", source.counts_view().size()},
+        {"document_offsets", source.document_offsets_view().size()},
+        {"count_offsets", source.count_offsets_view().size()},
+        {"term_lexicon", source.term_map_view().size()},
+        {"term_frequencies", source.term_collection_frequencies_view().size()},
+        {"term_occurrences", source.term_collection_occurrences_view().size()},
+        {"title_lexicon", source.title_map_view().size()},
+        {"document_sizes", source.document_sizes_view().size()},
+        {"properties", source.properties_view().size()}};
+    auto optional_size = [](auto const& view) -> int64_t {
+        return view.has_value() ? view->size() : 0;
+    };
+    sections["term_info"] = optional_size(source.term_info_view());
+    sections["term_hash"] = optional_size(source.term_hash_view());
+    sections["title_table"] = optional_size(source.title_table_view());
+    auto score_term_info = source.score_term_info_views();
+    for (auto const& [name, tuple] : source.scores_sources()) {
+        auto info = score_term_info.find(name);
+        sections["scores"][name] = {
+            {"postings", tuple.postings.size()},
+            {"offsets", tuple.offsets.size()},
+            {"max_scores", tuple.max_scores.size()},
+            {"term_info", info != score_term_info.end() ? info->second.size() : 0}};
+    }
+    for (auto const& [name, stats] : source.score_stats_views()) {
+        sections["score_stats"][name] = optional_size(stats.max) + optional_size(stats.mean)
+            + optional_size(stats.var);
+    }
+    int64_t total = 0;
+    for (auto const& entry : sections.flatten()) {
+        total += entry.get<int64_t>();
+    }
+    sections["total"] = total;
+
+    auto score_names = index.score_names();
+    std::sort(score_names.begin(), score_names.end());
+    auto footprint = tbb::parallel_reduce(
+        tbb::blocked_range<term_id_t>(0, index.term_count()),
+        Posting_Footprint(score_names.size()),
+        [&](auto const& range, Posting_Footprint footprint) {
+            for (auto term_id = range.begin(); term_id != range.end(); ++term_id) {
+                footprint.add(index, term_id, score_names);
+            }
+            return footprint;
+        },
+        [](Posting_Footprint lhs, Posting_Footprint const& rhs) {
+            lhs.merge(rhs);
+            return lhs;
+        });
+
+    nlohmann::json postings{{"documents", footprint.documents.to_json()},
+                            {"frequencies", footprint.frequencies.to_json()}};
+    for (std::size_t idx = 0; idx < score_names.size(); ++idx) {
+        postings["scores"][score_names[idx]] = footprint.scores[idx].to_json();
+    }
+    auto list_lengths = nlohmann::json::array();
+    for (int bucket = 0; bucket < Posting_Footprint::length_buckets; ++bucket) {
+        auto const& lists = footprint.by_length[bucket];
+        if (lists.lists > 0) {
+            auto entry = lists.to_json();
+            entry["min_length"] = int64_t{1} << bucket;
+            entry["max_length"] = (int64_t{1} << (bucket + 1)) - 1;
+            list_lengths.push_back(entry);
+        }
+    }
+
+    std::vector<term_id_t> sample;
+    auto sample_count = std::min<int64_t>(sample_size, index.term_count());
+    for (int64_t idx = 0; idx < sample_count; ++idx) {
+        auto term_id = static_cast<term_id_t>(idx * index.term_count() / sample_count);
+        if (index.term_collection_frequency(term_id) > 0) {
+            sample.push_back(term_id);
+        }
+    }
+    int64_t sample_postings = 0;
+    int64_t sample_bytes = 0;
+    for (auto term_id : sample) {
+        sample_postings += index.term_collection_frequency(term_id);
+        sample_bytes += index.documents(term_id).memory().size()
+            + index.frequencies(term_id).memory().size();
+    }
+    std::vector<Encoding_Footprint> encodings;
+    for (auto block_size : block_sizes) {
+        add_encoding<Stream_Vbyte>(encodings, "stream_vbyte", block_size, index, sample);
+        add_encoding<Bitpacking>(encodings, "bitpacking", block_size, index, sample);
+        add_encoding<Vbyte>(encodings, "vbyte", block_size, index, sample);
+    }
+    auto bits = [sample_postings](int64_t bytes) {
+        return sample_postings > 0 ? 8.0 * bytes / sample_postings : 0.0;
+    };
+    nlohmann::json alternatives{{"lists", sample.size()},
+                                {"postings", sample_postings},
+                                {"current_bytes", sample_bytes},
+                                {"current_bits_per_posting", bits(sample_bytes)},
+                                {"encodings", nlohmann::json::array()}};
+    for (auto const& encoding : encodings) {
+        alternatives["encodings"].push_back(
+            {{"codec", encoding.codec},
+             {"block_size", encoding.block_size},
+             {"document_bytes", encoding.document_bytes},
+             {"frequency_bytes", encoding.frequency_bytes},
+             {"document_bits_per_posting", bits(encoding.document_bytes)},
+             {"frequency_bits_per_posting", bits(encoding.frequency_bytes)}});
+    }
+
+    nlohmann::json report{{"sections", sections},
+                          {"postings", postings},
+                          {"list_lengths", list_lengths},
+                          {"alternatives", alternatives}};
+    std::cout << report.dump(2) << std::endl;
+}
+
 template<class PostingListT>
 void print_postings(const PostingListT& postings,
     bool use_titles,
@@ -108,7 +509,7 @@ void print_postings(const PostingListT& postings,
     {
         std::cout << posting.document() << "\t";
         if (use_titles) {
-            std::cout << index.titles().key_at(posting.document()) << "\t";
+            std::cout << index.title(posting.document()) << "\t";
         }
         std::cout << posting.payload() << "\n";
     }
@@ -122,6 +523,11 @@ int main(int argc, char** argv)
     bool use_id = false;
     bool use_titles = false;
     bool stem = false;
+    bool codec_mix = false;
+    double slack = 0.0;
+    bool footprint = false;
+    int64_t sample_size = 1000;
+    std::vector<int32_t> block_sizes = {64, 128, 256};
 
     CLI::App app{"Disects a posting list."};
     app.add_option("-d,--index-dir", dir, "index directory", true)
@@ -131,9 +537,33 @@ int main(int argc, char** argv)
     app.add_flag("--stem", stem, "Stem terems (Porter2)");
     app.add_option(
         "--scores", scoring, "print given scores instead of frequencies", true);
-    app.add_option("term", term, "term to look up", false)->required();
+    app.add_flag("--codec-mix",
+                 codec_mix,
+                 "Report the codecs an adaptive codec would select for all lists "
+                 "and the bytes it would save");
+    app.add_option("--slack",
+                   slack,
+                   "Relative size overhead accepted to use a faster codec (with --codec-mix)",
+                   true);
+    app.add_flag("--footprint",
+                 footprint,
+                 "Report the memory footprint of the index and its lists as JSON");
+    app.add_option("--sample",
+                   sample_size,
+                   "Number of lists re-encoded with other codecs (with --footprint)",
+                   true);
+    app.add_option("--block-sizes",
+                   block_sizes,
+                   "Block sizes of re-encoded lists (with --footprint)",
+                   true);
+    app.add_option("term", term, "term to look up", false);
     CLI11_PARSE(app, argc, argv);
 
+    if (not codec_mix && not footprint && term.empty()) {
+        std::cerr << "Either a term, --codec-mix, or --footprint is required." << std::endl;
+        return 1;
+    }
+
     if (not use_id && stem)
     {
         irk::porter2_stemmer stemmer;
@@ -147,9 +577,21 @@ int main(int argc, char** argv)
         if (scores_defined) {
             scores.push_back(scoring);
         }
+        if (footprint) {
+            scores = irk::index::all_score_names(fs::path{dir});
+        }
         auto data = irtl::value(irk::Inverted_Index_Mapped_Source::from(fs::path{dir}, scores));
         irk::inverted_index_view index(data);
 
+        if (codec_mix) {
+            disect_codec_mix(index, slack);
+            return 0;
+        }
+        if (footprint) {
+            disect_footprint(*data, index, sample_size, block_sizes);
+            return 0;
+        }
+
         term_id_t term_id = use_id ? std::stoi(term) : index.term_id(term).value();
         disect_document_list(index.documents(term_id).memory(),
                              index.term_collection_frequency(term_id));
@@ -30,6 +30,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
 
+#include <irkit/hash_dictionary.hpp>
 #include <irkit/lexicon.hpp>
 #include <irkit/memoryview.hpp>
 
@@ -37,18 +38,24 @@ using boost::iostreams::mapped_file_source;
 
 void run_build(const std::string& input,
     const std::string& output,
-    std::ptrdiff_t keys_per_block)
+    std::ptrdiff_t keys_per_block,
+    bool hash)
 {
-    auto lexicon = irk::build_lexicon(input, keys_per_block);
     std::ofstream out(output);
+    if (hash) {
+        irk::build_hash_dictionary(boost::filesystem::path(input)).serialize(out);
+        return;
+    }
+    auto lexicon = irk::build_lexicon(input, keys_per_block);
     lexicon.serialize(out);
 }
 
-void run_lookup(const std::string& lexicon_file, const std::string& key)
+void run_lookup(const std::string& lexicon_file, const std::string& key, bool hash)
 {
     mapped_file_source m(lexicon_file);
-    auto lex = irk::load_lexicon(irk::make_memory_view(m.data(), m.size()));
-    auto idx = lex.index_at(key);
+    auto memory = irk::make_memory_view(m.data(), m.size());
+    auto idx = hash ? irk::load_hash_dictionary(memory).index_at(key)
+                    : irk::load_lexicon(memory).index_at(key);
     if (idx.has_value()) {
         std::cout << idx.value() << std::endl;
     } else {
@@ -60,6 +67,7 @@ int main(int argc, char** argv)
 {
     std::string input, lexicon_file, string_key;
     std::ptrdiff_t keys_per_block = 128;
+    bool hash = false;
 
     CLI::App app{"Builds a lexicon (string to positional index mapping)."};
     app.require_subcommand(1);
@@ -67,6 +75,9 @@ int main(int argc, char** argv)
     CLI::App* build = app.add_subcommand("build", "Build a lexicon");
     build->add_option(
         "-b,--keys-per-block", keys_per_block, "keys per block", true);
+    build->add_flag("--hash",
+                    hash,
+                    "Build a minimal perfect hash dictionary (lookups only, no iteration)");
     build->add_option("input", input, "input file", false)
         ->check(CLI::ExistingFile)
         ->required();
@@ -79,16 +90,17 @@ int main(int argc, char** argv)
         ->check(CLI::ExistingFile);
     lookup->add_option("string-key", string_key, "A string key to resolve")
         ->required();
+    lookup->add_flag("--hash", hash, "Look up in a hash dictionary");
 
     CLI11_PARSE(app, argc, argv);
 
     if (*lookup) {
-        run_lookup(lexicon_file, string_key);
+        run_lookup(lexicon_file, string_key, hash);
         return 0;
     }
 
     if (*build) {
-        run_build(input, lexicon_file, keys_per_block);
+        run_build(input, lexicon_file, keys_per_block, hash);
         return 0;
     }
 }
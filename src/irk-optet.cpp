@@ -75,10 +75,9 @@ inline void run_query(const Index& index,
         std::begin(acc), std::end(acc), k);
 
     std::vector<irm::trec_result> trec_results;
-    const auto& titles = index.titles();
     int rank = 0;
     for (auto& result : top_results) {
-        auto title = titles.key_at(result.first);
+        auto title = index.title(result.first);
         trec_results.push_back({trecid, "iter", title, rank++, 0.0, "run"});
     }
     irm::annotate_single(trec_results, qrels);
@@ -109,10 +108,10 @@ inline void run_query(const Index& index,
                 std::begin(top.unsorted()),
                 std::end(top.unsorted()),
                 std::back_inserter(trec_results),
-                [&rank, &trecid, &titles](const auto& r) {
+                [&rank, &trecid, &index](const auto& r) {
                     return irm::trec_result{trecid,
                         "iter",
-                        titles.key_at(r.first),
+                        index.title(r.first),
                         rank++,
                         boost::numeric_cast<double>(r.second),
                         "run"};
@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#include <iostream>
+
+#include <CLI/CLI.hpp>
+#include <boost/filesystem.hpp>
+#include <fmt/format.h>
+
+#include <irkit/index.hpp>
+#include <irkit/index/packed.hpp>
+#include <irkit/value.hpp>
+#include "cli.hpp"
+
+using boost::filesystem::path;
+
+void pack(path const& dir, std::uint64_t alignment)
+{
+    auto output = irk::index::packed_index_path(dir);
+    std::cerr << "Packing " << dir << " into " << output << '\n';
+    irk::index::pack_index(dir, output, alignment);
+}
+
+bool verify(path const& dir)
+{
+    auto source = irk::Packed_Index_Source(dir);
+    if (auto result = source.verify(); not result) {
+        std::cerr << dir << ": " << result.error() << '\n';
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::uint64_t alignment = 4096;
+    bool verify_only = false;
+    auto [app, args] = irk::cli::app("Pack index files into a single file",
+                                     irk::cli::index_dir_opt{});
+    app->add_option("-a,--alignment",
+                    alignment,
+                    "Section alignment: 64 for cache lines, page size for "
+                    "per-section madvise/mlock",
+                    true);
+    app->add_flag("--verify", verify_only, "Verify checksums of an existing pack");
+    CLI11_PARSE(*app, argc, argv);
+
+    path dir(args->index_dir);
+    std::vector<path> dirs;
+    if (auto shard_count = irk::index::Properties::read(dir).shard_count;
+        shard_count.has_value()) {
+        for (int32_t shard = 0; shard < *shard_count; ++shard) {
+            dirs.push_back(dir / fmt::format("{:03d}", shard));
+        }
+    } else {
+        dirs.push_back(dir);
+    }
+
+    bool valid = true;
+    for (auto const& index_dir : dirs) {
+        if (verify_only) {
+            valid = verify(index_dir) && valid;
+        } else {
+            pack(index_dir, alignment);
+        }
+    }
+    return valid ? 0 : 1;
+}
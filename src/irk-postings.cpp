@@ -58,7 +58,7 @@ void print_postings(
     for (const auto& posting : postings) {
         std::cout << posting.document() << "\t";
         if (use_titles) {
-            std::cout << index.titles().key_at(posting.document()) << "\t";
+            std::cout << index.title(posting.document()) << "\t";
         }
         std::cout << posting.payload() << "\n";
     }
@@ -85,7 +85,7 @@ void print_postings_multiple(
         .for_each([use_titles, &index](const auto& id, const auto& payload) {
             std::cout << id << "\t";
             if (use_titles) {
-                std::cout << index.titles().key_at(id) << "\t";
+                std::cout << index.title(id) << "\t";
             }
             std::cout << payload << "\n";
         });
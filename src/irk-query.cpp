@@ -35,6 +35,7 @@
 #include <irkit/algorithm/query.hpp>
 #include <irkit/compacttable.hpp>
 #include <irkit/index.hpp>
+#include <irkit/index/packed.hpp>
 #include <irkit/index/source.hpp>
 #include <irkit/parsing/stemmer.hpp>
 #include <irkit/query_engine.hpp>
@@ -64,6 +65,8 @@ int main(int argc, char** argv)
         k_opt{},
         trec_run_opt{},
         trec_id_opt{},
+        warmup_opt{},
+        block_cache_opt{},
         terms_pos{optional});
     CLI11_PARSE(*app, argc, argv);
 
@@ -72,9 +75,25 @@ int main(int argc, char** argv)
     if (Query_Engine::is_quantized(args->score_function)) {
         scores.push_back(args->score_function);
     }
-    auto data = irk::Inverted_Index_Mapped_Source::from(dir, {scores});
-    irk::inverted_index_view index(irtl::value(data));
-    auto const& titles = index.titles();
+    latency_report report;
+    auto open_index = [&](auto data) {
+        report.set_warmup_time(irk::run_with_timer<latency_report::duration>(
+            [&]() { data->warm_up(args->warmup); }));
+        return irk::inverted_index_view(data);
+    };
+    std::shared_ptr<irk::block_cache> cache =
+        args->cache_size > 0 ? args->make_block_cache() : nullptr;
+    std::shared_ptr<irk::Inverted_Index_Disk_Source const> disk_source;
+    if (cache != nullptr) {
+        disk_source = irtl::value(irk::Inverted_Index_Disk_Source::from(dir, cache, scores));
+    }
+    irk::inverted_index_view index = [&]() {
+        if (disk_source != nullptr) { return open_index(disk_source); }
+        if (boost::filesystem::exists(irk::index::packed_index_path(dir))) {
+            return open_index(irtl::value(irk::Packed_Index_Source::from(dir, scores)));
+        }
+        return open_index(irtl::value(irk::Inverted_Index_Mapped_Source::from(dir, scores)));
+    }();
     auto engine = Query_Engine::from(
         index,
         args->nostem,
@@ -84,26 +103,56 @@ int main(int argc, char** argv)
         args->trec_run);
     if (not args->terms.empty())
     {
-        engine.run_query(args->terms, args->k).print([&](int rank, auto document, auto score) {
-            std::string title = titles.key_at(document);
-            std::cout << title << "\t" << score << '\n';
+        report.run([&]() {
+            engine.run_query(args->terms, args->k).print([&](int rank, auto document, auto score) {
+                std::string title = index.title(document);
+                std::cout << title << "\t" << score << '\n';
+            });
         });
     }
     else {
         std::optional<int> trec_id = app->count("--trec-id") > 0u
             ? std::make_optional(args->trec_id)
             : std::nullopt;
-        irk::for_each_query(std::cin, not args->nostem, [&, k = args->k](auto id, auto terms) {
-            engine.run_query(terms, k).print([&, run_id = args->trec_run](
-                                                 int rank, auto document, auto score) {
-                std::string title = titles.key_at(document);
-                if (trec_id.has_value()) {
-                    std::cout << (*trec_id + id) << '\t' << "Q0\t" << title << "\t" << rank << "\t"
-                              << score << "\t" << run_id << "\n";
-                } else {
-                    std::cout << title << "\t" << score << '\n';
-                }
+        auto process = [&, k = args->k](auto id, auto terms) {
+            report.run([&]() {
+                engine.run_query(terms, k).print([&, run_id = args->trec_run](
+                                                     int rank, auto document, auto score) {
+                    std::string title = index.title(document);
+                    if (trec_id.has_value()) {
+                        std::cout << (*trec_id + id) << '\t' << "Q0\t" << title << "\t" << rank
+                                  << "\t" << score << "\t" << run_id << "\n";
+                    } else {
+                        std::cout << title << "\t" << score << '\n';
+                    }
+                });
             });
-        });
+        };
+        if (disk_source != nullptr && args->prefetch > 0) {
+            std::vector<std::vector<std::string>> queries;
+            irk::for_each_query(std::cin, not args->nostem, [&](auto, auto terms) {
+                queries.emplace_back(terms.begin(), terms.end());
+            });
+            irk::block_prefetcher prefetcher;
+            auto prefetch = [&](std::size_t query) {
+                if (query >= queries.size()) { return; }
+                for (auto const& term : queries[query]) {
+                    if (auto term_id = index.term_id(term); term_id.has_value()) {
+                        for (auto const& range : index.posting_ranges(*term_id)) {
+                            disk_source->prefetch(prefetcher, range);
+                        }
+                    }
+                }
+            };
+            for (std::size_t query = 0; query < args->prefetch; ++query) { prefetch(query); }
+            for (std::size_t query = 0; query < queries.size(); ++query) {
+                prefetch(query + args->prefetch);
+                process(static_cast<int>(query), gsl::span<std::string const>(queries[query]));
+            }
+        } else {
+            irk::for_each_query(std::cin, not args->nostem, process);
+        }
     }
+    if (args->latency_report) { report.print(std::cerr); }
+    if (cache != nullptr) { std::cerr << "Block cache: " << cache->statistics() << '\n'; }
 }
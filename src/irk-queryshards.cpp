@@ -32,6 +32,7 @@
 
 #include <irkit/index.hpp>
 #include <irkit/index/cluster.hpp>
+#include <irkit/index/packed.hpp>
 #include <irkit/index/source.hpp>
 #include <irkit/score.hpp>
 #include <irkit/timer.hpp>
@@ -57,6 +58,7 @@ int main(int argc, char** argv)
         k_opt{},
         trec_run_opt{},
         trec_id_opt{},
+        warmup_opt{},
         terms_pos{optional});
     CLI11_PARSE(*app, argc, argv);
 
@@ -65,33 +67,50 @@ int main(int argc, char** argv)
         scores.push_back(args->score_function);
     }
     boost::filesystem::path dir(args->index_dir);
-    auto source = irk::Index_Cluster_Data_Source<irk::Inverted_Index_Mapped_Source>::from(dir,
-                                                                                          scores);
-    irk::Index_Cluster index{source};
+    latency_report report;
+    std::shared_ptr<void const> source;
+    auto open_cluster = [&](auto cluster_source) {
+        source = cluster_source;
+        report.set_warmup_time(irk::run_with_timer<latency_report::duration>(
+            [&]() { cluster_source->warm_up(args->warmup); }));
+        return irk::Index_Cluster{cluster_source};
+    };
+    // Shards packed by irk-pack are each opened as a single mapping.
+    irk::Index_Cluster index =
+        boost::filesystem::exists(irk::index::packed_index_path(dir / "000"))
+        ? open_cluster(irk::Index_Cluster_Data_Source<irk::Packed_Index_Source>::from(dir, scores))
+        : open_cluster(
+              irk::Index_Cluster_Data_Source<irk::Inverted_Index_Mapped_Source>::from(dir, scores));
 
     if (not args->terms.empty()) {
-        irk::run_shards(irk::cli::on_fly(args->score_function),
-                        index,
-                        args->terms,
-                        args->k,
-                        args->score_function,
-                        args->processing_type,
-                        args->trec_id != -1 ? std::make_optional(args->trec_id) : std::nullopt,
-                        args->trec_run);
+        report.run([&]() {
+            irk::run_shards(irk::cli::on_fly(args->score_function),
+                            index,
+                            args->terms,
+                            args->k,
+                            args->score_function,
+                            args->processing_type,
+                            args->trec_id != -1 ? std::make_optional(args->trec_id) : std::nullopt,
+                            args->trec_run);
+        });
     }
     else {
         irk::run_queries(app->count("--trec-id") > 0u ? std::make_optional(args->trec_id)
                                                       : std::nullopt,
                          [&, args = args.get()](const auto& current_trecid, const auto& terms) {
-                             irk::run_shards(irk::cli::on_fly(args->score_function),
-                                             index,
-                                             args->terms,
-                                             args->k,
-                                             args->score_function,
-                                             args->processing_type,
-                                             args->trec_id != -1 ? std::make_optional(args->trec_id)
-                                                                 : std::nullopt,
-                                             args->trec_run);
+                             report.run([&]() {
+                                 irk::run_shards(
+                                     irk::cli::on_fly(args->score_function),
+                                     index,
+                                     args->terms,
+                                     args->k,
+                                     args->score_function,
+                                     args->processing_type,
+                                     args->trec_id != -1 ? std::make_optional(args->trec_id)
+                                                         : std::nullopt,
+                                     args->trec_run);
+                             });
                          });
     }
+    if (args->latency_report) { report.print(std::cerr); }
 }
@@ -148,11 +148,10 @@ print_results(const std::vector<std::pair<index::document_t, Score>>& results,
               std::optional<int> trecid,
               std::string_view run_id)
 {
-    const auto& titles = index.titles();
     int rank = 0;
     for (auto& result : results)
     {
-        std::string title = titles.key_at(result.first);
+        std::string title = index.title(result.first);
         if (trecid.has_value()) {
             std::cout << *trecid << '\t'
                       << "Q0\t"
@@ -255,9 +254,8 @@ inline auto run_shards(const IndexCluster& index,
         auto results = irk::run_query<true>(
             shard_index, query, k, scorer, proctype);
         rescore(results, shard_index, query, global_scorers);
-        const auto& titles = shard_index.titles();
         for (auto&& [doc, score] : results) {
-            auto title = titles.key_at(doc);
+            auto title = shard_index.title(doc);
             acc.accumulate(title, score);
         }
     }
@@ -277,9 +275,8 @@ inline auto run_shards(const IndexCluster& index,
     irk::top_k_accumulator<std::string, Score> acc(k);
     for (const auto& shard_index : index.shards()) {
         auto results       = irk::run_query<false>(shard_index, query, k, scorer, proctype);
-        const auto& titles = shard_index.titles();
         for (auto&& [doc, score] : results) {
-            auto title = titles.key_at(doc);
+            auto title = shard_index.title(doc);
             acc.accumulate(title, score);
         }
     }
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -39,15 +42,17 @@ TEST(lexicon, build_load_verify)
     auto loaded_lex = irk::load_lexicon(irk::make_memory_view(buffer));
     std::vector<std::string> all_keys(loaded_lex.begin(), loaded_lex.end());
 
-    ASSERT_THAT(lexicon.leading_indices_,
-        ::testing::ElementsAreArray(loaded_lex.leading_indices_));
-    ASSERT_THAT(lexicon.block_offsets_,
-        ::testing::ElementsAreArray(loaded_lex.block_offsets_));
-    ASSERT_EQ(lexicon.count_, loaded_lex.count_);
-    ASSERT_EQ(lexicon.keys_per_block_, loaded_lex.keys_per_block_);
+    ASSERT_EQ(lexicon.directory().size(), loaded_lex.directory().size());
+    std::vector<char> loaded_directory(
+        loaded_lex.directory().memory().begin(),
+        loaded_lex.directory().memory().end());
+    ASSERT_THAT(lexicon.directory().memory(),
+        ::testing::ElementsAreArray(loaded_directory));
+    ASSERT_EQ(lexicon.size(), loaded_lex.size());
+    ASSERT_EQ(lexicon.keys_per_block(), loaded_lex.keys_per_block());
     std::vector<char> loaded_blocks(
-        loaded_lex.blocks_.begin(), loaded_lex.blocks_.end());
-    ASSERT_THAT(lexicon.blocks_, ::testing::ElementsAreArray(loaded_blocks));
+        loaded_lex.blocks().begin(), loaded_lex.blocks().end());
+    ASSERT_THAT(lexicon.blocks(), ::testing::ElementsAreArray(loaded_blocks));
 
     int idx = 0;
     auto it = loaded_lex.begin();
@@ -63,6 +68,170 @@ TEST(lexicon, build_load_verify)
     }
 }
 
+//! Writes a lexicon in the format used before block leaders were stored
+//! uncompressed, to make sure such files can still be loaded.
+template<class Lexicon>
+std::vector<char> serialize_legacy(const Lexicon& lexicon)
+{
+    irk::vbyte_codec<std::ptrdiff_t> intcodec;
+    std::vector<std::ptrdiff_t> values{
+        lexicon.size(), lexicon.directory().size(), lexicon.keys_per_block()};
+    for (std::ptrdiff_t block = 0; block < lexicon.directory().size(); ++block)
+    { values.push_back(lexicon.directory().block_offset(block)); }
+    for (std::ptrdiff_t block = 0; block < lexicon.directory().size(); ++block)
+    { values.push_back(block * lexicon.keys_per_block()); }
+
+    std::vector<char> header(values.size() * sizeof(std::ptrdiff_t) * 2);
+    auto header_iter = header.begin();
+    for (const auto& value : values)
+    { std::advance(header_iter, intcodec.encode(&value, header_iter)); }
+    header.resize(std::distance(header.begin(), header_iter));
+    {
+        boost::iostreams::stream<
+            boost::iostreams::back_insert_device<std::vector<char>>>
+            buffer(boost::iostreams::back_inserter(header));
+        const auto& tree =
+            lexicon.codec_.codec().tree().memory_container();
+        std::size_t tree_size = tree.size();
+        buffer.write(reinterpret_cast<char*>(&tree_size), sizeof(tree_size));
+        buffer.write(tree.data(), tree_size);
+        irk::output_bit_stream bout(buffer);
+        irk::prefix_codec<irk::hutucker_codec<char>> encoder(
+            lexicon.codec_.codec());
+        for (std::ptrdiff_t block = 0; block < lexicon.directory().size();
+             ++block) {
+            encoder.encode(
+                std::string(lexicon.directory().leading_key(block)), bout);
+        }
+        bout.flush();
+        buffer.flush();
+    }
+
+    std::ptrdiff_t header_size = header.size() + sizeof(std::ptrdiff_t);
+    std::vector<char> memory(sizeof(header_size));
+    std::memcpy(memory.data(), &header_size, sizeof(header_size));
+    memory.insert(memory.end(), header.begin(), header.end());
+    memory.insert(
+        memory.end(), lexicon.blocks().begin(), lexicon.blocks().end());
+    return memory;
+}
+
+TEST(lexicon, load_legacy)
+{
+    std::string terms_file("terms.txt");
+    std::vector<std::string> lines;
+    irk::io::load_lines(fs::path(terms_file), lines);
+    auto lexicon = irk::build_lexicon(lines, 64);
+
+    auto buffer = serialize_legacy(lexicon);
+    auto loaded_lex = irk::load_lexicon(irk::make_memory_view(buffer));
+    ASSERT_EQ(loaded_lex.size(), lexicon.size());
+    std::vector<char> loaded_directory(
+        loaded_lex.directory().memory().begin(),
+        loaded_lex.directory().memory().end());
+    ASSERT_THAT(lexicon.directory().memory(),
+        ::testing::ElementsAreArray(loaded_directory));
+    for (std::ptrdiff_t idx = 0; idx < lexicon.size(); idx += 7) {
+        ASSERT_EQ(loaded_lex.key_at(idx), lines[idx]);
+        ASSERT_EQ(loaded_lex.index_at(lines[idx]), idx);
+    }
+}
+
+TEST(lexicon, ranges)
+{
+    std::string terms_file("terms.txt");
+    std::vector<std::string> lines;
+    irk::io::load_lines(fs::path(terms_file), lines);
+    auto lexicon = irk::build_lexicon(lines, 64);
+    auto lower_bound = [&lines](const std::string& key) {
+        return std::distance(
+            lines.begin(), std::lower_bound(lines.begin(), lines.end(), key));
+    };
+
+    std::mt19937 gen(17);
+    for (int idx = 0; idx < 2000; ++idx) {
+        const auto& term = lines[gen() % lines.size()];
+        for (std::size_t len = 0; len <= term.size(); ++len) {
+            auto prefix = term.substr(0, len);
+            auto [first, last] = lexicon.prefix_range(prefix);
+            ASSERT_EQ(first, lower_bound(prefix)) << prefix;
+            ASSERT_LT(first, last) << prefix;
+            ASSERT_EQ(lines[first].compare(0, len, prefix), 0) << prefix;
+            ASSERT_EQ(lines[last - 1].compare(0, len, prefix), 0) << prefix;
+            if (last < static_cast<std::ptrdiff_t>(lines.size())) {
+                ASSERT_NE(lines[last].compare(0, len, prefix), 0) << prefix;
+            }
+        }
+        auto missing = term + "~missing";
+        ASSERT_EQ(lexicon.lower_bound(missing), lower_bound(missing));
+    }
+    ASSERT_EQ(lexicon.prefix_range("").second, lexicon.size());
+    ASSERT_EQ(lexicon.lower_bound(lines.back() + "z"), lexicon.size());
+
+    auto [first, last] = lexicon.range(lines[100], lines[1000]);
+    ASSERT_EQ(first, 100);
+    ASSERT_EQ(last, 1000);
+    auto [empty_first, empty_last] = lexicon.range(lines[1000], lines[100]);
+    ASSERT_EQ(empty_first, empty_last);
+}
+
+TEST(lexicon, parallel_build)
+{
+    std::string terms_file("terms.txt");
+    std::vector<std::string> lines;
+    irk::io::load_lines(fs::path(terms_file), lines);
+    for (int keys_per_block : {7, 64}) {
+        // Single-pass iterators are encoded sequentially.
+        std::ifstream keys(terms_file);
+        std::ifstream corpus(terms_file);
+        auto sequential = irk::build_lexicon(irk::io::line_iterator(keys),
+            irk::io::line_iterator(),
+            irk::io::line_iterator(corpus),
+            irk::io::line_iterator(),
+            keys_per_block);
+        auto parallel = irk::build_lexicon(lines, keys_per_block);
+        ASSERT_EQ(parallel.size(), sequential.size());
+        ASSERT_THAT(parallel.directory().memory(),
+            ::testing::ElementsAreArray(sequential.directory().memory()));
+        ASSERT_THAT(parallel.blocks(),
+            ::testing::ElementsAreArray(sequential.blocks()));
+    }
+}
+
+TEST(lexicon, batch_lookup)
+{
+    std::string terms_file("terms.txt");
+    std::vector<std::string> lines;
+    irk::io::load_lines(fs::path(terms_file), lines);
+    auto lexicon = irk::build_lexicon(lines, 64);
+
+    std::mt19937 gen(17);
+    std::vector<std::string> keys;
+    std::vector<std::optional<std::ptrdiff_t>> expected;
+    for (int idx = 0; idx < 10000; ++idx) {
+        std::ptrdiff_t pos = gen() % lines.size();
+        keys.push_back(lines[pos]);
+        expected.push_back(pos);
+        if (idx % 10 == 0) {
+            keys.push_back(lines[pos] + "~missing");
+            expected.push_back(std::nullopt);
+        }
+    }
+    keys.push_back("");
+    expected.push_back(std::nullopt);
+    keys.push_back(lines.back());
+    expected.push_back(lines.size() - 1);
+    keys.push_back(lines.back() + "z");
+    expected.push_back(std::nullopt);
+
+    auto indices = lexicon.indices_at(keys);
+    ASSERT_EQ(indices.size(), keys.size());
+    for (std::size_t idx = 0; idx < keys.size(); ++idx) {
+        ASSERT_EQ(indices[idx], expected[idx]) << keys[idx];
+        ASSERT_EQ(indices[idx], lexicon.index_at(keys[idx])) << keys[idx];
+    }
+}
+
 TEST(prefix_map, build_load_verify)
 {
     std::string terms_file("terms.txt");
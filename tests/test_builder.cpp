@@ -156,7 +156,7 @@ TEST_F(IndexBuilderWrite, write_document_ids)
         encode(vb, {9, 1024, 1, 0}), encode(svb, {0_id}), encode(svb, {0_id})
     });
     std::vector<char> expected_off =
-        irk::build_offset_table<>({0, 10, 19}).data_;
+        irk::build_elias_fano_table<std::size_t>({0, 10, 19}).data_;
     EXPECT_THAT(actual_out, ::testing::ElementsAreArray(expected_out));
     EXPECT_THAT(actual_off, ::testing::ElementsAreArray(expected_off));
 }
@@ -177,7 +177,7 @@ TEST_F(IndexBuilderWrite, write_document_counts)
         encode(vb, {7, 1024, 1, 0}), encode(svb, {1}),
         encode(vb, {7, 1024, 1, 0}), encode(svb, {2})
     });
-    std::vector<char> expected_off = irk::build_offset_table<>({0, 8, 15}).data_;
+    std::vector<char> expected_off = irk::build_elias_fano_table<std::size_t>({0, 8, 15}).data_;
     EXPECT_THAT(actual_out, ::testing::ElementsAreArray(expected_out));
     EXPECT_THAT(actual_off, ::testing::ElementsAreArray(expected_off));
 }
@@ -220,6 +220,38 @@ TEST_F(IndexBuilderWrite, write_term_occurrences)
     EXPECT_EQ(occurrences[2], 2);
 }
 
+TEST(IndexBuilder, write_document_counts_reuses_partition)
+{
+    ir::Block_List_Options options{};
+    options.variable_blocks = true;
+    irk::index_builder builder(4, options);
+    for (int doc = 0; doc < 200; ++doc) {
+        builder.add_document(doc);
+        builder.add_term("a");
+        if (doc % 3 == 0) { builder.add_term("b"); }
+        if (doc % 50 == 0) { builder.add_term("c"); }
+    }
+
+    std::stringstream standalone_out;
+    std::stringstream standalone_off;
+    builder.write_document_counts(standalone_out, standalone_off);
+    ASSERT_TRUE(builder.block_ends_.empty());
+
+    std::stringstream doc_out;
+    std::stringstream doc_off;
+    builder.write_document_ids(doc_out, doc_off);
+    ASSERT_EQ(builder.block_ends_.size(), builder.term_count());
+    for (auto const& block_ends : builder.block_ends_) {
+        EXPECT_FALSE(block_ends.empty());
+    }
+
+    std::stringstream out;
+    std::stringstream off;
+    builder.write_document_counts(out, off);
+    EXPECT_EQ(out.str(), standalone_out.str());
+    EXPECT_EQ(off.str(), standalone_off.str());
+}
+
 }  // namespace
 
 int main(int argc, char** argv)
@@ -12,6 +12,7 @@
 #include <irkit/coding.hpp>
 #include <irkit/coding/huffman.hpp>
 #include <irkit/coding/hutucker.hpp>
+#include <irkit/coding/prefix_codec.hpp>
 #include <irkit/coding/vbyte.hpp>
 
 namespace {
@@ -345,6 +346,67 @@ TEST_F(HuTucker, with_frequencies_signed)
     EXPECT_THAT(decode_sink.str(), ::testing::ElementsAreArray(content));
 }
 
+TEST_F(HuTucker, memory_decode)
+{
+    // Skewed frequencies so that rare symbols get codes longer than the
+    // decoding table resolves in one lookup.
+    std::vector<std::size_t> frequencies(256, 0);
+    for (std::size_t symbol = 0; symbol < 256; ++symbol) {
+        frequencies[symbol] = symbol % 7 == 0 ? 1 : (symbol % 5 + 1) * 1000;
+    }
+    irk::hutucker_codec<char> codec(frequencies);
+
+    std::mt19937 gen(11);
+    std::string content;
+    for (int idx = 0; idx < 5000; ++idx) {
+        content.push_back(static_cast<char>(gen() % 256));
+    }
+
+    std::ostringstream encode_string_sink;
+    irk::output_bit_stream encode_sink(encode_string_sink);
+    codec.encode(content.begin(), content.end(), encode_sink);
+    encode_sink.flush();
+    std::string encoded = encode_string_sink.str();
+
+    irk::memory_bit_stream source(encoded.data(), encoded.size());
+    std::string decoded;
+    codec.decode(source, decoded, content.size());
+    EXPECT_EQ(decoded, content);
+
+    irk::memory_bit_stream truncated(encoded.data(), 1);
+    EXPECT_THROW(codec.decode(truncated, decoded, content.size()),
+                 std::runtime_error);
+}
+
+TEST_F(HuTucker, prefix_memory_decode)
+{
+    std::vector<std::string> values{
+        "a", "abc", "abcdef", "abd", "b", "ba", "banana", "bandana", "c"};
+    std::vector<std::size_t> frequencies(256, 1);
+    irk::prefix_codec<irk::hutucker_codec<char>> codec(
+        irk::hutucker_codec<char>{frequencies});
+
+    std::ostringstream encode_string_sink;
+    irk::output_bit_stream encode_sink(encode_string_sink);
+    for (const auto& value : values) { codec.encode(value, encode_sink); }
+    encode_sink.flush();
+    std::string encoded = encode_string_sink.str();
+
+    codec.reset();
+    irk::memory_bit_stream view_source(encoded.data(), encoded.size());
+    for (const auto& value : values) {
+        EXPECT_EQ(codec.decode(view_source), value);
+    }
+
+    codec.reset();
+    irk::memory_bit_stream string_source(encoded.data(), encoded.size());
+    std::string decoded;
+    for (const auto& value : values) {
+        codec.decode(string_source, decoded);
+        EXPECT_EQ(decoded, value);
+    }
+}
+
 }  // namespace
 
 int main(int argc, char** argv)
@@ -25,6 +25,7 @@
 //! \copyright MIT License
 
 #include <algorithm>
+#include <fstream>
 #include <gsl/span>
 #include <random>
 #include <sstream>
@@ -106,6 +107,68 @@ TEST_F(span_memory_source, slice)
     test_slices(view, container);
 }
 
+TEST_F(span_memory_source, range_does_not_reference_source)
+{
+    auto range = view.range(1, 3);
+    EXPECT_EQ(view.self_, nullptr);
+    EXPECT_EQ(range.self_, nullptr);
+    EXPECT_EQ(range.data(), container.data() + 1);
+}
+
+class shared_memory_source : public ::testing::Test {
+protected:
+    std::vector<char> container = {4, 2, 1, 4, 6};
+    irk::memory_view view = irk::memory_view(irk::shared_memory_source(
+        std::make_shared<const std::vector<char>>(container)));
+};
+
+TEST_F(shared_memory_source, size)
+{
+    test_size(view, container);
+}
+
+TEST_F(shared_memory_source, iterator)
+{
+    test_iterator(view, container);
+}
+
+TEST_F(shared_memory_source, slice)
+{
+    test_slices(view, container);
+}
+
+TEST_F(shared_memory_source, range_shares_source)
+{
+    auto range = view.range(1, 3);
+    EXPECT_EQ(range.self_, view.self_);
+    EXPECT_EQ(range.data(), view.data() + 1);
+}
+
+TEST(memory_view, default_is_empty)
+{
+    irk::memory_view view;
+    EXPECT_EQ(view.size(), 0);
+    EXPECT_EQ(view.begin(), view.end());
+}
+
+TEST(memory_view, indirect_source)
+{
+    std::vector<char> container = {4, 2, 1, 4, 6};
+    auto path = boost::filesystem::temp_directory_path()
+        / boost::filesystem::unique_path();
+    {
+        std::ofstream out(path.c_str());
+        out.write(container.data(), container.size());
+    }
+    irk::memory_view view{irk::disk_memory_source<char>(path)};
+    EXPECT_FALSE(view.contiguous_);
+    test_size(view, container);
+    test_iterator(view, container);
+    test_slices(view, container);
+    EXPECT_EQ(view[3], 4);
+    boost::filesystem::remove(path);
+}
+
 //class disk_memory_source : public ::testing::Test {
 //protected:
 //    std::vector<char> container = {4, 2, 1, 4, 6};
@@ -0,0 +1,312 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#define CATCH_CONFIG_MAIN
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <catch2/catch.hpp>
+
+#include <irkit/arena.hpp>
+#include <irkit/coding/adaptive.hpp>
+#include <irkit/coding/bitpacking.hpp>
+#include <irkit/index/source.hpp>
+#include <irkit/list/arena_block_list.hpp>
+#include <irkit/list/standard_block_list.hpp>
+#include <irkit/query_engine.hpp>
+
+#include "common.hpp"
+
+namespace {
+
+std::atomic<std::int64_t> allocations{0};
+std::atomic<std::int64_t> aligned_allocations{0};
+
+}  // namespace
+
+// Replacements of both the regular and aligned (used by arena chunks) forms.
+// Deallocation is kept out of line, so that the compiler does not match
+// inlined `free` calls against `new` expressions.
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    ++allocations;
+    ++aligned_allocations;
+    auto align = static_cast<std::size_t>(alignment);
+    auto aligned_size = std::max(align, (size + align - 1) / align * align);
+    if (void* ptr = std::aligned_alloc(align, aligned_size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t /* size */) noexcept
+{
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::align_val_t /* alignment */) noexcept
+{
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void
+operator delete(void* ptr, std::size_t /* size */, std::align_val_t /* alignment */) noexcept
+{
+    std::free(ptr);
+}
+
+using ir::Arena;
+using ir::Arena_Block_List;
+using ir::Block_List_Options;
+using ir::Standard_Block_List;
+using ir::Standard_Block_List_Builder;
+
+template<class Builder, class Values>
+auto write(Builder builder, Values const& values)
+{
+    for (auto v : values) {
+        builder.add(v);
+    }
+    std::ostringstream os;
+    builder.write(os);
+    return os.str();
+}
+
+TEST_CASE("Arena", "[arena]")
+{
+    Arena arena(1024);
+    auto first = arena.allocate<char>(3);
+    auto second = arena.allocate<int>(10, 7);
+    auto large = arena.allocate<std::int64_t>(1000);
+    for (auto ptr : {static_cast<void*>(first.data()),
+                     static_cast<void*>(second.data()),
+                     static_cast<void*>(large.data())}) {
+        REQUIRE(reinterpret_cast<std::uintptr_t>(ptr) % Arena::alignment == 0);
+    }
+    REQUIRE(std::all_of(second.begin(), second.end(), [](int v) { return v == 7; }));
+    REQUIRE(arena.used() == 64 + 64 + 8000);
+    auto capacity = arena.capacity();
+
+    arena.reset();
+    REQUIRE(arena.used() == 0);
+    REQUIRE(arena.allocate<char>(3).data() == first.data());
+    REQUIRE(arena.allocate<std::int64_t>(1000).data() == large.data());
+    REQUIRE(arena.capacity() == capacity);
+
+    auto before = aligned_allocations.load();
+    REQUIRE(arena.allocate<std::int64_t>(1000).size() == 1000);
+    REQUIRE(aligned_allocations.load() == before + 1);
+}
+
+TEST_CASE("Arena_Block_List", "[arena][blocked][inverted_list]")
+{
+    using codec_type = irk::adaptive_codec<int, irk::vbyte_codec<int>, irk::bitpacking_codec<int>>;
+    std::vector<int> sparse_documents;
+    std::vector<int> dense_documents;
+    std::vector<int> payloads;
+    for (int doc = 0; doc < 5000; ++doc) {
+        sparse_documents.push_back(doc * 37 + doc % 5);
+        payloads.push_back(doc % 13);
+        if (doc % 3 != 0) {
+            dense_documents.push_back(doc);
+        }
+    }
+    auto fixed_width = GENERATE(false, true);
+    auto variable_blocks = GENERATE(false, true);
+    Block_List_Options options{0.0, fixed_width, variable_blocks};
+    Block_List_Options bitmap_options{0.125, fixed_width, variable_blocks};
+    Standard_Block_List_Builder<int, codec_type, false> payload_builder{64, options};
+    if (variable_blocks) {
+        Standard_Block_List_Builder<int, codec_type, true> sparse_builder{64, options};
+        for (auto doc : sparse_documents) {
+            sparse_builder.add(doc);
+        }
+        payload_builder.set_partition(sparse_builder.partition());
+    }
+    auto sparse = write(Standard_Block_List_Builder<int, codec_type, true>{64, options},
+                        sparse_documents);
+    Standard_Block_List_Builder<int, codec_type, true> dense_builder{64, bitmap_options};
+    dense_builder.set_document_count(5000);
+    auto dense = write(dense_builder, dense_documents);
+    auto payload = write(payload_builder, payloads);
+    auto sparse_memory = irk::make_memory_view(sparse.data(), sparse.size());
+    auto dense_memory = irk::make_memory_view(dense.data(), dense.size());
+    auto payload_memory = irk::make_memory_view(payload.data(), payload.size());
+
+    Arena arena;
+    auto open = [&]() {
+        return std::make_tuple(
+            Arena_Block_List<int, codec_type, true>(0, sparse_memory, sparse_documents.size(), arena),
+            Arena_Block_List<int, codec_type, true>(1, dense_memory, dense_documents.size(), arena),
+            Arena_Block_List<int, codec_type, false>(0, payload_memory, payloads.size(), arena));
+    };
+
+    SECTION("Same values as Standard_Block_List")
+    {
+        auto [sparse_list, dense_list, payload_list] = open();
+        REQUIRE(dense_list.is_bitmap());
+        REQUIRE(sparse_list.is_fixed_width() == fixed_width);
+        REQUIRE(sparse_list.has_variable_blocks() == variable_blocks);
+        REQUIRE(payload_list.has_variable_blocks() == variable_blocks);
+        REQUIRE(std::vector<int>(sparse_list.begin(), sparse_list.end()) == sparse_documents);
+        REQUIRE(std::vector<int>(dense_list.begin(), dense_list.end()) == dense_documents);
+        REQUIRE(std::vector<int>(payload_list.begin(), payload_list.end()) == payloads);
+
+        Standard_Block_List<int, codec_type, true> standard_list{
+            0, sparse_memory, static_cast<std::int32_t>(sparse_documents.size())};
+        REQUIRE(std::equal(sparse_list.upper_bounds().begin(),
+                           sparse_list.upper_bounds().end(),
+                           standard_list.upper_bounds().begin(),
+                           standard_list.upper_bounds().end()));
+        REQUIRE(std::equal(sparse_list.block_ends().begin(),
+                           sparse_list.block_ends().end(),
+                           standard_list.block_ends().begin(),
+                           standard_list.block_ends().end()));
+        auto doc = GENERATE(0, 1, 38, 1000, 184990, 185000);
+        auto it = sparse_list.lookup(doc);
+        auto expected = std::lower_bound(sparse_documents.begin(), sparse_documents.end(), doc);
+        if (expected == sparse_documents.end()) {
+            REQUIRE(it == sparse_list.end());
+        } else {
+            REQUIRE(*it == *expected);
+            auto payload_it = payload_list.begin();
+            payload_it.align(it);
+            REQUIRE(*payload_it == payloads[std::distance(sparse_documents.begin(), expected)]);
+        }
+    }
+
+    SECTION("No heap allocations once the arena has grown")
+    {
+        auto query = [&]() {
+            auto [sparse_list, dense_list, payload_list] = open();
+            std::int64_t sum = 0;
+            auto payload_it = payload_list.begin();
+            for (auto it = dense_list.begin(); it != dense_list.end(); ++it) {
+                auto sparse_it = sparse_list.lookup(*it);
+                if (sparse_it != sparse_list.end() && *sparse_it == *it) {
+                    sum += *payload_it.align(sparse_it);
+                }
+            }
+            arena.reset();
+            return sum;
+        };
+        auto expected = query();
+        auto before = allocations.load();
+        auto sum = query();
+        auto after = allocations.load();
+        REQUIRE(sum == expected);
+        REQUIRE(after == before);
+    }
+}
+
+TEST_CASE("Query_Engine reads postings through the arena", "[arena][query_engine]")
+{
+    auto score_function = GENERATE(std::string("bm25"), std::string("bm25-8"));
+    auto traversal = GENERATE(irk::Traversal_Type::TAAT, irk::Traversal_Type::DAAT);
+
+    auto dir = irk::test::tmpdir();
+    std::ostringstream documents;
+    for (int doc = 0; doc < 20000; ++doc) {
+        documents << "Doc" << doc << " common";
+        if (doc % 2 == 0) {
+            documents << " even";
+        }
+        if (doc % 1000 == 0) {
+            documents << " rare";
+        }
+        if (doc % 1000 == 500) {
+            documents << " scarce";
+        }
+        documents << '\n';
+    }
+    std::istringstream input(documents.str());
+    irk::index::index_assembler assembler(dir, 5000, 64, 16);
+    assembler.assemble(input);
+    irk::index::score_index<irk::score::bm25_tag, irk::Inverted_Index_Mapped_Source>(dir, 8);
+
+    std::vector<std::string> scores;
+    if (irk::Query_Engine::is_quantized(score_function)) {
+        scores.push_back(score_function);
+    }
+    irk::inverted_index_view index{
+        irk::Inverted_Index_Mapped_Source::from(dir, scores).value()};
+    auto engine = irk::Query_Engine::from(
+        index, true, score_function, traversal, std::optional<int>{}, "null");
+
+    std::vector<std::string> short_query{"rare", "scarce"};
+    std::vector<std::string> long_query{"common", "even"};
+    auto count_allocations = [&](std::vector<std::string> const& query) {
+        auto before = allocations.load();
+        auto results = engine.run_query(query, 10);
+        auto after = allocations.load();
+        std::vector<int> docs;
+        results.print([&](auto /* rank */, auto doc, auto /* score */) { docs.push_back(doc); });
+        REQUIRE(docs.size() == 10);
+        return after - before;
+    };
+
+    // The first query grows the thread's arena to fit the longest lists.
+    count_allocations(long_query);
+    REQUIRE(ir::thread_arena().used() == 0);
+    REQUIRE(count_allocations(short_query) == count_allocations(long_query));
+    REQUIRE(ir::thread_arena().used() == 0);
+
+    // The lists the engine opens for each query term are decoded without
+    // touching the heap; what remains above is independent of list length.
+    auto term_ids = index.term_ids(long_query);
+    auto& arena = ir::thread_arena();
+    auto before = allocations.load();
+    std::int64_t postings = 0;
+    for (auto const& term_id : term_ids) {
+        if (irk::Query_Engine::is_quantized(score_function)) {
+            for (auto const& posting : index.scored_postings(term_id, arena)) {
+                postings += posting.payload() >= 0 ? 1 : 0;
+            }
+        } else {
+            for (auto const& posting : index.postings(term_id, arena)) {
+                postings += posting.payload() > 0 ? 1 : 0;
+            }
+        }
+    }
+    arena.reset();
+    auto after = allocations.load();
+    REQUIRE(postings == 20000 + 10000);
+    REQUIRE(after == before);
+}
@@ -0,0 +1,180 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <irkit/block_cache.hpp>
+#include <irkit/memoryview.hpp>
+#include <irkit/prefetch.hpp>
+
+namespace {
+
+class block_cache : public ::testing::Test {
+protected:
+    boost::filesystem::path file_path =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    std::vector<char> content{};
+
+    void SetUp() override
+    {
+        std::mt19937 gen(17);
+        std::uniform_int_distribution<int> byte(0, 255);
+        content.resize(10'000);
+        for (auto& ch : content) { ch = static_cast<char>(byte(gen)); }
+        std::ofstream out(file_path.c_str(), std::ios::binary);
+        out.write(content.data(), content.size());
+    }
+
+    void TearDown() override { boost::filesystem::remove(file_path); }
+
+    auto expected(std::ptrdiff_t first, std::ptrdiff_t size) const
+    {
+        return std::vector<char>(content.begin() + first, content.begin() + first + size);
+    }
+};
+
+std::vector<char> to_vector(irk::memory_view const& view)
+{
+    return std::vector<char>(view.begin(), view.end());
+}
+
+TEST_F(block_cache, ranges)
+{
+    auto cache = std::make_shared<irk::block_cache>(4096, 256, 2);
+    auto file = std::make_shared<irk::cached_file const>(file_path, cache);
+    irk::memory_view view(irk::cached_file_memory_source{file});
+    ASSERT_EQ(view.size(), 10'000);
+    for (auto [first, size] : std::vector<std::pair<int, int>>{
+             {0, 0}, {0, 10}, {250, 6}, {250, 7}, {100, 2000}, {9'990, 10}}) {
+        auto range = view.range(first, size);
+        ASSERT_EQ(to_vector(range), expected(first, size));
+        if (size > 2) {
+            ASSERT_EQ(to_vector(range.range(1, size - 2)), expected(first + 1, size - 2));
+        }
+    }
+    ASSERT_EQ(to_vector(view), content);
+}
+
+TEST_F(block_cache, single_block_ranges_share_memory)
+{
+    auto cache = std::make_shared<irk::block_cache>(4096, 256, 2);
+    auto file = std::make_shared<irk::cached_file const>(file_path, cache);
+    irk::memory_view view(irk::cached_file_memory_source{file});
+    auto first = view.range(300, 10);
+    auto second = view.range(310, 20);
+    ASSERT_EQ(first.data() + 10, second.data());
+    auto stats = cache->statistics();
+    ASSERT_EQ(stats.misses, 1);
+    ASSERT_EQ(stats.hits, 1);
+}
+
+TEST_F(block_cache, bounded_capacity)
+{
+    auto cache = std::make_shared<irk::block_cache>(1024, 256, 1);
+    ASSERT_EQ(cache->capacity(), 1024);
+    auto file = std::make_shared<irk::cached_file const>(file_path, cache);
+    irk::memory_view view(irk::cached_file_memory_source{file});
+    // Blocks 0 and 1 are hit, so the clock passes over them when evicting.
+    for (int block : {0, 1, 2, 3, 0, 1, 4, 5, 0, 1}) {
+        ASSERT_EQ(to_vector(view.range(block * 256, 256)), expected(block * 256, 256));
+    }
+    auto stats = cache->statistics();
+    ASSERT_EQ(stats.misses, 6);
+    ASSERT_EQ(stats.hits, 4);
+    ASSERT_EQ(stats.evictions, 2);
+    ASSERT_DOUBLE_EQ(stats.hit_rate(), 0.4);
+}
+
+TEST_F(block_cache, evicted_blocks_stay_valid)
+{
+    auto cache = std::make_shared<irk::block_cache>(256, 256, 1);
+    auto file = std::make_shared<irk::cached_file const>(file_path, cache);
+    irk::memory_view view(irk::cached_file_memory_source{file});
+    auto first = view.range(0, 100);
+    auto second = view.range(5000, 100);
+    ASSERT_EQ(cache->statistics().evictions, 1);
+    ASSERT_EQ(to_vector(first), expected(0, 100));
+    ASSERT_EQ(to_vector(second), expected(5000, 100));
+}
+
+TEST_F(block_cache, concurrent_reads)
+{
+    auto cache = std::make_shared<irk::block_cache>(2048, 128, 4);
+    auto file = std::make_shared<irk::cached_file const>(file_path, cache);
+    irk::memory_view view(irk::cached_file_memory_source{file});
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (int thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&, thread]() {
+            std::mt19937 gen(thread);
+            std::uniform_int_distribution<int> offset(0, 9'000);
+            for (int idx = 0; idx < 1000; ++idx) {
+                auto first = offset(gen);
+                if (to_vector(view.range(first, 300)) != expected(first, 300)) {
+                    ++failures[thread];
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+    ASSERT_THAT(failures, ::testing::Each(0));
+}
+
+TEST_F(block_cache, prefetch)
+{
+    auto cache = std::make_shared<irk::block_cache>(1 << 20, 256, 4);
+    auto file = std::make_shared<irk::cached_file const>(file_path, cache);
+    irk::memory_view view(irk::cached_file_memory_source{file});
+    {
+        irk::block_prefetcher prefetcher(4, 2);
+        prefetcher.prefetch(file, 100, 2000);
+        prefetcher.prefetch(file, 9'000, 1'000);
+        prefetcher.wait();
+    }
+    auto stats = cache->statistics();
+    ASSERT_EQ(stats.prefetched, 9 + 5);
+    ASSERT_EQ(stats.misses, 0);
+    ASSERT_EQ(to_vector(view.range(100, 2000)), expected(100, 2000));
+    ASSERT_EQ(to_vector(view.range(9'000, 1'000)), expected(9'000, 1'000));
+    stats = cache->statistics();
+    ASSERT_EQ(stats.misses, 0);
+    ASSERT_EQ(stats.hits, 9 + 5);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
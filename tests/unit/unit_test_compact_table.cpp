@@ -26,12 +26,14 @@
 
 #include <algorithm>
 #include <random>
+#include <sstream>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <irkit/compacttable.hpp>
+#include <irkit/memoryview.hpp>
 
 namespace {
 
@@ -113,6 +115,77 @@ TEST(offset_table, to_vector_equal_count_and_block)
     ASSERT_THAT(vec, ::testing::ElementsAreArray(values));
 }
 
+std::vector<std::size_t> sorted_values(int count, std::size_t max)
+{
+    std::default_random_engine generator(127);
+    std::uniform_int_distribution<std::size_t> distribution(0, max);
+    std::vector<std::size_t> values;
+    values.reserve(count);
+    std::generate_n(std::back_inserter(values), count, [&]() {
+        return distribution(generator);
+    });
+    std::sort(std::begin(values), std::end(values));
+    return values;
+}
+
+TEST(elias_fano_table, random_access)
+{
+    for (std::size_t max : {std::size_t{0}, std::size_t{100}, std::size_t{12'148'409'321}}) {
+        for (int count : {0, 1, 63, 64, 65, 10000}) {
+            auto values = sorted_values(count, max);
+            auto table = irk::build_elias_fano_table(values);
+            ASSERT_TRUE(table.is_random_access());
+            ASSERT_EQ(table.header()->flags, irk::CompactTableHeaderFlags::EliasFano);
+            ASSERT_EQ(table.size(), values.size());
+            for (int idx = 0; idx < count; ++idx) {
+                ASSERT_EQ(table[idx], values[idx]);
+            }
+            ASSERT_THAT(table.to_vector(), ::testing::ElementsAreArray(values));
+        }
+    }
+}
+
+TEST(elias_fano_table, memory_view)
+{
+    auto values = sorted_values(10000, std::numeric_limits<std::int32_t>::max());
+    std::ostringstream os;
+    os << irk::build_elias_fano_table(values);
+    auto buffer = os.str();
+    irk::compact_table<std::size_t, irk::vbyte_codec<std::size_t>, irk::memory_view> table(
+        irk::make_memory_view(buffer.data(), buffer.size()));
+    for (int idx = 0; idx < 10000; ++idx) {
+        ASSERT_EQ(table[idx], values[idx]);
+    }
+}
+
+TEST(elias_fano_table, unsorted_falls_back_to_packed)
+{
+    std::vector<std::size_t> values = {5, 3, 12'148'409'321, 0};
+    auto table = irk::build_elias_fano_table(values);
+    ASSERT_EQ(table.header()->flags, irk::CompactTableHeaderFlags::BitPacked);
+    ASSERT_THAT(table.to_vector(), ::testing::ElementsAreArray(values));
+}
+
+TEST(packed_table, random_access)
+{
+    std::default_random_engine generator(17);
+    for (int width : {0, 1, 7, 31}) {
+        std::uniform_int_distribution<std::int32_t> distribution(
+            -1000, -1000 + static_cast<std::int32_t>((std::int64_t{1} << width) - 1));
+        std::vector<std::int32_t> values;
+        std::generate_n(std::back_inserter(values), 1000, [&]() {
+            return distribution(generator);
+        });
+        auto table = irk::build_packed_table(values);
+        ASSERT_TRUE(table.is_random_access());
+        for (int idx = 0; idx < 1000; ++idx) {
+            ASSERT_EQ(table[idx], values[idx]);
+        }
+        std::vector<std::int32_t> iterated(table.begin(), table.end());
+        ASSERT_THAT(iterated, ::testing::ElementsAreArray(values));
+    }
+}
+
 }  // namespace
 
 int main(int argc, char** argv)
@@ -0,0 +1,121 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <irkit/hash_dictionary.hpp>
+#include <irkit/memoryview.hpp>
+
+namespace {
+
+std::vector<std::string> random_keys(int count, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> length(1, 20);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::unordered_set<std::string> unique;
+    std::vector<std::string> keys;
+    while (static_cast<int>(keys.size()) < count) {
+        std::string key(length(gen), ' ');
+        for (auto& ch : key) { ch = static_cast<char>(letter(gen)); }
+        if (unique.insert(key).second) { keys.push_back(key); }
+    }
+    return keys;
+}
+
+TEST(hash_dictionary, finds_all_keys)
+{
+    for (int count : {1, 2, 10, 1000, 50000}) {
+        auto keys = random_keys(count, count);
+        auto dictionary = irk::build_hash_dictionary(keys);
+        ASSERT_EQ(dictionary.size(), count);
+        for (int idx = 0; idx < count; ++idx) {
+            ASSERT_EQ(dictionary.index_at(keys[idx]), std::make_optional(idx));
+        }
+    }
+}
+
+TEST(hash_dictionary, rejects_missing_keys)
+{
+    auto keys = random_keys(1000, 7);
+    auto dictionary = irk::build_hash_dictionary(keys);
+    std::unordered_set<std::string> present(keys.begin(), keys.end());
+    for (const auto& key : random_keys(1000, 8)) {
+        if (present.count(key) == 0) {
+            ASSERT_EQ(dictionary.index_at(key), std::nullopt);
+        }
+    }
+    ASSERT_EQ(dictionary.index_at(""), std::nullopt);
+}
+
+TEST(hash_dictionary, empty)
+{
+    auto dictionary = irk::build_hash_dictionary(std::vector<std::string>{});
+    ASSERT_EQ(dictionary.size(), 0);
+    ASSERT_EQ(dictionary.index_at("key"), std::nullopt);
+}
+
+TEST(hash_dictionary, duplicate_keys)
+{
+    std::vector<std::string> keys = {"a", "b", "a"};
+    ASSERT_THROW(irk::build_hash_dictionary(keys), std::invalid_argument);
+}
+
+TEST(hash_dictionary, memory_view)
+{
+    auto keys = random_keys(5000, 11);
+    std::ostringstream out;
+    irk::build_hash_dictionary(keys).serialize(out);
+    std::string buffer = out.str();
+    std::vector<char> memory(buffer.begin(), buffer.end());
+    auto dictionary = irk::load_hash_dictionary(irk::make_memory_view(memory));
+    for (int idx = 0; idx < static_cast<int>(keys.size()); ++idx) {
+        ASSERT_EQ(dictionary.index_at(keys[idx]), std::make_optional(idx));
+    }
+}
+
+TEST(hash_dictionary, truncated)
+{
+    auto dictionary = irk::build_hash_dictionary(random_keys(100, 3));
+    const auto& memory = dictionary.memory();
+    ASSERT_THROW(irk::load_hash_dictionary(irk::make_memory_view(
+                     memory.data(), memory.size() - 8)),
+                 std::runtime_error);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -95,6 +95,7 @@ TEST_F(PropertiesTest, read)
     auto deserialized = irk::index::Properties::read(index_dir);
 
     // then
+    EXPECT_EQ(deserialized.version, 1);
     EXPECT_EQ(deserialized.skip_block_size, properties.skip_block_size);
     EXPECT_EQ(deserialized.occurrences_count, properties.occurrences_count);
     EXPECT_EQ(deserialized.document_count, properties.document_count);
@@ -128,6 +129,7 @@ TEST_F(PropertiesTest, write)
     }
 
     // then
+    EXPECT_EQ(written["version"], irk::index::Properties::current_version);
     EXPECT_EQ(written["skip_block_size"], jprop["skip_block_size"]);
     EXPECT_EQ(written["occurrences"], jprop["occurrences"]);
     EXPECT_EQ(written["documents"], jprop["documents"]);
@@ -147,6 +149,13 @@ TEST_F(PropertiesTest, write)
         jprop["quantized_scores"]["bm25-8"]["max"]);
 }
 
+TEST_F(PropertiesTest, unsupported_version)
+{
+    auto jprop = nlohmann::json::parse(serialized);
+    jprop["version"] = irk::index::Properties::current_version + 1;
+    EXPECT_THROW(irk::index::Properties::read(jprop), std::runtime_error);
+}
+
 }  // namespace
 
 int main(int argc, char** argv)
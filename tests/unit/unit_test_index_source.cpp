@@ -30,8 +30,11 @@
 
 #include <boost/filesystem.hpp>
 #include <catch2/catch.hpp>
+#include <irkit/index/convert.hpp>
+#include <irkit/index/packed.hpp>
 #include <irkit/index/source.hpp>
 #include <irkit/io.hpp>
+#include <irkit/query_engine.hpp>
 
 #include "common.hpp"
 
@@ -159,3 +162,454 @@ TEST_CASE("Inverted_Index_Mapped_Source", "[inverted_index][unit]")
         }
     }
 }
+
+TEST_CASE("Term info records", "[inverted_index][unit]")
+{
+    GIVEN("test index")
+    {
+        auto dir = irk::test::tmpdir();
+        irk::test::build_test_index(dir);
+        auto source = irtl::value(irk::Inverted_Index_Mapped_Source::from(dir, {"bm25-8"}));
+        REQUIRE(source->term_info_view().has_value());
+        REQUIRE(source->score_term_info_views().count("bm25-8") == 1);
+
+        WHEN("index opened with and without term info")
+        {
+            auto legacy_source = std::make_shared<irk::Inverted_Index_Mapped_Source>(*source);
+            legacy_source->term_info.reset();
+            legacy_source->score_term_info_.clear();
+            std::shared_ptr<irk::Inverted_Index_Mapped_Source const> legacy_ptr = legacy_source;
+            irk::inverted_index_view index(source);
+            irk::inverted_index_view legacy(legacy_ptr);
+            THEN("both return the same term data")
+            {
+                REQUIRE(index.term_count() == legacy.term_count());
+                for (auto term = 0; term < index.term_count(); ++term) {
+                    REQUIRE(index.term_collection_frequency(term)
+                            == legacy.term_collection_frequency(term));
+                    REQUIRE(index.term_occurrences(term) == legacy.term_occurrences(term));
+                    REQUIRE(index.max_score(term, "bm25-8") == legacy.max_score(term, "bm25-8"));
+                    auto documents = index.documents(term);
+                    auto legacy_documents = legacy.documents(term);
+                    REQUIRE(std::vector<irk::index::document_t>(documents.begin(),
+                                                                documents.end())
+                            == std::vector<irk::index::document_t>(legacy_documents.begin(),
+                                                                   legacy_documents.end()));
+                    auto counts = index.frequencies(term);
+                    auto legacy_counts = legacy.frequencies(term);
+                    REQUIRE(std::vector<irk::index::frequency_t>(counts.begin(), counts.end())
+                            == std::vector<irk::index::frequency_t>(legacy_counts.begin(),
+                                                                    legacy_counts.end()));
+                    auto scores = index.scores(term);
+                    auto legacy_scores = legacy.scores(term);
+                    REQUIRE(std::vector<std::uint32_t>(scores.begin(), scores.end())
+                            == std::vector<std::uint32_t>(legacy_scores.begin(),
+                                                          legacy_scores.end()));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Term hash dictionary", "[inverted_index][unit]")
+{
+    GIVEN("test index")
+    {
+        auto dir = irk::test::tmpdir();
+        irk::test::build_test_index(dir, false, false);
+        auto source = irtl::value(irk::Inverted_Index_Mapped_Source::from(dir));
+        REQUIRE(source->term_hash_view().has_value());
+
+        WHEN("index opened with and without the hash dictionary")
+        {
+            auto lexicon_source = std::make_shared<irk::Inverted_Index_Mapped_Source>(*source);
+            lexicon_source->term_hash.reset();
+            std::shared_ptr<irk::Inverted_Index_Mapped_Source const> lexicon_ptr = lexicon_source;
+            irk::inverted_index_view index(source);
+            irk::inverted_index_view lexicon_index(lexicon_ptr);
+            THEN("both resolve the same term IDs")
+            {
+                for (auto term_id = 0; term_id < index.term_count(); ++term_id) {
+                    auto term = index.term(term_id);
+                    REQUIRE(index.term_id(term) == std::make_optional(term_id));
+                    REQUIRE(lexicon_index.term_id(term) == std::make_optional(term_id));
+                }
+                REQUIRE(index.term_id("nonexistent") == std::nullopt);
+                REQUIRE(lexicon_index.term_id("nonexistent") == std::nullopt);
+            }
+        }
+    }
+}
+
+TEST_CASE("Title table", "[inverted_index][unit]")
+{
+    GIVEN("test index")
+    {
+        auto dir = irk::test::tmpdir();
+        irk::test::build_test_index(dir, false, false);
+        auto source = irtl::value(irk::Inverted_Index_Mapped_Source::from(dir));
+        REQUIRE(source->title_table_view().has_value());
+
+        WHEN("index opened with and without the title table")
+        {
+            auto lexicon_source = std::make_shared<irk::Inverted_Index_Mapped_Source>(*source);
+            lexicon_source->title_table.reset();
+            std::shared_ptr<irk::Inverted_Index_Mapped_Source const> lexicon_ptr = lexicon_source;
+            irk::inverted_index_view index(source);
+            irk::inverted_index_view lexicon_index(lexicon_ptr);
+            THEN("both resolve the same titles")
+            {
+                for (auto doc = 0; doc < index.collection_size(); ++doc) {
+                    REQUIRE(index.title(doc) == index.titles().key_at(doc));
+                    REQUIRE(lexicon_index.title(doc) == index.titles().key_at(doc));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Prefix term IDs", "[inverted_index][unit]")
+{
+    GIVEN("test index")
+    {
+        auto dir = irk::test::tmpdir();
+        irk::test::build_test_index(dir, false, false);
+        auto source = irtl::value(irk::Inverted_Index_Mapped_Source::from(dir));
+        irk::inverted_index_view index(source);
+        WHEN("resolving the prefixes of all terms")
+        {
+            THEN("the returned intervals contain exactly the matching terms")
+            {
+                for (auto term_id = 0; term_id < index.term_count(); ++term_id) {
+                    auto term = index.term(term_id);
+                    for (std::size_t len = 0; len <= term.size(); ++len) {
+                        auto prefix = term.substr(0, len);
+                        auto [first, last] = index.prefix_term_ids(prefix);
+                        REQUIRE(first <= term_id);
+                        REQUIRE(term_id < last);
+                        int matching = 0;
+                        for (auto id = 0; id < index.term_count(); ++id) {
+                            if (index.term(id).compare(0, len, prefix) == 0) {
+                                ++matching;
+                            }
+                        }
+                        REQUIRE(last - first == matching);
+                        REQUIRE(irk::prefix_postings(index, prefix).size()
+                                == static_cast<std::size_t>(matching));
+                    }
+                }
+                auto [first, last] = index.term_id_range("", "\x7f");
+                REQUIRE(first == 0);
+                REQUIRE(last == index.term_count());
+            }
+        }
+    }
+}
+
+TEST_CASE("Document sizes", "[inverted_index][unit]")
+{
+    GIVEN("test index")
+    {
+        auto dir = irk::test::tmpdir();
+        irk::test::build_test_index(dir, false, false);
+        auto source = irtl::value(irk::Inverted_Index_In_Memory_Source::from(dir));
+        auto expected = irk::load_compact_table<std::int32_t>(irk::index::doc_sizes_path(dir))
+                            .to_vector();
+
+        WHEN("index opened with bit-packed and with legacy block-compressed sizes")
+        {
+            auto legacy_source = std::make_shared<irk::Inverted_Index_In_Memory_Source>(*source);
+            std::ostringstream legacy_sizes;
+            legacy_sizes << irk::build_compact_table<std::int32_t>(expected);
+            auto legacy_bytes = legacy_sizes.str();
+            legacy_source->document_sizes.assign(legacy_bytes.begin(), legacy_bytes.end());
+            std::shared_ptr<irk::Inverted_Index_In_Memory_Source const> legacy_ptr = legacy_source;
+            irk::inverted_index_view index(source);
+            irk::inverted_index_view legacy(legacy_ptr);
+            THEN("sizes are read in place and match the legacy format")
+            {
+                REQUIRE(index.document_sizes().is_random_access());
+                REQUIRE_FALSE(legacy.document_sizes().is_random_access());
+                REQUIRE(index.collection_size() == static_cast<std::ptrdiff_t>(expected.size()));
+                REQUIRE(legacy.collection_size() == index.collection_size());
+                for (auto doc = 0; doc < index.collection_size(); ++doc) {
+                    REQUIRE(index.document_size(doc) == expected[doc]);
+                    REQUIRE(legacy.document_size(doc) == expected[doc]);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Warmup", "[inverted_index][unit]")
+{
+    using irk::index::Warmup_Mode;
+    GIVEN("test index")
+    {
+        auto dir = irk::test::tmpdir();
+        irk::test::build_test_index(dir, false, false);
+        auto source = irtl::value(irk::Inverted_Index_Mapped_Source::from(dir));
+        auto mode = GENERATE(Warmup_Mode::Lazy,
+                             Warmup_Mode::Populate,
+                             Warmup_Mode::Will_Need,
+                             Warmup_Mode::Huge_Pages);
+        WHEN("metadata is warmed up with mode " << mode)
+        {
+            source->warm_up(irk::index::Warmup_Policy{Warmup_Mode::Lazy, mode});
+            THEN("the index reads the same data")
+            {
+                irk::inverted_index_view index(source);
+                for (auto term_id = 0; term_id < index.term_count(); ++term_id) {
+                    REQUIRE(index.term_id(index.term(term_id)) == std::make_optional(term_id));
+                }
+            }
+        }
+    }
+    GIVEN("warmup mode names")
+    {
+        for (auto mode : {Warmup_Mode::Lazy,
+                          Warmup_Mode::Populate,
+                          Warmup_Mode::Will_Need,
+                          Warmup_Mode::Lock,
+                          Warmup_Mode::Huge_Pages}) {
+            std::ostringstream name;
+            name << mode;
+            REQUIRE(irk::index::parse_warmup_mode(name.str()).value() == mode);
+        }
+        REQUIRE_FALSE(irk::index::parse_warmup_mode("eager").has_value());
+    }
+}
+
+TEST_CASE("Packed index", "[inverted_index][unit]")
+{
+    GIVEN("test index packed into a single file")
+    {
+        auto dir = irk::test::tmpdir();
+        irk::test::build_test_index(dir);
+        auto alignment = GENERATE(64u, 4096u);
+        irk::index::pack_index(dir, irk::index::packed_index_path(dir), alignment);
+
+        WHEN("packed source created")
+        {
+            auto source = irtl::value(irk::Packed_Index_Source::from(dir, {"bm25-8"}));
+            auto mapped = irtl::value(irk::Inverted_Index_Mapped_Source::from(dir, {"bm25-8"}));
+            THEN("sections are aligned and hold the files")
+            {
+                for (auto const& view : {source->documents_view(),
+                                         source->counts_view(),
+                                         source->term_map_view(),
+                                         source->properties_view()}) {
+                    REQUIRE(reinterpret_cast<std::uintptr_t>(view.data()) % alignment == 0);
+                }
+                REQUIRE(to_vector(source->documents_view()) == load(irk::index::doc_ids_path(dir)));
+                REQUIRE(to_vector(source->document_sizes_view())
+                        == load(irk::index::doc_sizes_path(dir)));
+                REQUIRE(to_vector(source->term_hash_view().value())
+                        == load(irk::index::term_hash_path(dir)));
+                REQUIRE(to_vector(source->score_stats_views()["bm25"].max.value())
+                        == load(dir / "bm25.max"));
+                auto scores = source->scores_source("bm25-8").value();
+                REQUIRE(to_vector(scores.postings) == load(dir / "bm25-8.scores"));
+                REQUIRE(source->verify().has_value());
+            }
+            THEN("index reads the same postings as the mapped one")
+            {
+                irk::inverted_index_view packed_index(source);
+                irk::inverted_index_view index(mapped);
+                REQUIRE(packed_index.term_count() == index.term_count());
+                REQUIRE(packed_index.collection_size() == index.collection_size());
+                for (auto term_id = 0; term_id < index.term_count(); ++term_id) {
+                    REQUIRE(packed_index.term(term_id) == index.term(term_id));
+                    auto actual = packed_index.postings(term_id).begin();
+                    for (auto const& posting : index.postings(term_id)) {
+                        REQUIRE(actual->document() == posting.document());
+                        REQUIRE(actual->payload() == posting.payload());
+                        ++actual;
+                    }
+                }
+            }
+            THEN("posting ranges point into the packed file")
+            {
+                irk::inverted_index_view packed_index(source);
+                irk::inverted_index_view index(mapped);
+                auto packed = load(irk::index::packed_index_path(dir));
+                for (auto term_id = 0; term_id < index.term_count(); ++term_id) {
+                    auto ranges = packed_index.posting_ranges(term_id);
+                    auto loose_ranges = index.posting_ranges(term_id);
+                    REQUIRE(ranges.size() == loose_ranges.size());
+                    for (std::size_t idx = 0; idx < ranges.size(); ++idx) {
+                        REQUIRE(ranges[idx].file == irk::index::packed_index_path(dir));
+                        REQUIRE(ranges[idx].size == loose_ranges[idx].size);
+                        auto loose = load(loose_ranges[idx].file);
+                        REQUIRE(std::equal(packed.begin() + ranges[idx].offset,
+                                           packed.begin() + ranges[idx].offset + ranges[idx].size,
+                                           loose.begin() + loose_ranges[idx].offset));
+                    }
+                }
+            }
+            THEN("unknown scores are reported")
+            {
+                REQUIRE_FALSE(irk::Packed_Index_Source::from(dir, {"bm25-16"}).has_value());
+            }
+        }
+
+        WHEN("a section is corrupted")
+        {
+            auto packed = load(irk::index::packed_index_path(dir));
+            auto sections = irk::index::read_section_table(irk::make_memory_view(packed));
+            auto doc_ids = std::find_if(sections.begin(), sections.end(), [](auto const& s) {
+                return s.name == "doc.id";
+            });
+            REQUIRE(doc_ids != sections.end());
+            {
+                std::fstream file(irk::index::packed_index_path(dir).c_str(),
+                                  std::ios::in | std::ios::out | std::ios::binary);
+                file.seekp(doc_ids->offset);
+                file.put(~load(irk::index::doc_ids_path(dir))[0]);
+            }
+            THEN("verification names the section")
+            {
+                auto source = irtl::value(irk::Packed_Index_Source::from(dir));
+                auto result = source->verify();
+                REQUIRE_FALSE(result.has_value());
+                REQUIRE(result.error() == "Corrupted sections: doc.id");
+            }
+        }
+
+        WHEN("a file is rewritten after packing")
+        {
+            {
+                std::ofstream out(irk::index::properties_path(dir).c_str(), std::ios::app);
+                out << '\n';
+            }
+            THEN("the pack is rejected")
+            {
+                REQUIRE_THROWS_WITH(
+                    irk::Packed_Index_Source::from(dir),
+                    "Packed index is older than its files; pack it again: properties.json");
+            }
+        }
+    }
+}
+
+TEST_CASE("Convert packed index", "[inverted_index][unit]")
+{
+    GIVEN("a packed test index")
+    {
+        auto dir = irk::test::tmpdir();
+        irk::test::build_test_index(dir, true, false);
+        irk::index::pack_index(dir, irk::index::packed_index_path(dir));
+
+        WHEN("its lists are converted")
+        {
+            auto output_dir = irk::test::tmpdir();
+            irk::index::convert_lists(dir, output_dir);
+
+            THEN("the stale pack is not copied")
+            {
+                REQUIRE_FALSE(boost::filesystem::exists(irk::index::packed_index_path(output_dir)));
+            }
+            THEN("queries return the same results as on the packed index")
+            {
+                auto packed = irtl::value(irk::Packed_Index_Source::from(dir, {"bm25-8"}));
+                auto converted = irtl::value(
+                    irk::Inverted_Index_Mapped_Source::from(output_dir, {"bm25-8"}));
+                irk::inverted_index_view packed_index(packed);
+                irk::inverted_index_view converted_index(converted);
+                auto score_function = GENERATE(std::string("bm25"), std::string("bm25-8"));
+                auto run = [&](irk::inverted_index_view const& index) {
+                    std::vector<std::pair<int, std::string>> results;
+                    auto engine = irk::Query_Engine::from(
+                        index, true, score_function, irk::Traversal_Type::DAAT,
+                        std::optional<int>{}, "null");
+                    std::vector<std::string> query{"ipsum", "dolor"};
+                    engine.run_query(query, 5).print([&](auto, auto doc, auto score) {
+                        std::ostringstream os;
+                        os << score;
+                        results.emplace_back(doc, os.str());
+                    });
+                    return results;
+                };
+                auto expected = run(packed_index);
+                REQUIRE(expected.size() == 5);
+                REQUIRE(run(converted_index) == expected);
+            }
+            THEN("a pack copied next to the converted lists is rejected")
+            {
+                boost::filesystem::copy_file(irk::index::packed_index_path(dir),
+                                             irk::index::packed_index_path(output_dir));
+                REQUIRE_THROWS(irk::Packed_Index_Source::from(output_dir, {"bm25-8"}));
+            }
+        }
+    }
+}
+
+TEST_CASE("Disk source", "[inverted_index][unit]")
+{
+    GIVEN("test index")
+    {
+        auto dir = irk::test::tmpdir();
+        irk::test::build_test_index(dir);
+        auto block_size = GENERATE(64u, 4096u);
+        auto cache = std::make_shared<irk::block_cache>(4 * block_size, block_size, 2);
+        auto source = irtl::value(irk::Inverted_Index_Disk_Source::from(dir, cache, {"bm25-8"}));
+        auto mapped = irtl::value(irk::Inverted_Index_Mapped_Source::from(dir, {"bm25-8"}));
+        source->warm_up({irk::index::Warmup_Mode::Populate, irk::index::Warmup_Mode::Populate});
+
+        WHEN("postings are read through the cache")
+        {
+            irk::inverted_index_view disk_index(source);
+            irk::inverted_index_view index(mapped);
+            for (auto term_id = 0; term_id < index.term_count(); ++term_id) {
+                auto actual = disk_index.postings(term_id).begin();
+                for (auto const& posting : index.postings(term_id)) {
+                    REQUIRE(actual->document() == posting.document());
+                    REQUIRE(actual->payload() == posting.payload());
+                    ++actual;
+                }
+                auto actual_score = disk_index.scored_postings(term_id).begin();
+                for (auto const& posting : index.scored_postings(term_id)) {
+                    REQUIRE(actual_score->payload() == posting.payload());
+                    ++actual_score;
+                }
+            }
+            THEN("the cache stays within its capacity and records its hits")
+            {
+                auto stats = source->cache().statistics();
+                REQUIRE(stats.misses > 0);
+                REQUIRE(stats.hits > 0);
+                REQUIRE(stats.misses - stats.evictions <= 4);
+            }
+        }
+
+        WHEN("postings are prefetched into a cache large enough to hold them")
+        {
+            auto large_cache = std::make_shared<irk::block_cache>(1 << 20, block_size, 2);
+            auto prefetched_source = irtl::value(
+                irk::Inverted_Index_Disk_Source::from(dir, large_cache, {"bm25-8"}));
+            irk::inverted_index_view index(prefetched_source);
+            {
+                irk::block_prefetcher prefetcher;
+                for (auto term_id = 0; term_id < index.term_count(); ++term_id) {
+                    for (auto const& range : index.posting_ranges(term_id)) {
+                        prefetched_source->prefetch(prefetcher, range);
+                    }
+                }
+            }
+            THEN("no posting list is read synchronously")
+            {
+                for (auto term_id = 0; term_id < index.term_count(); ++term_id) {
+                    for (auto const& posting : index.scored_postings(term_id)) {
+                        REQUIRE(posting.payload() >= 0);
+                    }
+                    for (auto const& posting : index.postings(term_id)) {
+                        REQUIRE(posting.payload() > 0);
+                    }
+                }
+                auto stats = large_cache->statistics();
+                REQUIRE(stats.prefetched > 0);
+                REQUIRE(stats.misses == 0);
+            }
+        }
+    }
+}
@@ -26,6 +26,8 @@
 
 #define CATCH_CONFIG_MAIN
 
+#include <fstream>
+#include <iterator>
 #include <sstream>
 
 #include <boost/filesystem.hpp>
@@ -67,3 +69,49 @@ TEST_CASE("Merge sizes", "[merger]")
         }
     }
 }
+
+TEST_CASE("Parallel assembly", "[merger]")
+{
+    namespace fs = boost::filesystem;
+    std::ostringstream collection;
+    for (int doc = 0; doc < 1000; ++doc) {
+        collection << "Doc" << doc;
+        for (int term = 0; term < doc % 17 + 1; ++term) {
+            collection << " t" << (doc * 31 + term * 7) % 113;
+        }
+        collection << '\n';
+    }
+    std::unordered_set<std::string> spam{"Doc3", "Doc77", "Doc500"};
+
+    auto build = [&](int threads) {
+        auto dir = fs::temp_directory_path() / fs::unique_path();
+        irk::index::index_assembler assembler(
+            dir, 64, 4, 16, spam, ir::Block_List_Options{}, threads);
+        std::istringstream input(collection.str());
+        assembler.assemble(input);
+        return dir;
+    };
+    auto read = [](const fs::path& file) {
+        std::ifstream in(file.c_str(), std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+
+    auto sequential = build(1);
+    auto parallel = build(4);
+    int files = 0;
+    for (auto it = fs::recursive_directory_iterator(sequential);
+         it != fs::recursive_directory_iterator();
+         ++it) {
+        if (not fs::is_regular_file(it->path())) { continue; }
+        auto relative = fs::relative(it->path(), sequential);
+        INFO(relative.string());
+        REQUIRE(fs::exists(parallel / relative));
+        REQUIRE(read(it->path()) == read(parallel / relative));
+        ++files;
+    }
+    REQUIRE(files > 0);
+    REQUIRE(fs::exists(sequential / ".batches" / "15"));
+    REQUIRE_FALSE(fs::exists(sequential / ".batches" / "16"));
+    fs::remove_all(sequential);
+    fs::remove_all(parallel);
+}
@@ -25,15 +25,20 @@
 //! \copyright MIT License
 
 #include <algorithm>
+#include <numeric>
+#include <random>
 #include <sstream>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <irkit/coding/bitpacking.hpp>
 #include <irkit/coding/vbyte.hpp>
+#include <irkit/compacttable.hpp>
 #include <irkit/coding/stream_vbyte.hpp>
 #include <irkit/index/types.hpp>
+#include <irkit/list/standard_block_list.hpp>
 #include <irkit/memoryview.hpp>
 
 using irk::literals::operator""_id;
@@ -107,6 +112,182 @@ TEST(vbyte, document)
     ASSERT_THAT(actual, ::testing::ElementsAreArray(values));
 }
 
+std::vector<std::uint32_t> mixed_width_values(int count)
+{
+    std::mt19937 gen(17);
+    std::vector<std::uint32_t> values(count);
+    for (auto& value : values) {
+        int bits = gen() % 33;
+        value = bits == 0 ? 0 : gen() >> (32 - bits);
+    }
+    return values;
+}
+
+TEST(vbyte, bulk_decode)
+{
+    irk::vbyte_codec<std::uint32_t> codec;
+    for (int count : {0, 1, 15, 16, 17, 100, 1000}) {
+        auto values = mixed_width_values(count);
+        std::vector<char> buffer(codec.max_encoded_size(count));
+        auto size = codec.encode(
+            std::begin(values), std::end(values), std::begin(buffer));
+        std::vector<std::uint32_t> actual(count);
+        auto end = codec.decode(buffer.data(), actual.data(), count);
+        ASSERT_EQ(end - buffer.data(), size);
+        ASSERT_THAT(actual, ::testing::ElementsAreArray(values));
+        std::vector<std::uint64_t> wide(count);
+        codec.decode(buffer.data(), wide.data(), count);
+        ASSERT_THAT(wide, ::testing::ElementsAreArray(values));
+    }
+}
+
+TEST(vbyte, bulk_delta_decode)
+{
+    irk::vbyte_codec<std::uint32_t> codec;
+    auto values = mixed_width_values(1000);
+    for (auto& value : values) { value %= 300; }
+    std::partial_sum(values.begin(), values.end(), values.begin());
+    std::vector<char> buffer(codec.max_encoded_size(values.size()));
+    auto size = codec.delta_encode(
+        std::begin(values), std::end(values), std::begin(buffer), 7u);
+    std::vector<std::uint32_t> actual(values.size());
+    auto end = codec.delta_decode(
+        buffer.data(), actual.data(), values.size(), 7u);
+    ASSERT_EQ(end - buffer.data(), size);
+    ASSERT_THAT(actual, ::testing::ElementsAreArray(values));
+}
+
+//! A vbyte codec counting whether bulk decoding is called with iterators
+//! that take the vectorized path.
+struct recording_vbyte_codec : irk::vbyte_codec<std::uint32_t> {
+    using base_type = irk::vbyte_codec<std::uint32_t>;
+    using base_type::decode;
+
+    static inline int bulk_calls = 0;
+    static inline int scalar_calls = 0;
+
+    template<class InputIterator, class OutputIterator>
+    static void record()
+    {
+        if (is_bulk_decodable<InputIterator, OutputIterator>()) {
+            ++bulk_calls;
+        } else {
+            ++scalar_calls;
+        }
+    }
+
+    template<class InputIterator, class OutputIterator>
+    InputIterator decode(InputIterator in, OutputIterator out, int n) const
+    {
+        record<InputIterator, OutputIterator>();
+        return base_type::decode(in, out, n);
+    }
+
+    template<class InputIterator, class OutputIterator>
+    InputIterator delta_decode(
+        InputIterator in, OutputIterator out, int n, std::uint32_t initial = 0) const
+    {
+        record<InputIterator, OutputIterator>();
+        return base_type::delta_decode(in, out, n, initial);
+    }
+};
+
+TEST(vbyte, bulk_decode_in_block_list)
+{
+    auto values = mixed_width_values(1000);
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    for (bool delta : {true, false}) {
+        auto decode_all = [&](auto list) {
+            return std::vector<std::uint32_t>(list.begin(), list.end());
+        };
+        std::ostringstream out;
+        if (delta) {
+            ir::Standard_Block_List_Builder<std::uint32_t, recording_vbyte_codec, true>
+                builder(64);
+            for (auto value : values) { builder.add(value); }
+            builder.write(out);
+        } else {
+            ir::Standard_Block_List_Builder<std::uint32_t, recording_vbyte_codec, false>
+                builder(64);
+            for (auto value : values) { builder.add(value); }
+            builder.write(out);
+        }
+        auto data = out.str();
+        auto memory = irk::make_memory_view(data.data(), data.size());
+        recording_vbyte_codec::bulk_calls = 0;
+        recording_vbyte_codec::scalar_calls = 0;
+        auto actual = delta
+            ? decode_all(ir::Standard_Block_List<std::uint32_t, recording_vbyte_codec, true>(
+                0, memory, values.size()))
+            : decode_all(ir::Standard_Block_List<std::uint32_t, recording_vbyte_codec, false>(
+                0, memory, values.size()));
+        ASSERT_THAT(actual, ::testing::ElementsAreArray(values));
+        ASSERT_GT(recording_vbyte_codec::bulk_calls, 0);
+        ASSERT_EQ(recording_vbyte_codec::scalar_calls, 0);
+    }
+}
+
+TEST(vbyte, bulk_decode_in_compact_table)
+{
+    auto values = mixed_width_values(1000);
+    for (bool delta : {true, false}) {
+        if (delta) { std::partial_sum(values.begin(), values.end(), values.begin()); }
+        auto table = irk::build_compact_table<std::uint32_t, recording_vbyte_codec>(
+            values, delta, 64);
+        std::ostringstream out;
+        out << table;
+        auto data = out.str();
+        irk::compact_table<std::uint32_t, recording_vbyte_codec, irk::memory_view> view(
+            irk::make_memory_view(data.data(), data.size()));
+        recording_vbyte_codec::bulk_calls = 0;
+        recording_vbyte_codec::scalar_calls = 0;
+        for (std::size_t idx = 0; idx < values.size(); ++idx) {
+            ASSERT_EQ(view[idx], values[idx]);
+        }
+        ASSERT_GT(recording_vbyte_codec::bulk_calls, 0);
+        ASSERT_EQ(recording_vbyte_codec::scalar_calls, 0);
+    }
+}
+
+TEST(bitpacking, int)
+{
+    irk::bitpacking_codec<int> codec;
+    std::vector<int> values = {0, 3, 7, 3, 18, 99, 123456, 1};
+    std::vector<int> actual(values.size());
+    std::vector<char> buffer(codec.max_encoded_size(values.size()));
+    auto size = codec.encode(std::begin(values), std::end(values), std::begin(buffer));
+    ASSERT_EQ(size, 1 + (values.size() * 17 + 7) / 8);
+    codec.decode(std::begin(buffer), std::begin(actual), values.size());
+    ASSERT_THAT(actual, ::testing::ElementsAreArray(values));
+}
+
+TEST(bitpacking, zero_width)
+{
+    irk::bitpacking_codec<int> codec;
+    std::vector<int> values(10, 0);
+    std::vector<int> actual(values.size(), 1);
+    std::vector<char> buffer(codec.max_encoded_size(values.size()));
+    auto size = codec.encode(std::begin(values), std::end(values), std::begin(buffer));
+    ASSERT_EQ(size, 1);
+    codec.decode(std::begin(buffer), std::begin(actual), values.size());
+    ASSERT_THAT(actual, ::testing::ElementsAreArray(values));
+}
+
+TEST(bitpacking, delta)
+{
+    irk::bitpacking_codec<irk::index::document_t> codec;
+    std::vector<irk::index::document_t> values = {
+        10_id, 11_id, 12_id, 14_id, 18_id, 19_id, 23_id};
+    std::vector<irk::index::document_t> actual(values.size());
+    std::vector<char> buffer(codec.max_encoded_size(values.size()));
+    auto size = codec.delta_encode(
+        std::begin(values), std::end(values), std::begin(buffer), 8_id);
+    ASSERT_EQ(size, 1 + (values.size() * 3 + 7) / 8);
+    codec.delta_decode(std::begin(buffer), std::begin(actual), values.size(), 8_id);
+    ASSERT_THAT(actual, ::testing::ElementsAreArray(values));
+}
+
 }  // namespace
 
 int main(int argc, char** argv)
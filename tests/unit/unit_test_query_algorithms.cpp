@@ -212,3 +212,27 @@ TEST_CASE("DAAT", "[query_algorithm]")
         }
     }
 }
+
+TEST_CASE("Union of posting lists", "[query_algorithm]")
+{
+    GIVEN("Unscored posting lists")
+    {
+        const auto postings = unscored_postings();
+        std::vector<std::pair<int, int>> expected{
+            {0, 1}, {2, 4}, {3, 3}, {6, 3}, {12, 4}};
+        auto collection_size = GENERATE(20, 10000);
+        WHEN("Merged in a collection of " << collection_size << " documents")
+        {
+            auto merged =
+                irk::union_postings(gsl::make_span(postings), collection_size);
+            THEN("Documents are unique and sorted, with summed payloads")
+            {
+                std::vector<std::pair<int, int>> actual;
+                for (const auto& posting : merged) {
+                    actual.emplace_back(posting.document(), posting.payload());
+                }
+                REQUIRE(actual == expected);
+            }
+        }
+    }
+}
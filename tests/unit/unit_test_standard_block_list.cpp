@@ -26,10 +26,15 @@
 
 #define CATCH_CONFIG_MAIN
 
+#include <cstring>
 #include <functional>
+#include <numeric>
+#include <set>
 
 #include <catch2/catch.hpp>
 
+#include <irkit/coding/adaptive.hpp>
+#include <irkit/coding/bitpacking.hpp>
 #include <irkit/index/types.hpp>
 #include <irkit/iterator/block_iterator.hpp>
 #include <irkit/list/standard_block_list.hpp>
@@ -41,6 +46,7 @@ using ir::Standard_Block_Document_List;
 using ir::Standard_Block_List;
 using ir::Standard_Block_List_Builder;
 using ir::Standard_Block_Payload_List;
+using ir::Unaligned_Span;
 using ir::Vector_Block_List;
 using irk::index::document_t;
 
@@ -60,7 +66,12 @@ TEST_CASE("Standard_Block_List", "[blocked][inverted_list]")
     SECTION("size") { REQUIRE(list.size() == 8); }
     SECTION("block count") { REQUIRE(list.block_count() == 3); }
     SECTION("term ID") { REQUIRE(list.term_id() == 0); }
-    SECTION("upper bounds") { REQUIRE(list.upper_bounds() == std::vector<int>{6, 14, 23}); }
+    SECTION("upper bounds")
+    {
+        auto upper_bounds = list.upper_bounds();
+        REQUIRE(std::vector<int>(upper_bounds.begin(), upper_bounds.end())
+                == std::vector<int>{6, 14, 23});
+    }
 
     SECTION("block size")
     {
@@ -190,6 +201,339 @@ TEST_CASE("Standard_Block_List_Builder", "[blocked][inverted_list][builder]")
     }
 }
 
+TEST_CASE("Adaptive Standard_Block_List", "[blocked][inverted_list][builder]")
+{
+    using codec_type = irk::adaptive_codec<int, irk::vbyte_codec<int>, irk::bitpacking_codec<int>>;
+
+    auto write = [](auto& builder, auto const& values) {
+        for (auto v : values) {
+            builder.add(v);
+        }
+        std::ostringstream os;
+        builder.write(os);
+        return os.str();
+    };
+
+    SECTION("Sparse documents use the primary codec and a regular header")
+    {
+        std::vector<int> documents = {3, 1000, 250000, 251000, 9000000};
+        Standard_Block_List_Builder<int, codec_type, true> builder{2};
+        Standard_Block_List_Builder<int, irk::vbyte_codec<int>, true> vbyte_builder{2};
+        auto data = write(builder, documents);
+        REQUIRE(data == write(vbyte_builder, documents));
+        Standard_Block_List<int, codec_type, true> list{
+            0, irk::make_memory_view(data.data(), data.size()), 5};
+        REQUIRE(list.format().codec_tag == 0);
+        REQUIRE(std::vector<int>(list.begin(), list.end()) == documents);
+    }
+
+    SECTION("Dense documents use bit packing")
+    {
+        std::vector<int> documents;
+        for (int doc = 0; doc < 1000; doc += 1 + doc % 3) {
+            documents.push_back(doc);
+        }
+        Standard_Block_List_Builder<int, codec_type, true> builder{128};
+        auto data = write(builder, documents);
+        Standard_Block_List<int, codec_type, true> list{
+            0, irk::make_memory_view(data.data(), data.size()), static_cast<std::int32_t>(documents.size())};
+        REQUIRE(list.format().codec_tag == 1);
+        REQUIRE(std::vector<int>(list.begin(), list.end()) == documents);
+        auto doc = GENERATE(0, 1, 3, 500, 998);
+        auto expected = std::lower_bound(documents.begin(), documents.end(), doc);
+        REQUIRE(*list.lookup(doc) == *expected);
+    }
+
+    SECTION("Small payloads use bit packing")
+    {
+        std::vector<int> payloads(300, 1);
+        payloads[7] = 3;
+        Standard_Block_List_Builder<int, codec_type, false> builder{128};
+        auto data = write(builder, payloads);
+        Standard_Block_List<int, codec_type, false> list{
+            0, irk::make_memory_view(data.data(), data.size()), static_cast<std::int32_t>(payloads.size())};
+        REQUIRE(list.format().codec_tag == 1);
+        REQUIRE(std::vector<int>(list.begin(), list.end()) == payloads);
+    }
+
+    SECTION("Slack prefers faster codecs")
+    {
+        std::vector<int> payloads(300, 1);
+        Standard_Block_List_Builder<int, codec_type, false> builder{128, codec_type{100.0}};
+        auto data = write(builder, payloads);
+        Standard_Block_List<int, codec_type, false> list{
+            0, irk::make_memory_view(data.data(), data.size()), static_cast<std::int32_t>(payloads.size())};
+        REQUIRE(list.format().codec_tag == 0);
+        REQUIRE(std::vector<int>(list.begin(), list.end()) == payloads);
+    }
+}
+
+TEST_CASE("Bitmap Standard_Block_List", "[blocked][inverted_list][builder]")
+{
+    using codec_type = irk::vbyte_codec<int>;
+    std::vector<int> documents;
+    std::vector<int> payloads;
+    for (int doc = 100; doc < 1000; doc += 1 + doc % 4) {
+        documents.push_back(doc);
+        payloads.push_back(doc % 7);
+    }
+    auto density = GENERATE(0.0, 0.125, 0.9);
+
+    Standard_Block_List_Builder<int, codec_type, true> builder{16, ir::Block_List_Options{density}};
+    builder.set_document_count(1000);
+    Standard_Block_List_Builder<int, codec_type, false> payload_builder{
+        16, ir::Block_List_Options{density}};
+    for (auto [doc, payload] : iter::zip(documents, payloads)) {
+        builder.add(doc);
+        payload_builder.add(payload);
+    }
+    std::ostringstream os;
+    builder.write(os);
+    std::string data = os.str();
+    std::ostringstream payload_os;
+    payload_builder.write(payload_os);
+    std::string payload_data = payload_os.str();
+
+    Standard_Block_List<int, codec_type, true> list{
+        0, irk::make_memory_view(data.data(), data.size()), static_cast<std::int32_t>(documents.size())};
+    Standard_Block_List<int, codec_type, false> payload_list{
+        0, irk::make_memory_view(payload_data.data(), payload_data.size()), static_cast<std::int32_t>(payloads.size())};
+
+    REQUIRE(list.is_bitmap() == (density == 0.125));
+    REQUIRE_FALSE(payload_list.is_bitmap());
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == documents);
+    REQUIRE(list.upper_bounds()[list.block_count() - 1] == documents.back());
+
+    SECTION("advance_to and align")
+    {
+        auto doc = GENERATE(0, 100, 101, 102, 500, 998, 999);
+        auto pos = std::lower_bound(documents.begin(), documents.end(), doc);
+        auto it = list.lookup(doc);
+        REQUIRE(*it == *pos);
+        auto payload_it = payload_list.begin();
+        payload_it.align(it);
+        REQUIRE(*payload_it == payloads[std::distance(documents.begin(), pos)]);
+    }
+
+    SECTION("contains")
+    {
+        if (list.is_bitmap()) {
+            for (int doc = 0; doc < 1100; ++doc) {
+                bool expected = std::binary_search(documents.begin(), documents.end(), doc);
+                REQUIRE(list.contains(doc) == expected);
+            }
+        }
+    }
+}
+
+template<class Codec>
+auto written_as_bitmap(std::vector<int> const& documents,
+                       std::int64_t document_count,
+                       ir::Block_List_Options options) -> bool
+{
+    Standard_Block_List_Builder<int, Codec, true> builder{64, options};
+    builder.set_document_count(document_count);
+    for (auto doc : documents) {
+        builder.add(doc);
+    }
+    std::ostringstream os;
+    builder.write(os);
+    auto data = os.str();
+    Standard_Block_List<int, Codec, true> list{
+        0, irk::make_memory_view(data.data(), data.size()), static_cast<std::int32_t>(documents.size())};
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == documents);
+    return list.is_bitmap();
+}
+
+TEST_CASE("Bitmaps only for dense lists", "[blocked][inverted_list][builder]")
+{
+    using codec_type = irk::vbyte_codec<int>;
+    auto fixed_width = GENERATE(false, true);
+    ir::Block_List_Options options{0.125, fixed_width};
+
+    SECTION("Short lists")
+    {
+        REQUIRE_FALSE(written_as_bitmap<codec_type>({5}, 10, options));
+        REQUIRE_FALSE(written_as_bitmap<codec_type>({5, 6}, 10, options));
+        REQUIRE_FALSE(written_as_bitmap<codec_type>({5, 6, 7}, 10, options));
+        REQUIRE_FALSE(written_as_bitmap<codec_type>({0, 1, 2, 3, 4, 5, 6, 7}, 8, options));
+    }
+    SECTION("Clustered lists sparse in the collection")
+    {
+        std::vector<int> documents(500);
+        std::iota(documents.begin(), documents.end(), 1000);
+        REQUIRE_FALSE(written_as_bitmap<codec_type>(documents, 100'000, options));
+        REQUIRE(written_as_bitmap<codec_type>(documents, 2000, options));
+    }
+    SECTION("Lists dense in the collection but better gap-coded")
+    {
+        std::vector<int> documents(1000);
+        std::iota(documents.begin(), documents.end(), 0);
+        for (int doc = 1000; doc < 16'000; doc += 15) {
+            documents.push_back(doc);
+        }
+        REQUIRE_FALSE(
+            written_as_bitmap<irk::bitpacking_codec<int>>(documents, 16'000, options));
+    }
+    SECTION("Unknown collection size")
+    {
+        std::vector<int> documents(500);
+        std::iota(documents.begin(), documents.end(), 0);
+        REQUIRE_FALSE(written_as_bitmap<codec_type>(documents, 0, options));
+    }
+}
+
+TEST_CASE("Fixed-width Standard_Block_List", "[blocked][inverted_list][builder]")
+{
+    using codec_type = irk::adaptive_codec<int, irk::vbyte_codec<int>, irk::bitpacking_codec<int>>;
+    std::vector<int> documents;
+    std::vector<int> payloads;
+    for (int doc = 3; doc < 20000; doc += 1 + (doc * 7) % 31) {
+        documents.push_back(doc);
+        payloads.push_back(doc % 5);
+    }
+    auto bitmap = GENERATE(false, true);
+    ir::Block_List_Options options{0.0, true};
+
+    auto write = [](auto builder, auto const& values) {
+        for (auto v : values) {
+            builder.add(v);
+        }
+        std::ostringstream os;
+        builder.write(os);
+        return os.str();
+    };
+    Standard_Block_List_Builder<int, codec_type, true> builder{64, options};
+    builder.set_bitmap(bitmap);
+    auto data = write(builder, documents);
+    auto payload_data = write(Standard_Block_List_Builder<int, codec_type, false>{64, options},
+                              payloads);
+    Standard_Block_List<int, codec_type, true> list{
+        0, irk::make_memory_view(data.data(), data.size()), static_cast<std::int32_t>(documents.size())};
+    Standard_Block_List<int, codec_type, false> payload_list{
+        0, irk::make_memory_view(payload_data.data(), payload_data.size()), static_cast<std::int32_t>(payloads.size())};
+
+    REQUIRE(list.is_fixed_width());
+    REQUIRE(payload_list.is_fixed_width());
+    REQUIRE(list.is_bitmap() == bitmap);
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == documents);
+    REQUIRE(std::vector<int>(payload_list.begin(), payload_list.end()) == payloads);
+
+    auto upper_bounds = list.upper_bounds();
+    REQUIRE(upper_bounds.size() == list.block_count());
+    for (int block = 0; block < list.block_count(); ++block) {
+        auto last = std::min<std::size_t>((block + 1) * 64, documents.size()) - 1;
+        REQUIRE(upper_bounds[block] == documents[last]);
+    }
+
+    auto doc = GENERATE(0, 3, 4, 5000, 19990, 19999);
+    auto pos = std::lower_bound(documents.begin(), documents.end(), doc);
+    auto it = list.lookup(doc);
+    if (pos == documents.end()) {
+        REQUIRE(it == list.end());
+    } else {
+        REQUIRE(*it == *pos);
+        auto payload_it = payload_list.begin();
+        payload_it.align(it);
+        REQUIRE(*payload_it == payloads[std::distance(documents.begin(), pos)]);
+    }
+}
+
+TEST_CASE("Unaligned_Span", "[blocked][inverted_list]")
+{
+    std::vector<int> values{1, 4, 9, 16, 25};
+    auto offset = GENERATE(0, 1, 2, 3);
+    std::vector<char> memory(offset + values.size() * sizeof(int));
+    std::memcpy(&memory[offset], values.data(), values.size() * sizeof(int));
+    Unaligned_Span<int> span(&memory[offset], values.size());
+    static_assert(std::is_same_v<std::iterator_traits<Unaligned_Span<int>::iterator>::iterator_category,
+                                 std::random_access_iterator_tag>);
+
+    REQUIRE(span.size() == 5);
+    REQUIRE(std::vector<int>(span.begin(), span.end()) == values);
+    for (int idx = 0; idx < span.size(); ++idx) {
+        REQUIRE(span[idx] == values[idx]);
+    }
+    REQUIRE(std::distance(span.begin(), std::lower_bound(span.begin(), span.end(), 10)) == 3);
+    REQUIRE(Unaligned_Span<int>(gsl::make_span(values))[4] == 25);
+}
+
+TEST_CASE("Variable-block Standard_Block_List", "[blocked][inverted_list][builder]")
+{
+    using codec_type = irk::bitpacking_codec<int>;
+    std::vector<int> documents;
+    std::vector<int> payloads;
+    int doc = 0;
+    for (int run = 0; run < 40; ++run) {
+        int run_length = 5 + (run * 37) % 150;
+        int gap = run % 3 == 0 ? 1 + (run * 7919) % 5000 : 1 + run % 2;
+        for (int idx = 0; idx < run_length; ++idx) {
+            doc += idx == 0 ? 1000 + run * 13 : gap;
+            documents.push_back(doc);
+            payloads.push_back(1 + (doc * 7) % (run % 4 == 0 ? 1000 : 3));
+        }
+    }
+    auto fixed_width = GENERATE(false, true);
+    ir::Block_List_Options options{0.0, fixed_width, true};
+
+    Standard_Block_List_Builder<int, codec_type, true> builder{64, options};
+    Standard_Block_List_Builder<int, codec_type, true> uniform_builder{
+        64, ir::Block_List_Options{0.0, fixed_width}};
+    Standard_Block_List_Builder<int, codec_type, false> payload_builder{64, options};
+    for (auto doc : documents) {
+        builder.add(doc);
+        uniform_builder.add(doc);
+    }
+    for (auto payload : payloads) {
+        payload_builder.add(payload);
+    }
+    auto block_ends = builder.partition();
+    payload_builder.set_partition(block_ends);
+    std::ostringstream os, uniform_os, payload_os;
+    builder.write(os);
+    uniform_builder.write(uniform_os);
+    payload_builder.write(payload_os);
+    auto data = os.str();
+    auto payload_data = payload_os.str();
+    Standard_Block_List<int, codec_type, true> list{
+        0, irk::make_memory_view(data.data(), data.size()), static_cast<std::int32_t>(documents.size())};
+    Standard_Block_List<int, codec_type, false> payload_list{
+        0, irk::make_memory_view(payload_data.data(), payload_data.size()), static_cast<std::int32_t>(payloads.size())};
+
+    REQUIRE(list.has_variable_blocks());
+    REQUIRE(payload_list.has_variable_blocks());
+    REQUIRE(data.size() < uniform_os.str().size());
+    REQUIRE(std::vector<int>(list.block_ends().begin(), list.block_ends().end()) == block_ends);
+    REQUIRE(std::vector<int>(payload_list.block_ends().begin(), payload_list.block_ends().end())
+            == block_ends);
+    REQUIRE(list.block_count() == static_cast<std::int32_t>(block_ends.size()));
+    REQUIRE(block_ends.back() == static_cast<std::int32_t>(documents.size()));
+    std::set<int> lengths;
+    for (int block = 0; block < list.block_count(); ++block) {
+        int begin = block > 0 ? block_ends[block - 1] : 0;
+        REQUIRE(list.block_size(block) == block_ends[block] - begin);
+        REQUIRE(list.block_size(block) <= 64);
+        REQUIRE(list.upper_bounds()[block] == documents[block_ends[block] - 1]);
+        lengths.insert(list.block_size(block));
+    }
+    REQUIRE(lengths.size() > 2);
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == documents);
+    REQUIRE(std::vector<int>(payload_list.begin(), payload_list.end()) == payloads);
+
+    auto target = GENERATE(0, 1000, 1001, 5000, 60000, 200000, 10000000);
+    auto pos = std::lower_bound(documents.begin(), documents.end(), target);
+    auto it = list.lookup(target);
+    if (pos == documents.end()) {
+        REQUIRE(it == list.end());
+    } else {
+        REQUIRE(*it == *pos);
+        REQUIRE(it.idx() == std::distance(documents.begin(), pos));
+        auto payload_it = payload_list.begin();
+        payload_it.align(it);
+        REQUIRE(*payload_it == payloads[std::distance(documents.begin(), pos)]);
+    }
+}
+
 // Re-enable after fixing #77
 TEST_CASE("Standard_Block_List_Builder from file", "[.][blocked][inverted_list][builder]")
 {
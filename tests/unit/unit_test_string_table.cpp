@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright (c) 2018 Michal Siedlaczek
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+//! \file
+//! \author     Michal Siedlaczek
+//! \copyright  MIT License
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <irkit/memoryview.hpp>
+#include <irkit/string_table.hpp>
+
+namespace {
+
+std::vector<std::string> random_strings(int count)
+{
+    std::mt19937 gen(count);
+    std::uniform_int_distribution<int> length(0, 40);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::vector<std::string> strings;
+    for (int idx = 0; idx < count; ++idx) {
+        std::string str(length(gen), ' ');
+        for (auto& ch : str) { ch = static_cast<char>(letter(gen)); }
+        strings.push_back(str);
+    }
+    return strings;
+}
+
+std::vector<char> serialize(const irk::string_table<std::vector<char>>& table)
+{
+    std::ostringstream out;
+    table.serialize(out);
+    auto str = out.str();
+    return std::vector<char>(str.begin(), str.end());
+}
+
+TEST(string_table, key_at)
+{
+    for (int count : {0, 1, 2, 1000, 20000}) {
+        auto strings = random_strings(count);
+        auto table = irk::build_string_table(strings);
+        ASSERT_EQ(table.size(), count);
+        for (int idx = 0; idx < count; ++idx) {
+            ASSERT_EQ(table.key_at(idx), strings[idx]);
+        }
+    }
+}
+
+TEST(string_table, memory_view)
+{
+    auto strings = random_strings(5000);
+    auto memory = serialize(irk::build_string_table(strings));
+    auto table = irk::load_string_table(irk::make_memory_view(memory));
+    ASSERT_EQ(table.size(), 5000);
+    for (int idx = 0; idx < 5000; ++idx) {
+        ASSERT_EQ(table[idx], strings[idx]);
+    }
+}
+
+TEST(string_table, keys_at)
+{
+    auto strings = random_strings(1000);
+    auto table = irk::build_string_table(strings);
+    std::vector<int> indices = {0, 3, 17, 17, 500, 999};
+    std::vector<std::string_view> resolved;
+    table.keys_at(indices.begin(), indices.end(), std::back_inserter(resolved));
+    std::vector<std::string_view> expected;
+    for (int idx : indices) { expected.push_back(strings[idx]); }
+    ASSERT_THAT(resolved, ::testing::ElementsAreArray(expected));
+}
+
+TEST(string_table, truncated)
+{
+    auto memory = serialize(irk::build_string_table(random_strings(100)));
+    memory.resize(memory.size() - 1);
+    ASSERT_THROW(irk::load_string_table(irk::make_memory_view(memory)),
+                 std::runtime_error);
+    memory.resize(4);
+    ASSERT_THROW(irk::load_string_table(irk::make_memory_view(memory)),
+                 std::runtime_error);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}